@@ -1,10 +1,10 @@
 #version 450
 
-layout(location=0) in vec3 inPos;
-layout(location=1) in vec3 inColor;
-layout(location=2) in vec2 inUV;
-layout(location=3) in float inTexIndex;
-layout(location=4) in vec3 inNormal;
+// Packed ground vertex, see GroundVertex in ChunkMesh.hpp
+layout(location=0) in vec4 inPos;       // SNORM16, chunk-relative / POSITION_RANGE
+layout(location=1) in vec4 inColor;     // RGBA8 UNORM
+layout(location=2) in vec2 inUV;        // Half floats
+layout(location=3) in uvec4 inFaceTex;  // x = face index, y = texture index
 
 layout(location=0) out vec3 vColor;
 layout(location=1) out vec2 vUV;
@@ -27,12 +27,28 @@ layout(set=0, binding=0) uniform UBO {
     float textureCount;
 } ubo;
 
+layout(push_constant) uniform ChunkPush {
+    vec4 chunkOrigin;  // xyz = world-space origin of the packed positions
+} chunk;
+
+// Must match kPackedPositionRange in ChunkMesh.hpp
+const float POSITION_RANGE = 256.0;
+
+const vec3 FACE_NORMALS[6] = vec3[6](
+    vec3(0.0, 0.0, 1.0), vec3(0.0, 0.0, -1.0),
+    vec3(-1.0, 0.0, 0.0), vec3(1.0, 0.0, 0.0),
+    vec3(0.0, 1.0, 0.0), vec3(0.0, -1.0, 0.0)
+);
+
 void main() {
-    vColor = inColor;
+    vec3 localPos = chunk.chunkOrigin.xyz + inPos.xyz * POSITION_RANGE;
+    vec3 normal = FACE_NORMALS[min(inFaceTex.x, 5u)];
+
+    vColor = inColor.rgb;
     vUV = inUV;
-    vWorldPos = (ubo.model * vec4(inPos, 1.0)).xyz;
+    vWorldPos = (ubo.model * vec4(localPos, 1.0)).xyz;
     // Transform normal to world space (assuming no non-uniform scaling)
-    vNormal = normalize((ubo.model * vec4(inNormal, 0.0)).xyz);
-    vTexIndex = int(inTexIndex + 0.5);
-    gl_Position = ubo.proj * ubo.view * ubo.model * vec4(inPos, 1.0);
+    vNormal = normalize((ubo.model * vec4(normal, 0.0)).xyz);
+    vTexIndex = int(inFaceTex.y);
+    gl_Position = ubo.proj * ubo.view * ubo.model * vec4(localPos, 1.0);
 }
@@ -0,0 +1,68 @@
+#version 450
+
+// Instanced building parts: one shared unit box, one instance per part.
+// Produces the same outputs as city.vert so both feed city.frag.
+
+// Unit box: x/z in [-0.5, 0.5], y in [0, 1] (base at the part position)
+layout(location=0) in vec3 inPos;
+layout(location=1) in vec3 inNormal;
+layout(location=2) in vec2 inCorner;    // Face-local corner, 0 or 1 per axis
+
+// Per instance, packed as CityInstance in ChunkMesh.hpp
+layout(location=3) in vec4 inPartPos;    // SNORM16 bottom-center, chunk-relative / POSITION_RANGE
+layout(location=4) in vec4 inPartSize;   // SNORM16 / POSITION_RANGE
+layout(location=5) in vec4 inColor;      // RGBA8 UNORM
+layout(location=6) in uvec4 inTexIndex;  // x = texture index
+
+layout(location=0) out vec3 vColor;
+layout(location=1) out vec2 vUV;
+layout(location=2) out vec3 vWorldPos;
+layout(location=3) flat out int vTexIndex;
+layout(location=4) out vec3 vNormal;
+
+layout(set=0, binding=0) uniform UBO {
+    mat4 model;
+    mat4 view;
+    mat4 proj;
+    mat4 lightSpaceMatrix;
+    vec3 cameraPos;
+    float time;
+    vec3 fogColor;
+    float fogDensity;
+    vec3 skyLightDir;
+    float skyLightIntensity;
+    float texTiling;
+    float textureCount;
+} ubo;
+
+layout(push_constant) uniform ChunkPush {
+    vec4 chunkOrigin;  // xyz = world-space origin of the packed positions
+} chunk;
+
+// Must match kPackedPositionRange in ChunkMesh.hpp
+const float POSITION_RANGE = 256.0;
+
+void main() {
+    vec3 partPos = chunk.chunkOrigin.xyz + inPartPos.xyz * POSITION_RANGE;
+    vec3 partSize = inPartSize.xyz * POSITION_RANGE;
+    vec3 localPos = partPos + inPos * partSize;
+
+    // UVs tile once per 4 world units along the two axes spanning the face:
+    // front/back = width x height, left/right = depth x height, top/bottom = width x depth
+    vec2 faceSize;
+    if (abs(inNormal.y) > 0.5) {
+        faceSize = partSize.xz;
+    } else if (abs(inNormal.x) > 0.5) {
+        faceSize = partSize.zy;
+    } else {
+        faceSize = partSize.xy;
+    }
+
+    vColor = inColor.rgb;
+    vUV = inCorner * faceSize / 4.0;
+    vWorldPos = (ubo.model * vec4(localPos, 1.0)).xyz;
+    // Transform normal to world space (assuming no non-uniform scaling)
+    vNormal = normalize((ubo.model * vec4(inNormal, 0.0)).xyz);
+    vTexIndex = int(inTexIndex.x);
+    gl_Position = ubo.proj * ubo.view * ubo.model * vec4(localPos, 1.0);
+}
@@ -228,23 +228,77 @@ vec3 renderLightShafts(vec2 uv) {
     return vec3(0.0);
 }
 
+// View distance from a depth buffer value, for any perspective projection
+float linearDepth(float depth) {
+    return ppUBO.proj[3][2] / (depth + ppUBO.proj[2][2]);
+}
+
+// Full-resolution pixel whose depth the volumetric passes used for a
+// low-resolution texel, must match depthPixel in vol_raymarch.comp. Depth is
+// always fetched unfiltered: the sampler is linear, and averaging across a
+// silhouette gives a depth in mid-air that matches neither side.
+ivec2 depthPixel(ivec2 lowCoord, ivec2 lowExtent) {
+    ivec2 fullExtent = textureSize(depthTexture, 0);
+    return min(ivec2((vec2(lowCoord) + 0.5) * vec2(fullExtent) / vec2(lowExtent)), fullExtent - 1);
+}
+
+// The volumetric targets are lower resolution than the screen. Weight the
+// four nearest texels bilinearly and by how close the depth their rays
+// stopped at is to this pixel's, so fog from behind a building does not
+// bleed over its silhouette. rgb = scattering, a = transmittance.
+vec4 upsampleVolumetrics(vec2 uv) {
+    ivec2 lowExtent = textureSize(scatteringTexture, 0);
+    vec2 lowSize = vec2(lowExtent);
+    vec2 texel = uv * lowSize - 0.5;
+    vec2 base = floor(texel);
+    vec2 f = texel - base;
+    ivec2 fullExtent = textureSize(depthTexture, 0);
+    ivec2 centerPixel = clamp(ivec2(uv * vec2(fullExtent)), ivec2(0), fullExtent - 1);
+    float centerDepth = linearDepth(texelFetch(depthTexture, centerPixel, 0).r);
+
+    vec4 sum = vec4(0.0);
+    float weightSum = 0.0;
+    vec4 closest = vec4(0.0, 0.0, 0.0, 1.0);
+    float closestDiff = 1e9;
+    for (int i = 0; i < 4; ++i) {
+        vec2 offset = vec2(i & 1, i >> 1);
+        ivec2 tapCoord = ivec2(clamp(base + offset, vec2(0.0), lowSize - 1.0));
+        vec2 tapUV = (vec2(tapCoord) + 0.5) / lowSize;
+        // Same depth the raymarch read for this texel
+        float tapDepth = linearDepth(texelFetch(depthTexture, depthPixel(tapCoord, lowExtent), 0).r);
+        float diff = abs(tapDepth - centerDepth) / max(centerDepth, 1e-3);
+        vec2 bilinear = mix(1.0 - f, f, offset);
+        float weight = bilinear.x * bilinear.y * exp(-diff * 32.0);
+        vec4 value = vec4(textureLod(scatteringTexture, tapUV, 0.0).rgb, textureLod(transmittanceTexture, tapUV, 0.0).r);
+        sum += value * weight;
+        weightSum += weight;
+        if (diff < closestDiff) {
+            closestDiff = diff;
+            closest = value;
+        }
+    }
+    // No tap at a similar depth: take the nearest one rather than blur
+    return weightSum > 1e-4 ? sum / weightSum : closest;
+}
+
 // Chromatic aberration: shift RGB channels radially from center
-vec3 sampleWithChromaticAberration(sampler2D tex, vec2 uv, float strength) {
-    vec2 center = vec2(0.5);
-    vec2 offset = (uv - center) * strength;
-    
-    float r = texture(tex, uv + offset * 0.8).r;
-    float g = texture(tex, uv).g;
-    float b = texture(tex, uv - offset * 0.8).b;
-    
-    return vec3(r, g, b);
+vec4 upsampleWithChromaticAberration(vec2 uv, float strength) {
+    vec4 center = upsampleVolumetrics(uv);
+    if (strength <= 0.0) {
+        return center;
+    }
+    vec2 offset = (uv - vec2(0.5)) * strength;
+    float r = upsampleVolumetrics(uv + offset * 0.8).r;
+    float b = upsampleVolumetrics(uv - offset * 0.8).b;
+    return vec4(r, center.g, b, center.a);
 }
 
 void main() {
     // Sample base inputs with chromatic aberration on scattering for lens distortion feel
     vec4 hdrColor = texture(hdrTexture, vUV);
-    vec3 scattering = sampleWithChromaticAberration(scatteringTexture, vUV, ppUBO.chromaticAberrationStrength);
-    float transmittance = texture(transmittanceTexture, vUV).r;
+    vec4 volumetrics = upsampleWithChromaticAberration(vUV, ppUBO.chromaticAberrationStrength);
+    vec3 scattering = volumetrics.rgb;
+    float transmittance = volumetrics.a;
     vec3 anamorphicBloom = texture(anamorphicBloomTexture, vUV).rgb;
     
     // Debug modes based on multiplier value
@@ -0,0 +1,201 @@
+#include "ChunkMesh.hpp"
+#include "CityGenerator.hpp"
+#include <cmath>
+#include <glm/gtc/packing.hpp>
+
+namespace pcengine {
+
+namespace {
+
+int16_t packSnorm16(float value) {
+    float n = glm::clamp(value / kPackedPositionRange, -1.0f, 1.0f);
+    return static_cast<int16_t>(std::lround(n * 32767.0f));
+}
+
+void packPosition(const glm::vec3& value, int16_t out[4]) {
+    out[0] = packSnorm16(value.x);
+    out[1] = packSnorm16(value.y);
+    out[2] = packSnorm16(value.z);
+    out[3] = 0;
+}
+
+void packColor(const glm::vec3& color, uint8_t out[4]) {
+    out[0] = static_cast<uint8_t>(std::lround(glm::clamp(color.x, 0.0f, 1.0f) * 255.0f));
+    out[1] = static_cast<uint8_t>(std::lround(glm::clamp(color.y, 0.0f, 1.0f) * 255.0f));
+    out[2] = static_cast<uint8_t>(std::lround(glm::clamp(color.z, 0.0f, 1.0f) * 255.0f));
+    out[3] = 255;
+}
+
+void appendBuildingParts(const std::vector<Building>& buildings, ChunkMesh& out) {
+    for (const auto& building : buildings) {
+        // Iterate through all parts (trunk + branches)
+        for (const auto& part : building.parts) {
+            // Calculate absolute position (bottom-center of the box)
+            glm::vec3 pos = building.position + part.position;
+
+            CityInstance instance{};
+            packPosition(pos - out.origin, instance.position);
+            packPosition(part.size, instance.size);
+            packColor(part.color, instance.color);
+            instance.texIndex = static_cast<uint8_t>(((int)std::round(pos.x + pos.y + pos.z)) & 1);
+            out.cityInstances.push_back(instance);
+            out.partCount++;
+
+            // Bounds from the unpacked values; packing moves a corner by at most ~4mm
+            out.bounds.min = glm::min(out.bounds.min, pos - glm::vec3(part.size.x * 0.5f, 0.0f, part.size.z * 0.5f));
+            out.bounds.max = glm::max(out.bounds.max, pos + glm::vec3(part.size.x * 0.5f, part.size.y, part.size.z * 0.5f));
+        }
+    }
+}
+
+void appendNeonQuads(const std::vector<NeonLight>& neonLights, int neonTextureCount, ChunkMesh& out) {
+    uint32_t vertexOffset = static_cast<uint32_t>(out.neonVertices.size() / kNeonVertexFloats);
+
+    for (const auto& light : neonLights) {
+        // Use the light's individual width and height
+        float halfW = light.width * 0.5f;
+        float halfH = light.height * 0.5f;
+        float x = light.position.x;
+        float y = light.position.y;
+        float z = light.position.z;
+
+        int texIndex = 0;
+        {
+            int layerCount = (neonTextureCount > 0) ? neonTextureCount : 1;
+            int seed = static_cast<int>(std::round(x + y + z));
+            int mod = seed % layerCount;
+            texIndex = (mod < 0) ? (mod + layerCount) : mod;
+        }
+
+        // Quad corners as (x, y, z), oriented based on wall face
+        // face: 0=front(+Z), 1=back(-Z), 2=left(-X), 3=right(+X)
+        float corners[4][3];
+        switch (light.face) {
+            case 1: // Back face (-Z) - facing backward (flip winding)
+                corners[0][0] = x+halfW; corners[0][1] = y-halfH; corners[0][2] = z;
+                corners[1][0] = x-halfW; corners[1][1] = y-halfH; corners[1][2] = z;
+                corners[2][0] = x-halfW; corners[2][1] = y+halfH; corners[2][2] = z;
+                corners[3][0] = x+halfW; corners[3][1] = y+halfH; corners[3][2] = z;
+                break;
+            case 2: // Left face (-X) - facing left
+                corners[0][0] = x; corners[0][1] = y-halfH; corners[0][2] = z+halfW;
+                corners[1][0] = x; corners[1][1] = y-halfH; corners[1][2] = z-halfW;
+                corners[2][0] = x; corners[2][1] = y+halfH; corners[2][2] = z-halfW;
+                corners[3][0] = x; corners[3][1] = y+halfH; corners[3][2] = z+halfW;
+                break;
+            case 3: // Right face (+X) - facing right (flip winding)
+                corners[0][0] = x; corners[0][1] = y-halfH; corners[0][2] = z-halfW;
+                corners[1][0] = x; corners[1][1] = y-halfH; corners[1][2] = z+halfW;
+                corners[2][0] = x; corners[2][1] = y+halfH; corners[2][2] = z+halfW;
+                corners[3][0] = x; corners[3][1] = y+halfH; corners[3][2] = z-halfW;
+                break;
+            case 0: // Front face (+Z) - facing forward
+            default: // Should never happen, but use front face as fallback
+                corners[0][0] = x-halfW; corners[0][1] = y-halfH; corners[0][2] = z;
+                corners[1][0] = x+halfW; corners[1][1] = y-halfH; corners[1][2] = z;
+                corners[2][0] = x+halfW; corners[2][1] = y+halfH; corners[2][2] = z;
+                corners[3][0] = x-halfW; corners[3][1] = y+halfH; corners[3][2] = z;
+                break;
+        }
+
+        static const float kQuadUVs[4][2] = { { 0.0f, 1.0f }, { 1.0f, 1.0f }, { 1.0f, 0.0f }, { 0.0f, 0.0f } };
+        for (int v = 0; v < 4; ++v) {
+            out.neonVertices.insert(out.neonVertices.end(), {
+                corners[v][0], corners[v][1], corners[v][2],
+                light.color.x, light.color.y, light.color.z, light.intensity,
+                kQuadUVs[v][0], kQuadUVs[v][1],
+                static_cast<float>(texIndex)
+            });
+        }
+
+        out.neonIndices.insert(out.neonIndices.end(), {
+            vertexOffset + 0, vertexOffset + 1, vertexOffset + 2,
+            vertexOffset + 2, vertexOffset + 3, vertexOffset + 0
+        });
+
+        vertexOffset += 4;
+    }
+}
+
+void appendGroundTile(int chunkX, int chunkZ, float chunkSize, ChunkMesh& out) {
+    uint32_t vertexOffset = static_cast<uint32_t>(out.groundVertices.size());
+
+    // Calculate chunk boundaries in world space
+    float minX = chunkX * chunkSize;
+    float maxX = (chunkX + 1) * chunkSize;
+    float minZ = chunkZ * chunkSize;
+    float maxZ = (chunkZ + 1) * chunkSize;
+    float y = 0.0f;  // Ground level
+
+    // Dark ground color (almost black with subtle blue tint for dystopian aesthetic)
+    glm::vec3 groundColor(0.02f, 0.025f, 0.03f);
+
+    // Add some variation based on chunk position
+    int seed = static_cast<int>(static_cast<uint32_t>(chunkX) * 73856093u ^ static_cast<uint32_t>(chunkZ) * 19349663u);
+    float variation = ((seed % 100) / 100.0f) * 0.01f;
+    groundColor += glm::vec3(variation);
+
+    // UV coordinates for tiling texture (if we add ground textures later)
+    float uvScale = 1.0f;  // 1:1 scale with world units
+
+    const glm::vec3 corners[4] = {
+        glm::vec3(minX, y, minZ),  // Bottom-left
+        glm::vec3(maxX, y, minZ),  // Bottom-right
+        glm::vec3(maxX, y, maxZ),  // Top-right
+        glm::vec3(minX, y, maxZ),  // Top-left
+    };
+    const float uvs[4][2] = { { 0.0f, 0.0f }, { uvScale, 0.0f }, { uvScale, uvScale }, { 0.0f, uvScale } };
+
+    for (int v = 0; v < 4; ++v) {
+        GroundVertex vertex{};
+        packPosition(corners[v] - out.origin, vertex.position);
+        packColor(groundColor, vertex.color);
+        vertex.uv[0] = glm::packHalf1x16(uvs[v][0]);
+        vertex.uv[1] = glm::packHalf1x16(uvs[v][1]);
+        vertex.face = 5;      // Normal points down (-Y, flipped for proper lighting)
+        vertex.texIndex = 0;  // Use first texture or specific ground texture
+        out.groundVertices.push_back(vertex);
+
+        out.bounds.min = glm::min(out.bounds.min, corners[v]);
+        out.bounds.max = glm::max(out.bounds.max, corners[v]);
+    }
+
+    // Two triangles for the quad
+    out.groundIndices.insert(out.groundIndices.end(), {
+        vertexOffset + 0, vertexOffset + 1, vertexOffset + 2,
+        vertexOffset + 2, vertexOffset + 3, vertexOffset + 0
+    });
+}
+
+void growBounds(const std::vector<float>& vertices, uint32_t stride, AABB& bounds) {
+    for (size_t i = 0; i + 2 < vertices.size(); i += stride) {
+        glm::vec3 pos(vertices[i], vertices[i + 1], vertices[i + 2]);
+        bounds.min = glm::min(bounds.min, pos);
+        bounds.max = glm::max(bounds.max, pos);
+    }
+}
+
+}
+
+void buildChunkMesh(const CityChunk& chunk, float chunkSize, int neonTextureCount, ChunkMesh& out) {
+    size_t partCount = 0;
+    for (const auto& building : chunk.buildings) {
+        partCount += building.parts.size();
+    }
+    out.cityInstances.reserve(out.cityInstances.size() + partCount);
+    out.neonVertices.reserve(out.neonVertices.size() + chunk.neonLights.size() * 4 * kNeonVertexFloats);
+    out.neonIndices.reserve(out.neonIndices.size() + chunk.neonLights.size() * 6);
+
+    // Packed positions are relative to the chunk corner; the bounds start
+    // there too, every chunk has a ground tile covering it anyway
+    out.origin = glm::vec3(chunk.chunkX * chunkSize, 0.0f, chunk.chunkZ * chunkSize);
+    out.bounds.min = out.origin;
+    out.bounds.max = out.origin;
+
+    appendBuildingParts(chunk.buildings, out);
+    appendNeonQuads(chunk.neonLights, neonTextureCount, out);
+    appendGroundTile(chunk.chunkX, chunk.chunkZ, chunkSize, out);
+    growBounds(out.neonVertices, kNeonVertexFloats, out.bounds);
+}
+
+}
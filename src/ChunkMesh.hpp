@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "FrustumCuller.hpp"
+
+namespace pcengine {
+
+struct CityChunk;
+
+// Packed vertex layouts shared by the mesh builder, the pipelines and the
+// city shaders. Positions are stored relative to the chunk origin as SNORM16
+// scaled by kPackedPositionRange (about 8mm steps); the origin comes from a
+// per-draw push constant. Must match POSITION_RANGE in city.vert / city_box.vert.
+constexpr float kPackedPositionRange = 256.0f;
+
+// Ground vertex (20 bytes, was 48 as 12 floats)
+struct GroundVertex {
+    int16_t position[4];  // SNORM16 xyz, chunk-relative; w unused
+    uint8_t color[4];     // RGBA8 UNORM; a unused
+    uint16_t uv[2];       // Half floats
+    uint8_t face;         // Normal: 0=+Z 1=-Z 2=-X 3=+X 4=+Y 5=-Y
+    uint8_t texIndex;
+    uint8_t pad[2];
+};
+static_assert(sizeof(GroundVertex) == 20, "GroundVertex must match the pipeline vertex input");
+
+// Building part instance (24 bytes, was 40 as 10 floats)
+struct CityInstance {
+    int16_t position[4];  // SNORM16 bottom-center, chunk-relative; w unused
+    int16_t size[4];      // SNORM16 extents; w unused
+    uint8_t color[4];     // RGBA8 UNORM; a unused
+    uint8_t texIndex;
+    uint8_t pad[3];
+};
+static_assert(sizeof(CityInstance) == 24, "CityInstance must match the pipeline vertex input");
+
+// Neon: pos(3) + color(3) + intensity(1) + uv(2) + texIndex(1)
+constexpr uint32_t kNeonVertexFloats = 10;
+
+// CPU-side geometry for one chunk. Built on a worker thread from a CityChunk,
+// so it must not depend on any renderer state. Indices are chunk-local.
+// Building parts are not tessellated: each one is a box instance drawn from
+// the shared unit box mesh.
+struct ChunkMesh {
+    std::vector<CityInstance> cityInstances;
+    std::vector<float> neonVertices;
+    std::vector<uint32_t> neonIndices;
+    std::vector<GroundVertex> groundVertices;
+    std::vector<uint32_t> groundIndices;
+    size_t partCount = 0;  // = cityInstances.size()
+    glm::vec3 origin = glm::vec3(0.0f);  // World-space origin the packed positions are relative to
+    AABB bounds;  // World-space bounds of everything above, for per-chunk culling
+};
+
+// Tessellate buildings, neon quads and the ground tile of one chunk.
+// neonTextureCount is the layer count of the neon texture array (0 = none loaded).
+void buildChunkMesh(const CityChunk& chunk, float chunkSize, int neonTextureCount, ChunkMesh& out);
+
+}
@@ -0,0 +1,78 @@
+#include "ChunkStreamer.hpp"
+#include "WorkerPool.hpp"
+
+namespace pcengine {
+
+ChunkStreamer::ChunkStreamer(const CityGenerator& generator, WorkerPool& pool)
+    : generator_(generator)
+    , pool_(pool)
+{
+}
+
+ChunkStreamer::~ChunkStreamer() {
+    // Jobs hold a pointer to this streamer, let them drain first
+    pool_.waitIdle();
+}
+
+bool ChunkStreamer::request(int chunkX, int chunkZ, int baseSeed) {
+    auto chunkKey = std::make_pair(chunkX, chunkZ);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!pending_.insert(chunkKey).second) {
+            return false;
+        }
+    }
+
+    // Snapshot everything the job reads from mutable render-thread state
+    GroundLightParams groundLights = GroundLightParams::fromConfig();
+    float chunkSize = generator_.getChunkSize();
+    int neonTextureCount = neonTextureCount_;
+
+    pool_.submit([this, chunkX, chunkZ, baseSeed, groundLights, chunkSize, neonTextureCount]() {
+        StreamedChunk result;
+        result.chunk = generator_.buildChunk(chunkX, chunkZ, baseSeed, groundLights);
+        buildChunkMesh(result.chunk, chunkSize, neonTextureCount, result.mesh);
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        ready_.push_back(std::move(result));
+    });
+    return true;
+}
+
+bool ChunkStreamer::isPending(int chunkX, int chunkZ) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return pending_.count(std::make_pair(chunkX, chunkZ)) != 0;
+}
+
+size_t ChunkStreamer::getPendingCount() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return pending_.size();
+}
+
+size_t ChunkStreamer::collectReady(size_t maxCount, std::vector<StreamedChunk>& out) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    size_t moved = 0;
+    while (!ready_.empty() && (maxCount == 0 || moved < maxCount)) {
+        StreamedChunk& front = ready_.front();
+        pending_.erase(std::make_pair(front.chunk.chunkX, front.chunk.chunkZ));
+        out.push_back(std::move(front));
+        ready_.pop_front();
+        ++moved;
+    }
+    return moved;
+}
+
+void ChunkStreamer::putBack(std::vector<StreamedChunk>& chunks, size_t first) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (size_t i = chunks.size(); i > first; --i) {
+        StreamedChunk& chunk = chunks[i - 1];
+        pending_.insert(std::make_pair(chunk.chunk.chunkX, chunk.chunk.chunkZ));
+        ready_.push_front(std::move(chunk));
+    }
+}
+
+void ChunkStreamer::waitIdle() {
+    pool_.waitIdle();
+}
+
+}
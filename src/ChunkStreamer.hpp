@@ -0,0 +1,61 @@
+#pragma once
+
+#include "CityGenerator.hpp"
+#include "ChunkMesh.hpp"
+#include <deque>
+#include <mutex>
+#include <set>
+#include <utility>
+#include <vector>
+
+namespace pcengine {
+
+class WorkerPool;
+
+// A chunk that finished background generation and mesh building and is
+// waiting for the render thread to publish it
+struct StreamedChunk {
+    CityChunk chunk;
+    ChunkMesh mesh;
+};
+
+// Background chunk pipeline: request() -> worker generates the chunk and
+// tessellates its mesh -> render thread takes finished chunks with
+// collectReady() at its own pace. Nothing in here touches Vulkan.
+class ChunkStreamer {
+public:
+    ChunkStreamer(const CityGenerator& generator, WorkerPool& pool);
+    ~ChunkStreamer();
+
+    ChunkStreamer(const ChunkStreamer&) = delete;
+    ChunkStreamer& operator=(const ChunkStreamer&) = delete;
+
+    void setNeonTextureCount(int count) { neonTextureCount_ = count; }
+
+    // Start a background job for the chunk unless one is already in flight.
+    // Returns true if a new job was queued.
+    bool request(int chunkX, int chunkZ, int baseSeed);
+    bool isPending(int chunkX, int chunkZ) const;
+    // Chunks requested but not yet collected (in flight or ready)
+    size_t getPendingCount() const;
+
+    // Move up to maxCount finished chunks into out (0 = no limit). Returns count moved.
+    size_t collectReady(size_t maxCount, std::vector<StreamedChunk>& out);
+    // Hand chunks[first..] back, in order, ahead of everything still ready.
+    // For collected chunks the render thread could not publish this frame.
+    void putBack(std::vector<StreamedChunk>& chunks, size_t first);
+
+    // Block until every requested chunk has been built
+    void waitIdle();
+
+private:
+    const CityGenerator& generator_;
+    WorkerPool& pool_;
+    int neonTextureCount_ = 0;
+
+    mutable std::mutex mutex_;
+    std::set<std::pair<int, int>> pending_;
+    std::deque<StreamedChunk> ready_;
+};
+
+}
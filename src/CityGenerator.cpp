@@ -1,59 +1,45 @@
 #include "CityGenerator.hpp"
 #include "VolumetricConfig.hpp"
 #include <cmath>
+#include <cfloat>
+#include <cstdio>
 #include <algorithm>
 
 namespace pcengine {
 
-CityGenerator::CityGenerator() 
-    : rng_(42)
-    , heightDist_(0.0f, 1.0f)
-    , colorDist_(0.0f, 1.0f)
-    , neonDist_(0.0f, 1.0f)
-{
+CityGenerator::CityGenerator() {
 }
 
-void CityGenerator::generateCity(int seed) {
-    rng_.seed(seed);
-    buildings_.clear();
-    neonLights_.clear();
-    lightVolumes_.clear();
-    chunkData_.clear();
-    
-    // Generate buildings on a grid with some randomness
-    for (int x = 0; x < gridSize_; ++x) {
-        for (int z = 0; z < gridSize_; ++z) {
-            // Skip some grid positions for density variation
-            if (neonDist_(rng_) > buildingDensity_) continue;
-            
-            glm::vec2 gridPos(x * gridSpacing_, z * gridSpacing_);
-            generateBuilding(gridPos);
-        }
-    }
-    
-    printf("Generated %zu buildings with %zu neon lights and %zu light volumes\n", buildings_.size(), neonLights_.size(), lightVolumes_.size());
+GroundLightParams GroundLightParams::fromConfig() {
+    GroundLightParams params;
+    params.attempts = g_volumetricConfig.groundLightAttempts;
+    params.maxCount = g_volumetricConfig.groundLightMaxCount;
+    params.minClearance = g_volumetricConfig.groundLightMinClearance;
+    params.minHeight = g_volumetricConfig.groundLightMinHeight;
+    params.maxHeight = g_volumetricConfig.groundLightMaxHeight;
+    params.minSize = g_volumetricConfig.groundLightMinSize;
+    params.maxSize = g_volumetricConfig.groundLightMaxSize;
+    params.minIntensity = g_volumetricConfig.groundLightMinIntensity;
+    params.maxIntensity = g_volumetricConfig.groundLightMaxIntensity;
+    return params;
 }
 
-void CityGenerator::generateChunk(int chunkX, int chunkZ, int baseSeed) {
-    // Check if chunk already exists
-    auto chunkKey = std::make_pair(chunkX, chunkZ);
-    if (chunkData_.find(chunkKey) != chunkData_.end()) {
-        printf("  [SKIP] Chunk (%d, %d) already exists\n", chunkX, chunkZ);
-        return; // Chunk already generated
-    }
-    
+uint32_t CityGenerator::chunkSeed(int chunkX, int chunkZ, int baseSeed) {
     // Create a deterministic seed for this chunk based on its coordinates
-    // Using a hash function to combine chunk coordinates and base seed
-    int chunkSeed = baseSeed;
-    chunkSeed = chunkSeed * 73856093 ^ chunkX * 19349663;
-    chunkSeed = chunkSeed ^ chunkZ * 83492791;
-    
-    rng_.seed(chunkSeed);
+    // Using a hash function to combine chunk coordinates and base seed.
+    // Unsigned math gives the same bits as the old int version without overflow UB.
+    uint32_t seed = static_cast<uint32_t>(baseSeed);
+    seed = seed * 73856093u ^ static_cast<uint32_t>(chunkX) * 19349663u;
+    seed = seed ^ static_cast<uint32_t>(chunkZ) * 83492791u;
+    return seed;
+}
+
+CityChunk CityGenerator::buildChunk(int chunkX, int chunkZ, int baseSeed, const GroundLightParams& groundLights) const {
+    CityChunk chunk;
+    chunk.chunkX = chunkX;
+    chunk.chunkZ = chunkZ;
     
-    // Store starting indices
-    size_t buildingStartIndex = buildings_.size();
-    size_t neonStartIndex = neonLights_.size();
-    size_t volumeStartIndex = lightVolumes_.size();
+    GenerationContext ctx(chunkSeed(chunkX, chunkZ, baseSeed), groundLights, chunk);
     
     // Generate buildings for this chunk
     float chunkWorldX = chunkX * chunkSize_;
@@ -64,13 +50,11 @@ void CityGenerator::generateChunk(int chunkX, int chunkZ, int baseSeed) {
     const int gridCount = 5;  // 5x5 grid
     float cellSize = chunkSize_ / gridCount;
     
-    int skippedCount = 0;
     for (int x = 0; x < gridCount; ++x) {
         for (int z = 0; z < gridCount; ++z) {
             // Always place center building, others based on density
             bool isCenter = (x == 2 && z == 2);
-            if (!isCenter && neonDist_(rng_) > buildingDensity_) {
-                skippedCount++;
+            if (!isCenter && ctx.neonDist(ctx.rng) > buildingDensity_) {
                 continue;
             }
             
@@ -80,8 +64,8 @@ void CityGenerator::generateChunk(int chunkX, int chunkZ, int baseSeed) {
             
             // Add small random offset (±15% of cell size) for variety
             if (!isCenter) {  // Keep center building perfectly centered
-                localX += (neonDist_(rng_) - 0.5f) * cellSize * 0.3f;
-                localZ += (neonDist_(rng_) - 0.5f) * cellSize * 0.3f;
+                localX += (ctx.neonDist(ctx.rng) - 0.5f) * cellSize * 0.3f;
+                localZ += (ctx.neonDist(ctx.rng) - 0.5f) * cellSize * 0.3f;
             }
             
             // World coordinates
@@ -89,45 +73,67 @@ void CityGenerator::generateChunk(int chunkX, int chunkZ, int baseSeed) {
             float worldZ = chunkWorldZ + localZ;
             
             glm::vec2 gridPos(worldX, worldZ);
-            generateBuilding(gridPos);
+            generateBuilding(ctx, gridPos);
         }
     }
     
-    // Add cube light volumes for this chunk
-    addCubeLightVolumes();
-    
-    // Store indices for this chunk
-    ChunkData chunkData;
-    for (size_t i = buildingStartIndex; i < buildings_.size(); ++i) {
-        chunkData.buildingIndices.push_back(i);
-    }
-    for (size_t i = neonStartIndex; i < neonLights_.size(); ++i) {
-        chunkData.neonIndices.push_back(i);
+    // Add cube light volumes for this chunk (placed against this chunk's buildings only)
+    addCubeLightVolumes(ctx);
+
+    chunk.buildingBounds.reserve(chunk.buildings.size());
+    for (const auto& building : chunk.buildings) {
+        AABB bounds;
+        bounds.min = building.position - glm::vec3(building.size.x * 0.5f, 0.0f, building.size.z * 0.5f);
+        bounds.max = bounds.min + building.size;
+        chunk.buildingBounds.push_back(bounds);
     }
-    for (size_t i = volumeStartIndex; i < lightVolumes_.size(); ++i) {
-        chunkData.lightVolumeIndices.push_back(i);
+    
+    return chunk;
+}
+
+void CityGenerator::commitChunk(CityChunk&& chunk) {
+    auto chunkKey = std::make_pair(chunk.chunkX, chunk.chunkZ);
+    if (chunks_.find(chunkKey) != chunks_.end()) {
+        return;
     }
-    chunkData_[chunkKey] = chunkData;
     
     // Debug: Print how many buildings were generated in this chunk
-    printf("  Chunk (%d, %d): %zu buildings, %zu neon lights, %zu light volumes\n", chunkX, chunkZ, chunkData.buildingIndices.size(), chunkData.neonIndices.size(), chunkData.lightVolumeIndices.size());
+    printf("  Chunk (%d, %d): %zu buildings, %zu neon lights, %zu light volumes\n", chunk.chunkX, chunk.chunkZ, chunk.buildings.size(), chunk.neonLights.size(), chunk.lightVolumes.size());
+    
+    buildingCount_ += chunk.buildings.size();
+    neonLightCount_ += chunk.neonLights.size();
+    lightVolumeCount_ += chunk.lightVolumes.size();
+    chunks_.emplace(chunkKey, std::move(chunk));
+    ++chunkGeneration_;
 }
 
 void CityGenerator::removeChunk(int chunkX, int chunkZ) {
-    // Simply clear the chunk from tracking
-    // The actual cleanup happens in clearAllChunks()
-    auto chunkKey = std::make_pair(chunkX, chunkZ);
-    chunkData_.erase(chunkKey);
+    auto it = chunks_.find(std::make_pair(chunkX, chunkZ));
+    if (it == chunks_.end()) {
+        return;
+    }
+    
+    buildingCount_ -= it->second.buildings.size();
+    neonLightCount_ -= it->second.neonLights.size();
+    lightVolumeCount_ -= it->second.lightVolumes.size();
+    chunks_.erase(it);
+    ++chunkGeneration_;
 }
 
 void CityGenerator::clearAllChunks() {
-    buildings_.clear();
-    neonLights_.clear();
-    lightVolumes_.clear();
-    chunkData_.clear();
+    chunks_.clear();
+    buildingCount_ = 0;
+    neonLightCount_ = 0;
+    lightVolumeCount_ = 0;
+    ++chunkGeneration_;
+}
+
+const CityChunk* CityGenerator::findChunk(int chunkX, int chunkZ) const {
+    auto it = chunks_.find(std::make_pair(chunkX, chunkZ));
+    return it != chunks_.end() ? &it->second : nullptr;
 }
 
-void CityGenerator::generateBuilding(glm::vec2 gridPos) {
+void CityGenerator::generateBuilding(GenerationContext& ctx, glm::vec2 gridPos) const {
     Building building;
     
     // For infinite world, use gridPos directly (chunk system handles world positioning)
@@ -139,20 +145,20 @@ void CityGenerator::generateBuilding(glm::vec2 gridPos) {
     );
     
     // Generate asymmetrical size
-    float baseWidth = 2.0f + neonDist_(rng_) * 4.0f;
-    float baseDepth = 2.0f + neonDist_(rng_) * 4.0f;
+    float baseWidth = 2.0f + ctx.neonDist(ctx.rng) * 4.0f;
+    float baseDepth = 2.0f + ctx.neonDist(ctx.rng) * 4.0f;
     
     // Make buildings more rectangular and varied
-    if (neonDist_(rng_) > 0.5f) {
-        baseWidth *= 1.5f + neonDist_(rng_) * 2.0f;
+    if (ctx.neonDist(ctx.rng) > 0.5f) {
+        baseWidth *= 1.5f + ctx.neonDist(ctx.rng) * 2.0f;
     } else {
-        baseDepth *= 1.5f + neonDist_(rng_) * 2.0f;
+        baseDepth *= 1.5f + ctx.neonDist(ctx.rng) * 2.0f;
     }
     
-    building.size = glm::vec3(baseWidth, generateHeight(minHeight_), baseDepth);
-    building.color = generateBuildingColor();
-    building.heightVariation = neonDist_(rng_) * 0.3f;
-    building.hasAntenna = neonDist_(rng_) > 0.7f;
+    building.size = glm::vec3(baseWidth, generateHeight(ctx, minHeight_), baseDepth);
+    building.color = generateBuildingColor(ctx);
+    building.heightVariation = ctx.neonDist(ctx.rng) * 0.3f;
+    building.hasAntenna = ctx.neonDist(ctx.rng) > 0.7f;
     
     // Create the trunk (main building)
     BuildingPart trunk;
@@ -164,30 +170,30 @@ void CityGenerator::generateBuilding(glm::vec2 gridPos) {
     building.parts.push_back(trunk);
     
     // Generate branches from the trunk
-    generateBranches(building, trunk, 2); // Max depth of 2 for branch recursion
+    generateBranches(ctx, building, trunk, 2); // Max depth of 2 for branch recursion
     
     // Add neon lights to this building
-    addNeonLights(building);
-    addLightVolumes(building);
+    addNeonLights(ctx, building);
+    addLightVolumes(ctx, building);
     
-    buildings_.push_back(building);
+    ctx.out.buildings.push_back(building);
 }
 
-void CityGenerator::addNeonLights(Building& building) {
-    int numLights = 2 + static_cast<int>(neonDist_(rng_) * 8);
+void CityGenerator::addNeonLights(GenerationContext& ctx, Building& building) const {
+    int numLights = 2 + static_cast<int>(ctx.neonDist(ctx.rng) * 8);
     
     for (int i = 0; i < numLights; ++i) {
         NeonLight light;
         
         // Choose a random building part to attach the neon to (trunk or branch)
         if (building.parts.empty()) continue;
-        const BuildingPart& part = building.parts[static_cast<size_t>(neonDist_(rng_) * building.parts.size())];
+        const BuildingPart& part = building.parts[static_cast<size_t>(ctx.neonDist(ctx.rng) * building.parts.size())];
         
         // Calculate absolute position of this part
         glm::vec3 partAbsPos = building.position + part.position;
         
         // Choose which face to place the neon on
-        float side = neonDist_(rng_);
+        float side = ctx.neonDist(ctx.rng);
         float wallWidth, wallHeight;
         const float offset = 0.05f;  // Small offset to prevent z-fighting
         
@@ -215,19 +221,19 @@ void CityGenerator::addNeonLights(Building& building) {
         
         // Generate base size with distribution (most small, some huge)
         float baseSize;
-        float sizeRoll = neonDist_(rng_);
+        float sizeRoll = ctx.neonDist(ctx.rng);
         if (sizeRoll < 0.6f) {
-            baseSize = 0.3f + neonDist_(rng_) * 0.5f;  // 0.3-0.8
+            baseSize = 0.3f + ctx.neonDist(ctx.rng) * 0.5f;  // 0.3-0.8
         } else if (sizeRoll < 0.85f) {
-            baseSize = 0.8f + neonDist_(rng_) * 1.2f;  // 0.8-2.0
+            baseSize = 0.8f + ctx.neonDist(ctx.rng) * 1.2f;  // 0.8-2.0
         } else if (sizeRoll < 0.95f) {
-            baseSize = 2.0f + neonDist_(rng_) * 2.0f;  // 2.0-4.0
+            baseSize = 2.0f + ctx.neonDist(ctx.rng) * 2.0f;  // 2.0-4.0
         } else {
-            baseSize = 4.0f + neonDist_(rng_) * 4.0f;  // 4.0-8.0 (billboard)
+            baseSize = 4.0f + ctx.neonDist(ctx.rng) * 4.0f;  // 4.0-8.0 (billboard)
         }
         
         // Random aspect ratio (some wide, some tall, some square)
-        float aspectRatio = 0.5f + neonDist_(rng_) * 1.5f;  // 0.5 to 2.0
+        float aspectRatio = 0.5f + ctx.neonDist(ctx.rng) * 1.5f;  // 0.5 to 2.0
         light.width = baseSize * aspectRatio;
         light.height = baseSize;
         
@@ -246,8 +252,8 @@ void CityGenerator::addNeonLights(Building& building) {
         }
         
         // Position on the wall (centered with some randomness)
-        float xOffset = (neonDist_(rng_) - 0.5f) * (wallWidth - light.width);
-        float yOffset = neonDist_(rng_) * (wallHeight - light.height) + light.height * 0.5f;
+        float xOffset = (ctx.neonDist(ctx.rng) - 0.5f) * (wallWidth - light.width);
+        float yOffset = ctx.neonDist(ctx.rng) * (wallHeight - light.height) + light.height * 0.5f;
         
         // Set position based on face, with proper offset to avoid z-fighting
         switch (light.face) {
@@ -282,7 +288,7 @@ void CityGenerator::addNeonLights(Building& building) {
         }
         
         // Generate neon colors (warm tones with some blues)
-        float colorChoice = neonDist_(rng_);
+        float colorChoice = ctx.neonDist(ctx.rng);
         if (colorChoice < 0.3f) {
             light.color = glm::vec3(1.0f, 0.3f, 0.1f); // Red
         } else if (colorChoice < 0.6f) {
@@ -293,17 +299,17 @@ void CityGenerator::addNeonLights(Building& building) {
             light.color = glm::vec3(0.8f, 0.2f, 1.0f); // Purple
         }
         
-        light.intensity = 0.5f + neonDist_(rng_) * 1.5f;
-        light.radius = 8.0f + neonDist_(rng_) * 12.0f;
+        light.intensity = 0.5f + ctx.neonDist(ctx.rng) * 1.5f;
+        light.radius = 8.0f + ctx.neonDist(ctx.rng) * 12.0f;
         
-        neonLights_.push_back(light);
+        ctx.out.neonLights.push_back(light);
     }
 }
 
-glm::vec3 CityGenerator::generateBuildingColor() {
+glm::vec3 CityGenerator::generateBuildingColor(GenerationContext& ctx) const {
     // Dark, industrial colors
-    float baseGray = 0.1f + colorDist_(rng_) * 0.2f;
-    float tint = colorDist_(rng_);
+    float baseGray = 0.1f + ctx.colorDist(ctx.rng) * 0.2f;
+    float tint = ctx.colorDist(ctx.rng);
     
     if (tint < 0.3f) {
         return glm::vec3(baseGray, baseGray * 0.8f, baseGray * 0.6f); // Brownish
@@ -314,12 +320,12 @@ glm::vec3 CityGenerator::generateBuildingColor() {
     }
 }
 
-float CityGenerator::generateHeight(float baseHeight) {
+float CityGenerator::generateHeight(GenerationContext& ctx, float baseHeight) const {
     (void)baseHeight; // Unused parameter
     
     // Use exponential distribution for more realistic height distribution
     // This creates more buildings below half max height than above
-    float exponentialFactor = heightDist_(rng_);
+    float exponentialFactor = ctx.heightDist(ctx.rng);
     
     // Apply exponential distribution: more buildings at lower heights
     // Using exponential function: exp(-λ * x) where λ controls the curve
@@ -328,8 +334,8 @@ float CityGenerator::generateHeight(float baseHeight) {
     
     // Add some spatial clustering - taller buildings tend to be in center
     float distanceFromCenter = std::sqrt(
-        std::pow(heightDist_(rng_) - 0.5f, 2) + 
-        std::pow(heightDist_(rng_) - 0.5f, 2)
+        std::pow(ctx.heightDist(ctx.rng) - 0.5f, 2) + 
+        std::pow(ctx.heightDist(ctx.rng) - 0.5f, 2)
     );
     
     // Center bias: buildings in center can be taller
@@ -342,14 +348,14 @@ float CityGenerator::generateHeight(float baseHeight) {
     return minHeight_ + heightFactor * (maxHeight_ - minHeight_);
 }
 
-void CityGenerator::generateBranches(Building& building, BuildingPart& parent, int maxDepth, int currentDepth) {
+void CityGenerator::generateBranches(GenerationContext& ctx, Building& building, BuildingPart& parent, int maxDepth, int currentDepth) const {
     // Stop recursion if we've reached max depth
     if (currentDepth >= maxDepth) return;
     
     // Decide how many pairs of branches to add (always even number for symmetry)
     // 0, 2, 4, or 6 pairs (0, 2, 4, 6 total branches)
     int numBranchPairs = 0;
-    float branchChance = neonDist_(rng_);
+    float branchChance = ctx.neonDist(ctx.rng);
     
     if (currentDepth == 0) {
         // From trunk, more likely to have branches
@@ -375,22 +381,22 @@ void CityGenerator::generateBranches(Building& building, BuildingPart& parent, i
     
     // Generate symmetric branch pairs
     for (int i = 0; i < numBranchPairs; ++i) {
-        addSymmetricBranches(building, parent, currentDepth + 1);
+        addSymmetricBranches(ctx, building, parent, currentDepth + 1);
     }
 }
 
-void CityGenerator::addSymmetricBranches(Building& building, const BuildingPart& parent, int detailLevel) {
+void CityGenerator::addSymmetricBranches(GenerationContext& ctx, Building& building, const BuildingPart& parent, int detailLevel) const {
     // Choose attachment direction: front/back, left/right, or top (for vertical extensions)
-    float directionChoice = neonDist_(rng_);
+    float directionChoice = ctx.neonDist(ctx.rng);
     
     // Branch size relative to parent (smaller than parent)
-    float sizeScale = 0.3f + neonDist_(rng_) * 0.4f; // 0.3 to 0.7 of parent size
+    float sizeScale = 0.3f + ctx.neonDist(ctx.rng) * 0.4f; // 0.3 to 0.7 of parent size
     
     // Branch position along parent (how high up the parent)
-    float attachmentHeight = 0.3f + neonDist_(rng_) * 0.5f; // 30% to 80% up parent
+    float attachmentHeight = 0.3f + ctx.neonDist(ctx.rng) * 0.5f; // 30% to 80% up parent
     
     // Extend amount (how far the branch extends from parent)
-    float extendAmount = 0.4f + neonDist_(rng_) * 0.6f; // 40% to 100% of parent dimension
+    float extendAmount = 0.4f + ctx.neonDist(ctx.rng) * 0.6f; // 40% to 100% of parent dimension
     
     if (directionChoice < 0.33f) {
         // Front/Back branches (along Z axis)
@@ -399,7 +405,7 @@ void CityGenerator::addSymmetricBranches(Building& building, const BuildingPart&
         float branchDepth = parent.size.z * extendAmount;
         
         float attachY = parent.position.y + parent.size.y * attachmentHeight;
-        float attachX = (neonDist_(rng_) - 0.5f) * parent.size.x * 0.6f; // Random X position on face
+        float attachX = (ctx.neonDist(ctx.rng) - 0.5f) * parent.size.x * 0.6f; // Random X position on face
         
         // Front branch
         BuildingPart frontBranch;
@@ -409,7 +415,7 @@ void CityGenerator::addSymmetricBranches(Building& building, const BuildingPart&
             parent.position.z + parent.size.z * 0.5f + branchDepth * 0.5f
         );
         frontBranch.size = glm::vec3(branchWidth, branchHeight, branchDepth);
-        frontBranch.color = building.color * (0.9f + neonDist_(rng_) * 0.2f); // Slight color variation
+        frontBranch.color = building.color * (0.9f + ctx.neonDist(ctx.rng) * 0.2f); // Slight color variation
         frontBranch.detailLevel = detailLevel;
         building.parts.push_back(frontBranch);
         
@@ -430,8 +436,8 @@ void CityGenerator::addSymmetricBranches(Building& building, const BuildingPart&
         size_t branch1Idx = building.parts.size() - 2;
         size_t branch2Idx = building.parts.size() - 1;
         if (detailLevel < 2) {
-            generateBranches(building, building.parts[branch1Idx], 2, detailLevel);
-            generateBranches(building, building.parts[branch2Idx], 2, detailLevel);
+            generateBranches(ctx, building, building.parts[branch1Idx], 2, detailLevel);
+            generateBranches(ctx, building, building.parts[branch2Idx], 2, detailLevel);
         }
         
     } else if (directionChoice < 0.66f) {
@@ -441,7 +447,7 @@ void CityGenerator::addSymmetricBranches(Building& building, const BuildingPart&
         float branchDepth = parent.size.z * sizeScale;
         
         float attachY = parent.position.y + parent.size.y * attachmentHeight;
-        float attachZ = (neonDist_(rng_) - 0.5f) * parent.size.z * 0.6f; // Random Z position on face
+        float attachZ = (ctx.neonDist(ctx.rng) - 0.5f) * parent.size.z * 0.6f; // Random Z position on face
         
         // Right branch
         BuildingPart rightBranch;
@@ -451,7 +457,7 @@ void CityGenerator::addSymmetricBranches(Building& building, const BuildingPart&
             parent.position.z + attachZ
         );
         rightBranch.size = glm::vec3(branchWidth, branchHeight, branchDepth);
-        rightBranch.color = building.color * (0.9f + neonDist_(rng_) * 0.2f);
+        rightBranch.color = building.color * (0.9f + ctx.neonDist(ctx.rng) * 0.2f);
         rightBranch.detailLevel = detailLevel;
         building.parts.push_back(rightBranch);
         
@@ -471,15 +477,15 @@ void CityGenerator::addSymmetricBranches(Building& building, const BuildingPart&
         size_t branch1Idx = building.parts.size() - 2;
         size_t branch2Idx = building.parts.size() - 1;
         if (detailLevel < 2) {
-            generateBranches(building, building.parts[branch1Idx], 2, detailLevel);
-            generateBranches(building, building.parts[branch2Idx], 2, detailLevel);
+            generateBranches(ctx, building, building.parts[branch1Idx], 2, detailLevel);
+            generateBranches(ctx, building, building.parts[branch2Idx], 2, detailLevel);
         }
         
     } else {
         // Top branches (vertical extensions, smaller on top)
-        float branchWidth = parent.size.x * (0.7f + neonDist_(rng_) * 0.3f); // 70-100% of parent width
+        float branchWidth = parent.size.x * (0.7f + ctx.neonDist(ctx.rng) * 0.3f); // 70-100% of parent width
         float branchHeight = parent.size.y * sizeScale;
-        float branchDepth = parent.size.z * (0.7f + neonDist_(rng_) * 0.3f); // 70-100% of parent depth
+        float branchDepth = parent.size.z * (0.7f + ctx.neonDist(ctx.rng) * 0.3f); // 70-100% of parent depth
         
         // Top-left branch
         BuildingPart topLeftBranch;
@@ -489,7 +495,7 @@ void CityGenerator::addSymmetricBranches(Building& building, const BuildingPart&
             parent.position.z + parent.size.z * 0.15f
         );
         topLeftBranch.size = glm::vec3(branchWidth, branchHeight, branchDepth);
-        topLeftBranch.color = building.color * (0.9f + neonDist_(rng_) * 0.2f);
+        topLeftBranch.color = building.color * (0.9f + ctx.neonDist(ctx.rng) * 0.2f);
         topLeftBranch.detailLevel = detailLevel;
         building.parts.push_back(topLeftBranch);
         
@@ -509,13 +515,13 @@ void CityGenerator::addSymmetricBranches(Building& building, const BuildingPart&
         size_t branch1Idx = building.parts.size() - 2;
         size_t branch2Idx = building.parts.size() - 1;
         if (detailLevel < 2) {
-            generateBranches(building, building.parts[branch1Idx], 2, detailLevel);
-            generateBranches(building, building.parts[branch2Idx], 2, detailLevel);
+            generateBranches(ctx, building, building.parts[branch1Idx], 2, detailLevel);
+            generateBranches(ctx, building, building.parts[branch2Idx], 2, detailLevel);
         }
     }
 }
 
-void CityGenerator::addLightVolumes(Building& building) {
+void CityGenerator::addLightVolumes(GenerationContext& ctx, Building& building) const {
     // DISABLED: Focus on box lights for now
     return;
     
@@ -525,27 +531,27 @@ void CityGenerator::addLightVolumes(Building& building) {
     }
 
     float spawnChance = 0.45f; // 45% chance per building
-    if (neonDist_(rng_) > spawnChance) {
+    if (ctx.neonDist(ctx.rng) > spawnChance) {
         return;
     }
 
     int beamCount = 1;
-    if (building.size.y > 80.0f && neonDist_(rng_) < 0.5f) {
+    if (building.size.y > 80.0f && ctx.neonDist(ctx.rng) < 0.5f) {
         beamCount = 2;
     }
 
     for (int i = 0; i < beamCount; ++i) {
         LightVolume volume;
-        float radius = 3.0f + neonDist_(rng_) * 4.0f;
-        float height = 180.0f + neonDist_(rng_) * 220.0f;
+        float radius = 3.0f + ctx.neonDist(ctx.rng) * 4.0f;
+        float height = 180.0f + ctx.neonDist(ctx.rng) * 220.0f;
 
         volume.basePosition = building.position + glm::vec3(
-            (neonDist_(rng_) - 0.5f) * building.size.x * 0.3f,
+            (ctx.neonDist(ctx.rng) - 0.5f) * building.size.x * 0.3f,
             building.size.y,
-            (neonDist_(rng_) - 0.5f) * building.size.z * 0.3f);
+            (ctx.neonDist(ctx.rng) - 0.5f) * building.size.z * 0.3f);
         volume.height = height;
         volume.baseRadius = radius;
-        float colorRoll = neonDist_(rng_);
+        float colorRoll = ctx.neonDist(ctx.rng);
         if (colorRoll < 0.5f) {
             volume.color = glm::vec3(0.3f, 1.2f, 1.5f);
         } else if (colorRoll < 0.8f) {
@@ -553,23 +559,23 @@ void CityGenerator::addLightVolumes(Building& building) {
         } else {
             volume.color = glm::vec3(0.8f, 1.0f, 1.5f);
         }
-        volume.intensity = 8.0f + neonDist_(rng_) * 12.0f;
-        volume.isCone = neonDist_(rng_) > 0.3f;
+        volume.intensity = 8.0f + ctx.neonDist(ctx.rng) * 12.0f;
+        volume.isCone = ctx.neonDist(ctx.rng) > 0.3f;
 
-        lightVolumes_.push_back(volume);
+        ctx.out.lightVolumes.push_back(volume);
     }
 }
 
-void CityGenerator::addCubeLightVolumes() {
+void CityGenerator::addCubeLightVolumes(GenerationContext& ctx) const {
     // Generate floating cube light volumes between buildings
     // These create atmospheric depth and fill negative space
     
-    if (buildings_.empty()) return;
+    if (ctx.out.buildings.empty()) return;
     
-    // Calculate city bounds
+    // Calculate bounds of this chunk's buildings
     glm::vec2 minBounds(FLT_MAX);
     glm::vec2 maxBounds(-FLT_MAX);
-    for (const auto& building : buildings_) {
+    for (const auto& building : ctx.out.buildings) {
         minBounds.x = std::min(minBounds.x, building.position.x - building.size.x);
         minBounds.y = std::min(minBounds.y, building.position.z - building.size.z);
         maxBounds.x = std::max(maxBounds.x, building.position.x + building.size.x);
@@ -577,21 +583,21 @@ void CityGenerator::addCubeLightVolumes() {
     }
     
     // Try to place cube volumes in gaps between buildings
-    int attempts = g_volumetricConfig.groundLightAttempts;
+    int attempts = ctx.groundLights.attempts;
     int placed = 0;
     
-    for (int i = 0; i < attempts && placed < g_volumetricConfig.groundLightMaxCount; ++i) {
+    for (int i = 0; i < attempts && placed < ctx.groundLights.maxCount; ++i) {
         // Random position in city bounds
         glm::vec3 pos(
-            minBounds.x + neonDist_(rng_) * (maxBounds.x - minBounds.x),
+            minBounds.x + ctx.neonDist(ctx.rng) * (maxBounds.x - minBounds.x),
             0.0f, // Ground level
-            minBounds.y + neonDist_(rng_) * (maxBounds.y - minBounds.y)
+            minBounds.y + ctx.neonDist(ctx.rng) * (maxBounds.y - minBounds.y)
         );
         
         // Check if position is clear of buildings
         bool clear = true;
-        float minClearance = g_volumetricConfig.groundLightMinClearance;
-        for (const auto& building : buildings_) {
+        float minClearance = ctx.groundLights.minClearance;
+        for (const auto& building : ctx.out.buildings) {
             float dx = std::abs(pos.x - building.position.x);
             float dz = std::abs(pos.z - building.position.z);
             float clearanceX = dx - building.size.x * 0.5f;
@@ -608,13 +614,13 @@ void CityGenerator::addCubeLightVolumes() {
         // Create a cube volume
         LightVolume volume;
         volume.basePosition = pos;
-        volume.height = g_volumetricConfig.groundLightMinHeight + 
-                       neonDist_(rng_) * (g_volumetricConfig.groundLightMaxHeight - g_volumetricConfig.groundLightMinHeight);
-        volume.baseRadius = g_volumetricConfig.groundLightMinSize + 
-                           neonDist_(rng_) * (g_volumetricConfig.groundLightMaxSize - g_volumetricConfig.groundLightMinSize);
+        volume.height = ctx.groundLights.minHeight + 
+                       ctx.neonDist(ctx.rng) * (ctx.groundLights.maxHeight - ctx.groundLights.minHeight);
+        volume.baseRadius = ctx.groundLights.minSize + 
+                           ctx.neonDist(ctx.rng) * (ctx.groundLights.maxSize - ctx.groundLights.minSize);
         
         // Random colors - more varied palette
-        float colorRoll = neonDist_(rng_);
+        float colorRoll = ctx.neonDist(ctx.rng);
         if (colorRoll < 0.2f) {
             // Cyan
             volume.color = glm::vec3(0.2f, 1.0f, 1.2f);
@@ -632,21 +638,13 @@ void CityGenerator::addCubeLightVolumes() {
             volume.color = glm::vec3(1.0f, 0.4f, 0.8f);
         }
         
-        volume.intensity = g_volumetricConfig.groundLightMinIntensity + 
-                          neonDist_(rng_) * (g_volumetricConfig.groundLightMaxIntensity - g_volumetricConfig.groundLightMinIntensity);
+        volume.intensity = ctx.groundLights.minIntensity + 
+                          ctx.neonDist(ctx.rng) * (ctx.groundLights.maxIntensity - ctx.groundLights.minIntensity);
         volume.isCone = false; // Mark as cube (not cone)
         
-        lightVolumes_.push_back(volume);
+        ctx.out.lightVolumes.push_back(volume);
         placed++;
-        
-        // Debug: Print first few positions
-        if (placed <= 3) {
-            printf("  Cube light #%d at (%.1f, %.1f, %.1f) size=%.1f intensity=%.1f\n", 
-                   placed, pos.x, pos.y, pos.z, volume.baseRadius, volume.intensity);
-        }
     }
-    
-    printf("  Added %d cube light volumes\n", placed);
 }
 
 }
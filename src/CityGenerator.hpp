@@ -2,8 +2,11 @@
 
 #include <vector>
 #include <map>
+#include <cstdint>
+#include <utility>
 #include <glm/glm.hpp>
 #include <random>
+#include "FrustumCuller.hpp"
 
 namespace pcengine {
 
@@ -43,21 +46,56 @@ struct LightVolume {
     bool isCone;
 };
 
+// Ground light placement settings. Copied out of g_volumetricConfig on the
+// render thread so chunk jobs never read the config while it hot-reloads.
+struct GroundLightParams {
+    int attempts = 100;
+    int maxCount = 20;
+    float minClearance = 15.0f;
+    float minHeight = 3.0f;
+    float maxHeight = 8.0f;
+    float minSize = 3.0f;
+    float maxSize = 7.0f;
+    float minIntensity = 8.0f;
+    float maxIntensity = 20.0f;
+
+    static GroundLightParams fromConfig();
+};
+
+// Everything generated for one chunk. Produced by CityGenerator::buildChunk()
+// without touching shared state, so chunks can be built on worker threads.
+struct CityChunk {
+    int chunkX = 0;
+    int chunkZ = 0;
+    std::vector<Building> buildings;
+    std::vector<AABB> buildingBounds;  // World-space trunk box of each building, same order
+    std::vector<NeonLight> neonLights;
+    std::vector<LightVolume> lightVolumes;
+};
+
 class CityGenerator {
 public:
     CityGenerator();
     ~CityGenerator() = default;
 
-    void generateCity(int seed = 42);
-    
-    // Chunk-based generation for infinite city
-    void generateChunk(int chunkX, int chunkZ, int baseSeed = 42);
+    // Chunk-based generation for the infinite city, driven by ChunkStreamer.
+    // Thread-safe: reads only generator parameters, RNG state is local to the call
+    CityChunk buildChunk(int chunkX, int chunkZ, int baseSeed, const GroundLightParams& groundLights) const;
+    // Take ownership of a built chunk (render thread only). Ignored if already loaded.
+    void commitChunk(CityChunk&& chunk);
+    bool hasChunk(int chunkX, int chunkZ) const { return chunks_.count(std::make_pair(chunkX, chunkZ)) != 0; }
+    // Drop a chunk and free everything it owns; other chunks are not touched
     void removeChunk(int chunkX, int chunkZ);
     void clearAllChunks();
     
-    const std::vector<Building>& getBuildings() const { return buildings_; }
-    const std::vector<NeonLight>& getNeonLights() const { return neonLights_; }
-    const std::vector<LightVolume>& getLightVolumes() const { return lightVolumes_; }
+    // Loaded chunks, each owning its buildings, neon lights and light volumes
+    const std::map<std::pair<int, int>, CityChunk>& getChunks() const { return chunks_; }
+    const CityChunk* findChunk(int chunkX, int chunkZ) const;
+    size_t getBuildingCount() const { return buildingCount_; }
+    size_t getNeonLightCount() const { return neonLightCount_; }
+    size_t getLightVolumeCount() const { return lightVolumeCount_; }
+    // Changes whenever a chunk is committed or removed
+    uint64_t getChunkGeneration() const { return chunkGeneration_; }
     
     // City parameters
     void setCitySize(float width, float depth) { cityWidth_ = width; cityDepth_ = depth; }
@@ -71,18 +109,38 @@ public:
     void setChunkSize(float size) { chunkSize_ = size; }
 
 private:
-    void generateBuilding(glm::vec2 gridPos);
-    void generateBranches(Building& building, BuildingPart& parent, int maxDepth, int currentDepth = 0);
-    void addSymmetricBranches(Building& building, const BuildingPart& parent, int detailLevel);
-    void addNeonLights(Building& building);
-    void addLightVolumes(Building& building);
-    void addCubeLightVolumes();
-    glm::vec3 generateBuildingColor();
-    float generateHeight(float baseHeight);
+    // Per-call generation state: RNG plus the block the results are written to.
+    // Each chunk gets its own context, so no RNG or output is shared between threads.
+    struct GenerationContext {
+        GenerationContext(uint32_t seed, const GroundLightParams& groundLightParams, CityChunk& output)
+            : rng(seed), heightDist(0.0f, 1.0f), colorDist(0.0f, 1.0f), neonDist(0.0f, 1.0f)
+            , groundLights(groundLightParams), out(output) {}
+
+        std::mt19937 rng;
+        std::uniform_real_distribution<float> heightDist;
+        std::uniform_real_distribution<float> colorDist;
+        std::uniform_real_distribution<float> neonDist;
+        const GroundLightParams& groundLights;
+        CityChunk& out;
+    };
+
+    static uint32_t chunkSeed(int chunkX, int chunkZ, int baseSeed);
+
+    void generateBuilding(GenerationContext& ctx, glm::vec2 gridPos) const;
+    void generateBranches(GenerationContext& ctx, Building& building, BuildingPart& parent, int maxDepth, int currentDepth = 0) const;
+    void addSymmetricBranches(GenerationContext& ctx, Building& building, const BuildingPart& parent, int detailLevel) const;
+    void addNeonLights(GenerationContext& ctx, Building& building) const;
+    void addLightVolumes(GenerationContext& ctx, Building& building) const;
+    void addCubeLightVolumes(GenerationContext& ctx) const;
+    glm::vec3 generateBuildingColor(GenerationContext& ctx) const;
+    float generateHeight(GenerationContext& ctx, float baseHeight) const;
     
-    std::vector<Building> buildings_;
-    std::vector<NeonLight> neonLights_;
-    std::vector<LightVolume> lightVolumes_;
+    // Per-chunk storage: evicting a chunk frees exactly its own data
+    std::map<std::pair<int, int>, CityChunk> chunks_;
+    size_t buildingCount_ = 0;
+    size_t neonLightCount_ = 0;
+    size_t lightVolumeCount_ = 0;
+    uint64_t chunkGeneration_ = 0;
     
     // City parameters
     float cityWidth_ = 200.0f;
@@ -93,26 +151,11 @@ private:
     float heightDistributionLambda_ = 2.0f; // Controls exponential height distribution
     
     // Grid parameters
-    int gridSize_ = 50;
     float gridSpacing_ = 4.0f;
     
     // Chunk parameters
     float chunkSize_ = 50.0f;  // Size of each chunk in world units
     int buildingsPerChunk_ = 8;  // Grid cells per chunk dimension
-    
-    // Random generation
-    std::mt19937 rng_;
-    std::uniform_real_distribution<float> heightDist_;
-    std::uniform_real_distribution<float> colorDist_;
-    std::uniform_real_distribution<float> neonDist_;
-    
-    // Track which buildings/neons belong to which chunk
-    struct ChunkData {
-        std::vector<size_t> buildingIndices;
-        std::vector<size_t> neonIndices;
-        std::vector<size_t> lightVolumeIndices;
-    };
-    std::map<std::pair<int, int>, ChunkData> chunkData_;
 };
 
 }
@@ -0,0 +1,296 @@
+#include "GpuAllocator.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <iterator>
+
+namespace pcengine {
+
+namespace {
+
+VkDeviceSize alignUp(VkDeviceSize value, VkDeviceSize alignment) {
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+const char* strategyName(GpuAllocationStrategy strategy) {
+    return strategy == GpuAllocationStrategy::Linear ? "linear" : "free-list";
+}
+
+}
+
+GpuAllocator::~GpuAllocator() {
+    destroy();
+}
+
+void GpuAllocator::init(VkPhysicalDevice physicalDevice, VkDevice device, VkDeviceSize blockSize) {
+    device_ = device;
+    blockSize_ = blockSize;
+    vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memoryProperties_);
+
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+    bufferImageGranularity_ = std::max<VkDeviceSize>(1, properties.limits.bufferImageGranularity);
+}
+
+void GpuAllocator::destroy() {
+    for (auto& pool : pools_) {
+        for (auto& block : pool.blocks) {
+            if (block.allocationCount > 0) {
+                printf("GpuAllocator: %u allocations still live in a memory type %u block\n", block.allocationCount, pool.memoryType);
+            }
+            releaseBlock(block);
+        }
+    }
+    pools_.clear();
+}
+
+bool GpuAllocator::allocateForBuffer(VkBuffer buffer, VkMemoryPropertyFlags properties, GpuAllocation& out,
+                                     GpuAllocationStrategy strategy) {
+    VkMemoryRequirements requirements;
+    vkGetBufferMemoryRequirements(device_, buffer, &requirements);
+    if (!allocate(requirements, properties, false, strategy, out)) return false;
+    if (vkBindBufferMemory(device_, buffer, out.memory, out.offset) != VK_SUCCESS) {
+        free(out);
+        return false;
+    }
+    return true;
+}
+
+bool GpuAllocator::allocateForImage(VkImage image, VkMemoryPropertyFlags properties, GpuAllocation& out,
+                                    GpuAllocationStrategy strategy) {
+    VkMemoryRequirements requirements;
+    vkGetImageMemoryRequirements(device_, image, &requirements);
+    // Linear and optimal images share the image pools, keep them on separate granularity pages
+    requirements.alignment = std::max(requirements.alignment, bufferImageGranularity_);
+    requirements.size = alignUp(requirements.size, bufferImageGranularity_);
+    if (!allocate(requirements, properties, true, strategy, out)) return false;
+    if (vkBindImageMemory(device_, image, out.memory, out.offset) != VK_SUCCESS) {
+        free(out);
+        return false;
+    }
+    return true;
+}
+
+bool GpuAllocator::allocate(const VkMemoryRequirements& requirements, VkMemoryPropertyFlags properties, bool image,
+                            GpuAllocationStrategy strategy, GpuAllocation& out) {
+    uint32_t memoryType = findMemoryType(requirements.memoryTypeBits, properties);
+    if (memoryType == UINT32_MAX) {
+        printf("GpuAllocator: no memory type for flags 0x%x\n", properties);
+        return false;
+    }
+
+    uint32_t poolIndex = getPool(memoryType, image, strategy);
+    Pool& pool = pools_[poolIndex];
+    VkDeviceSize alignment = std::max<VkDeviceSize>(1, requirements.alignment);
+
+    VkDeviceSize offset = 0;
+    uint32_t blockIndex = 0;
+    bool found = false;
+    // Oversized requests get a block of their own instead of a mostly empty regular one
+    bool oversized = requirements.size > blockSize_ / 2;
+    if (!oversized) {
+        for (; blockIndex < pool.blocks.size(); ++blockIndex) {
+            Block& block = pool.blocks[blockIndex];
+            if (block.memory && !block.dedicated && allocateFromBlock(pool, block, requirements.size, alignment, offset)) {
+                found = true;
+                break;
+            }
+        }
+    }
+    if (!found) {
+        VkDeviceSize size = oversized ? requirements.size : blockSize_;
+        if (!createBlock(pool, size, oversized, blockIndex)) return false;
+        if (!allocateFromBlock(pool, pool.blocks[blockIndex], requirements.size, alignment, offset)) return false;
+    }
+
+    Block& block = pool.blocks[blockIndex];
+    block.allocationCount++;
+    block.usedBytes += requirements.size;
+
+    out.memory = block.memory;
+    out.offset = offset;
+    out.size = requirements.size;
+    out.mapped = block.mapped ? static_cast<char*>(block.mapped) + offset : nullptr;
+    out.poolIndex = poolIndex;
+    out.blockIndex = blockIndex;
+    return true;
+}
+
+void GpuAllocator::free(GpuAllocation& allocation) {
+    if (!allocation) return;
+
+    Pool& pool = pools_[allocation.poolIndex];
+    Block& block = pool.blocks[allocation.blockIndex];
+    block.allocationCount--;
+    block.usedBytes -= allocation.size;
+
+    if (pool.strategy == GpuAllocationStrategy::Linear) {
+        // Space only comes back once the whole block is empty
+        if (block.allocationCount == 0) {
+            block.linearHead = 0;
+        }
+    } else {
+        // Insert the range and merge it with its neighbours
+        auto it = block.freeRanges.emplace(allocation.offset, allocation.size).first;
+        if (it != block.freeRanges.begin()) {
+            auto prev = std::prev(it);
+            if (prev->first + prev->second == it->first) {
+                prev->second += it->second;
+                block.freeRanges.erase(it);
+                it = prev;
+            }
+        }
+        auto next = std::next(it);
+        if (next != block.freeRanges.end() && it->first + it->second == next->first) {
+            it->second += next->second;
+            block.freeRanges.erase(next);
+        }
+    }
+
+    if (block.dedicated && block.allocationCount == 0) {
+        releaseBlock(block);
+    }
+    allocation = GpuAllocation{};
+}
+
+uint32_t GpuAllocator::findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties) const {
+    for (uint32_t i = 0; i < memoryProperties_.memoryTypeCount; ++i) {
+        if ((typeFilter & (1u << i)) && (memoryProperties_.memoryTypes[i].propertyFlags & properties) == properties) {
+            return i;
+        }
+    }
+    return UINT32_MAX;
+}
+
+uint32_t GpuAllocator::getPool(uint32_t memoryType, bool image, GpuAllocationStrategy strategy) {
+    for (uint32_t i = 0; i < pools_.size(); ++i) {
+        const Pool& pool = pools_[i];
+        if (pool.memoryType == memoryType && pool.images == image && pool.strategy == strategy) {
+            return i;
+        }
+    }
+    Pool pool;
+    pool.memoryType = memoryType;
+    pool.images = image;
+    pool.strategy = strategy;
+    pools_.push_back(pool);
+    return static_cast<uint32_t>(pools_.size() - 1);
+}
+
+bool GpuAllocator::createBlock(Pool& pool, VkDeviceSize size, bool dedicated, uint32_t& blockIndex) {
+    VkMemoryAllocateInfo allocInfo{ VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO };
+    allocInfo.allocationSize = size;
+    allocInfo.memoryTypeIndex = pool.memoryType;
+    Block block;
+    if (vkAllocateMemory(device_, &allocInfo, nullptr, &block.memory) != VK_SUCCESS) {
+        printf("GpuAllocator: failed to allocate a %llu byte block\n", (unsigned long long)size);
+        return false;
+    }
+    block.size = size;
+    block.dedicated = dedicated;
+    block.freeRanges[0] = size;
+
+    // Host-visible blocks are mapped once for their whole lifetime
+    if (memoryProperties_.memoryTypes[pool.memoryType].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) {
+        if (vkMapMemory(device_, block.memory, 0, VK_WHOLE_SIZE, 0, &block.mapped) != VK_SUCCESS) {
+            vkFreeMemory(device_, block.memory, nullptr);
+            return false;
+        }
+    }
+
+    // Reuse the slot of a released block so live allocations keep their indices
+    for (blockIndex = 0; blockIndex < pool.blocks.size(); ++blockIndex) {
+        if (!pool.blocks[blockIndex].memory) {
+            pool.blocks[blockIndex] = block;
+            return true;
+        }
+    }
+    pool.blocks.push_back(block);
+    return true;
+}
+
+bool GpuAllocator::allocateFromBlock(Pool& pool, Block& block, VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize& offset) {
+    if (pool.strategy == GpuAllocationStrategy::Linear) {
+        VkDeviceSize aligned = alignUp(block.linearHead, alignment);
+        if (aligned + size > block.size) return false;
+        offset = aligned;
+        block.linearHead = aligned + size;
+        return true;
+    }
+
+    // First fit; alignment padding in front of the range stays free
+    for (auto it = block.freeRanges.begin(); it != block.freeRanges.end(); ++it) {
+        VkDeviceSize rangeStart = it->first;
+        VkDeviceSize rangeEnd = it->first + it->second;
+        VkDeviceSize aligned = alignUp(rangeStart, alignment);
+        if (aligned + size > rangeEnd) continue;
+
+        block.freeRanges.erase(it);
+        if (aligned > rangeStart) {
+            block.freeRanges[rangeStart] = aligned - rangeStart;
+        }
+        if (aligned + size < rangeEnd) {
+            block.freeRanges[aligned + size] = rangeEnd - (aligned + size);
+        }
+        offset = aligned;
+        return true;
+    }
+    return false;
+}
+
+void GpuAllocator::releaseBlock(Block& block) {
+    if (block.memory) {
+        if (block.mapped) vkUnmapMemory(device_, block.memory);
+        vkFreeMemory(device_, block.memory, nullptr);
+    }
+    block = Block{};
+}
+
+GpuAllocatorStats GpuAllocator::getStats() const {
+    GpuAllocatorStats stats;
+    VkDeviceSize freeListFreeBytes = 0;
+    for (const auto& pool : pools_) {
+        for (const auto& block : pool.blocks) {
+            if (!block.memory) continue;
+            stats.blockCount++;
+            stats.allocationCount += block.allocationCount;
+            stats.reservedBytes += block.size;
+            stats.usedBytes += block.usedBytes;
+            if (pool.strategy == GpuAllocationStrategy::FreeList) {
+                stats.freeRangeCount += static_cast<uint32_t>(block.freeRanges.size());
+                for (const auto& range : block.freeRanges) {
+                    freeListFreeBytes += range.second;
+                    stats.largestFreeRange = std::max(stats.largestFreeRange, range.second);
+                }
+            }
+        }
+    }
+    if (freeListFreeBytes > 0) {
+        stats.fragmentation = 1.0f - static_cast<float>(stats.largestFreeRange) / static_cast<float>(freeListFreeBytes);
+    }
+    return stats;
+}
+
+void GpuAllocator::printStats() const {
+    const double mb = 1.0 / (1024.0 * 1024.0);
+    printf("GPU memory pools:\n");
+    for (const auto& pool : pools_) {
+        uint32_t blocks = 0, allocations = 0;
+        VkDeviceSize reserved = 0, used = 0;
+        for (const auto& block : pool.blocks) {
+            if (!block.memory) continue;
+            blocks++;
+            allocations += block.allocationCount;
+            reserved += block.size;
+            used += block.usedBytes;
+        }
+        printf("  type %u %-6s %-9s: %u blocks, %u allocs, %.1f / %.1f MB\n",
+               pool.memoryType, pool.images ? "images" : "buffers", strategyName(pool.strategy),
+               blocks, allocations, used * mb, reserved * mb);
+    }
+    GpuAllocatorStats stats = getStats();
+    printf("  total: %u blocks, %u allocs, %.1f / %.1f MB, %u free ranges, fragmentation %.2f\n",
+           stats.blockCount, stats.allocationCount, stats.usedBytes * mb, stats.reservedBytes * mb,
+           stats.freeRangeCount, stats.fragmentation);
+}
+
+}
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <vector>
+
+namespace pcengine {
+
+// How a pool hands out space inside its blocks.
+// FreeList: first fit over coalesced free ranges, for resources that come and
+// go (chunk geometry, swapchain-sized targets).
+// Linear: bump pointer, for resources created once and kept; a block is only
+// reused once everything in it has been freed.
+enum class GpuAllocationStrategy {
+    FreeList,
+    Linear,
+};
+
+// A range inside one of the allocator's memory blocks. The VkDeviceMemory is
+// shared with other allocations: bind at offset, never vkFreeMemory/vkMapMemory it.
+struct GpuAllocation {
+    VkDeviceMemory memory = VK_NULL_HANDLE;
+    VkDeviceSize offset = 0;
+    VkDeviceSize size = 0;
+    void* mapped = nullptr;  // Host-visible blocks stay mapped, this points at offset
+    uint32_t poolIndex = 0;
+    uint32_t blockIndex = 0;
+
+    explicit operator bool() const { return memory != VK_NULL_HANDLE; }
+};
+
+struct GpuAllocatorStats {
+    uint32_t blockCount = 0;
+    uint32_t allocationCount = 0;
+    uint32_t freeRangeCount = 0;
+    VkDeviceSize reservedBytes = 0;    // Sum of block sizes (what vkAllocateMemory was asked for)
+    VkDeviceSize usedBytes = 0;        // Sum of live allocation sizes
+    VkDeviceSize largestFreeRange = 0;
+    // 1 - largestFreeRange / free bytes over free-list pools; 0 = all free space contiguous
+    float fragmentation = 0.0f;
+};
+
+// Block-based suballocator. Memory is taken from the driver in large blocks per
+// (memory type, resource kind, strategy) and carved up on the CPU, so resource
+// churn does not turn into vkAllocateMemory calls or count against
+// maxMemoryAllocationCount. Buffers and images live in separate pools, which
+// keeps bufferImageGranularity out of the way. Not thread-safe: render thread only.
+class GpuAllocator {
+public:
+    GpuAllocator() = default;
+    ~GpuAllocator();
+
+    GpuAllocator(const GpuAllocator&) = delete;
+    GpuAllocator& operator=(const GpuAllocator&) = delete;
+
+    void init(VkPhysicalDevice physicalDevice, VkDevice device, VkDeviceSize blockSize = 64ull * 1024 * 1024);
+    // Frees every block. All allocations must be dead by now.
+    void destroy();
+
+    // Allocate memory for the resource and bind it
+    bool allocateForBuffer(VkBuffer buffer, VkMemoryPropertyFlags properties, GpuAllocation& out,
+                           GpuAllocationStrategy strategy = GpuAllocationStrategy::FreeList);
+    bool allocateForImage(VkImage image, VkMemoryPropertyFlags properties, GpuAllocation& out,
+                          GpuAllocationStrategy strategy = GpuAllocationStrategy::FreeList);
+
+    // Return the range to its block and reset the handle. Safe on empty handles.
+    void free(GpuAllocation& allocation);
+
+    GpuAllocatorStats getStats() const;
+    void printStats() const;
+
+private:
+    struct Block {
+        VkDeviceMemory memory = VK_NULL_HANDLE;
+        VkDeviceSize size = 0;
+        void* mapped = nullptr;
+        bool dedicated = false;  // Sized for one oversized request, released when empty
+        std::map<VkDeviceSize, VkDeviceSize> freeRanges;  // offset -> size (FreeList)
+        VkDeviceSize linearHead = 0;  // Linear
+        uint32_t allocationCount = 0;
+        VkDeviceSize usedBytes = 0;
+    };
+    struct Pool {
+        uint32_t memoryType = 0;
+        bool images = false;
+        GpuAllocationStrategy strategy = GpuAllocationStrategy::FreeList;
+        std::vector<Block> blocks;
+    };
+
+    bool allocate(const VkMemoryRequirements& requirements, VkMemoryPropertyFlags properties, bool image,
+                  GpuAllocationStrategy strategy, GpuAllocation& out);
+    uint32_t findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties) const;
+    uint32_t getPool(uint32_t memoryType, bool image, GpuAllocationStrategy strategy);
+    bool createBlock(Pool& pool, VkDeviceSize size, bool dedicated, uint32_t& blockIndex);
+    bool allocateFromBlock(Pool& pool, Block& block, VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize& offset);
+    void releaseBlock(Block& block);
+
+    VkDevice device_ = VK_NULL_HANDLE;
+    VkPhysicalDeviceMemoryProperties memoryProperties_{};
+    VkDeviceSize blockSize_ = 0;
+    VkDeviceSize bufferImageGranularity_ = 1;
+    std::vector<Pool> pools_;
+};
+
+}
@@ -1,5 +1,7 @@
 #include "Renderer.hpp"
 #include "CityGenerator.hpp"
+#include "WorkerPool.hpp"
+#include "ChunkStreamer.hpp"
 #include "VolumetricConfig.hpp"
 
 #include <GLFW/glfw3.h>
@@ -7,6 +9,7 @@
 #define GLFW_INCLUDE_VULKAN
 #include <vulkan/vulkan.h>
 
+#include <algorithm>
 #include <array>
 #include <cassert>
 #include <cstring>
@@ -69,12 +72,14 @@ bool Renderer::initialize(GLFWwindow* window) {
     if (!createSurface(window)) return false;
     if (!pickPhysicalDevice()) return false;
     if (!createDevice()) return false;
+    allocator_.init(physicalDevice_, device_);
     if (!createSwapchain()) return false;
     if (!createImageViews()) return false;
     if (!createRenderPass()) return false;
     if (!createDepthResources()) return false;
     if (!createFramebuffers()) return false;
     if (!createCommandPoolAndBuffers()) return false;
+    if (!createUploadRing()) return false;
     
     // Create HDR render target before pipelines (pipelines need hdrRenderPass_)
     if (!createHDRRenderTarget()) return false;
@@ -83,6 +88,7 @@ bool Renderer::initialize(GLFWwindow* window) {
     if (!createDescriptorSetLayout()) return false;
     if (!createPipeline()) return false;
     if (!createPipelineWireframe()) return false;  // Wireframe version for debug mode
+    if (!createCityBoxPipelines()) return false;
     if (!createBloomTextures()) return false;
     if (!createPostProcessingPipeline()) return false;
     if (!createVolumetricResources()) return false;
@@ -93,18 +99,36 @@ bool Renderer::initialize(GLFWwindow* window) {
     CityGenerator* gen = static_cast<CityGenerator*>(cityGenerator_);
     gen->setGridSpacing(8.0f);
     gen->setChunkSize(50.0f);
-    
-    // Use the chunk system from the start - let updateChunks() generate initial chunks
-    // based on the camera's starting position (0, 100, -150)
-    updateChunks();
+    workerPool_ = new WorkerPool();
+    chunkStreamer_ = new ChunkStreamer(*gen, *workerPool_);
+    printf("Chunk worker pool: %u threads\n", workerPool_->getThreadCount());
     
     if (!loadTextures()) return false;
     if (!loadNeonTextures()) return false;
+    chunkStreamer_->setNeonTextureCount(numNeonTextures_);
+    if (!createBoxGeometry()) return false;
+    
+    // Use the chunk system from the start - stream in the chunks around the camera's
+    // starting position (0, 100, -150) and wait for them so the first frame has a city.
+    // Publishing uploads each chunk's geometry. Nothing is in flight yet, so when the
+    // staging ring fills up the deferred chunks go out after a flush.
+    updateChunks();
+    chunkStreamer_->waitIdle();
+    while (true) {
+        size_t pendingBefore = chunkStreamer_->getPendingCount();
+        publishStreamedChunks(0);
+        size_t pendingAfter = chunkStreamer_->getPendingCount();
+        if (pendingAfter == 0) break;
+        // Deferred chunks only fit once the ring is flushed; with nothing to flush
+        // and no chunk taken this pass, another pass would do the same
+        if (pendingAfter == pendingBefore && pendingUploads_.empty()) {
+            printf("%zu chunks could not be published before the first frame\n", pendingAfter);
+            break;
+        }
+        flushUploadsImmediate();
+    }
+    geometryNeedsRebuild_ = false;
     
-    // Build geometry from the initial chunks
-    if (!createCityGeometry()) return false;
-    if (!createNeonGeometry()) return false;
-    if (!createGroundGeometry()) return false;
     // Shadow volumes disabled for now
     // if (!createShadowVolumeGeometry()) return false;
     if (!createNeonPipeline()) return false;
@@ -142,6 +166,7 @@ bool Renderer::initialize(GLFWwindow* window) {
         // Don't fail initialization, just warn
     }
     
+    allocator_.printStats();
     return true;
 }
 
@@ -150,6 +175,16 @@ void Renderer::shutdown() {
         vkDeviceWaitIdle(device_);
     }
 
+    // Stop chunk streaming before the generator it reads from goes away
+    if (chunkStreamer_) {
+        delete chunkStreamer_;
+        chunkStreamer_ = nullptr;
+    }
+    if (workerPool_) {
+        delete workerPool_;
+        workerPool_ = nullptr;
+    }
+
     // Clean up city generator
     if (cityGenerator_) {
         delete static_cast<CityGenerator*>(cityGenerator_);
@@ -157,14 +192,26 @@ void Renderer::shutdown() {
     }
 
     if (device_ != VK_NULL_HANDLE) {
-        vkDestroyFence(device_, inFlightFence_, nullptr);
-        vkDestroySemaphore(device_, renderFinishedSemaphore_, nullptr);
-        vkDestroySemaphore(device_, imageAvailableSemaphore_, nullptr);
+        while (!chunkGeometry_.empty()) {
+            releaseChunkGeometry(chunkGeometry_.begin()->first);
+        }
+        retireBuffer(boxVertexBuffer_, boxVertexBufferMemory_);
+        retireBuffer(boxIndexBuffer_, boxIndexBufferMemory_);
+        retireBuffer(shadowVolumeVertexBuffer_, shadowVolumeVertexBufferMemory_);
+        retireBuffer(shadowVolumeIndexBuffer_, shadowVolumeIndexBufferMemory_);
+        retireBuffer(debugLightMarkerVertexBuffer_, debugLightMarkerVertexMemory_);
+        retireBuffer(debugLightMarkerIndexBuffer_, debugLightMarkerIndexMemory_);
+        releaseRetiredResources(UINT64_MAX);
+        destroyUploadRing();
+        for (auto& frame : frames_) {
+            if (frame.inFlight) vkDestroyFence(device_, frame.inFlight, nullptr);
+            if (frame.imageAvailable) vkDestroySemaphore(device_, frame.imageAvailable, nullptr);
+            frame = FrameSync{};
+        }
 
         for (auto& ub : uniformBuffers_) {
-            if (ub.mapped) { vkUnmapMemory(device_, ub.memory); }
             if (ub.buffer) vkDestroyBuffer(device_, ub.buffer, nullptr);
-            if (ub.memory) vkFreeMemory(device_, ub.memory, nullptr);
+            allocator_.free(ub.memory);
         }
         uniformBuffers_.clear();
 
@@ -177,7 +224,7 @@ void Renderer::shutdown() {
         if (shadowMapSampler_) vkDestroySampler(device_, shadowMapSampler_, nullptr);
         if (shadowMapView_) vkDestroyImageView(device_, shadowMapView_, nullptr);
         if (shadowMapImage_) vkDestroyImage(device_, shadowMapImage_, nullptr);
-        if (shadowMapMemory_) vkFreeMemory(device_, shadowMapMemory_, nullptr);
+        allocator_.free(shadowMapMemory_);
 
         // Clean up post-processing resources
         if (postProcessingPipeline_) vkDestroyPipeline(device_, postProcessingPipeline_, nullptr);
@@ -185,14 +232,18 @@ void Renderer::shutdown() {
         if (postProcessingDescriptorPool_) vkDestroyDescriptorPool(device_, postProcessingDescriptorPool_, nullptr);
         if (postProcessingDescriptorLayout_) vkDestroyDescriptorSetLayout(device_, postProcessingDescriptorLayout_, nullptr);
         
-        if (postProcessingUBO_.mapped) vkUnmapMemory(device_, postProcessingUBO_.memory);
-        if (postProcessingUBO_.buffer) vkDestroyBuffer(device_, postProcessingUBO_.buffer, nullptr);
-        if (postProcessingUBO_.memory) vkFreeMemory(device_, postProcessingUBO_.memory, nullptr);
+        if (fullscreenQuadBuffer_) vkDestroyBuffer(device_, fullscreenQuadBuffer_, nullptr);
+        allocator_.free(fullscreenQuadBufferMemory_);
+        for (auto& ubo : postProcessingUBOs_) {
+            if (ubo.buffer) vkDestroyBuffer(device_, ubo.buffer, nullptr);
+            allocator_.free(ubo.memory);
+            ubo = BufferWithMemory{};
+        }
         
         // Clean up bloom resources
         for (auto& fb : bloomFramebuffers_) vkDestroyFramebuffer(device_, fb, nullptr);
         for (auto& view : bloomViews_) vkDestroyImageView(device_, view, nullptr);
-        for (auto& memory : bloomMemories_) vkFreeMemory(device_, memory, nullptr);
+        for (auto& memory : bloomMemories_) allocator_.free(memory);
         for (auto& image : bloomImages_) vkDestroyImage(device_, image, nullptr);
         if (bloomRenderPass_) vkDestroyRenderPass(device_, bloomRenderPass_, nullptr);
         
@@ -200,7 +251,7 @@ void Renderer::shutdown() {
         if (hdrFramebuffer_) vkDestroyFramebuffer(device_, hdrFramebuffer_, nullptr);
         if (hdrColorView_) vkDestroyImageView(device_, hdrColorView_, nullptr);
         if (hdrColorImage_) vkDestroyImage(device_, hdrColorImage_, nullptr);
-        if (hdrColorMemory_) vkFreeMemory(device_, hdrColorMemory_, nullptr);
+        allocator_.free(hdrColorMemory_);
         if (hdrRenderPass_) vkDestroyRenderPass(device_, hdrRenderPass_, nullptr);
 
         // Clean up debug overlay resources
@@ -209,19 +260,19 @@ void Renderer::shutdown() {
         if (debugTextDescriptorPool_) vkDestroyDescriptorPool(device_, debugTextDescriptorPool_, nullptr);
         if (debugTextDescriptorLayout_) vkDestroyDescriptorSetLayout(device_, debugTextDescriptorLayout_, nullptr);
         if (debugTextVertexBuffer_) vkDestroyBuffer(device_, debugTextVertexBuffer_, nullptr);
-        if (debugTextVertexMemory_) vkFreeMemory(device_, debugTextVertexMemory_, nullptr);
+        allocator_.free(debugTextVertexMemory_);
         if (debugTextIndexBuffer_) vkDestroyBuffer(device_, debugTextIndexBuffer_, nullptr);
-        if (debugTextIndexMemory_) vkFreeMemory(device_, debugTextIndexMemory_, nullptr);
+        allocator_.free(debugTextIndexMemory_);
         if (debugFontSampler_) vkDestroySampler(device_, debugFontSampler_, nullptr);
         if (debugFontView_) vkDestroyImageView(device_, debugFontView_, nullptr);
         if (debugFontImage_) vkDestroyImage(device_, debugFontImage_, nullptr);
-        if (debugFontMemory_) vkFreeMemory(device_, debugFontMemory_, nullptr);
+        allocator_.free(debugFontMemory_);
         
         // Clean up debug chunk visualization resources
         if (debugChunkPipeline_) vkDestroyPipeline(device_, debugChunkPipeline_, nullptr);
         if (debugChunkPipelineLayout_) vkDestroyPipelineLayout(device_, debugChunkPipelineLayout_, nullptr);
         if (debugChunkVertexBuffer_) vkDestroyBuffer(device_, debugChunkVertexBuffer_, nullptr);
-        if (debugChunkVertexMemory_) vkFreeMemory(device_, debugChunkVertexMemory_, nullptr);
+        allocator_.free(debugChunkVertexMemory_);
 
         destroyVolumetricResources();
 
@@ -230,30 +281,33 @@ void Renderer::shutdown() {
         for (int i = 0; i < kMaxBuildingTextures; ++i) {
             if (buildingTextureViews_[i]) vkDestroyImageView(device_, buildingTextureViews_[i], nullptr);
             if (buildingTextures_[i]) vkDestroyImage(device_, buildingTextures_[i], nullptr);
-            if (buildingTextureMemories_[i]) vkFreeMemory(device_, buildingTextureMemories_[i], nullptr);
+            allocator_.free(buildingTextureMemories_[i]);
             buildingTextureViews_[i] = VK_NULL_HANDLE;
             buildingTextures_[i] = VK_NULL_HANDLE;
-            buildingTextureMemories_[i] = VK_NULL_HANDLE;
         }
         if (neonArrayView_) vkDestroyImageView(device_, neonArrayView_, nullptr);
         if (neonArrayImage_) vkDestroyImage(device_, neonArrayImage_, nullptr);
-        if (neonArrayMemory_) vkFreeMemory(device_, neonArrayMemory_, nullptr);
+        allocator_.free(neonArrayMemory_);
         if (neonPipeline_) vkDestroyPipeline(device_, neonPipeline_, nullptr);
         
         // Clean up city pipelines
         if (graphicsPipeline_) vkDestroyPipeline(device_, graphicsPipeline_, nullptr);
         if (graphicsPipelineWireframe_) vkDestroyPipeline(device_, graphicsPipelineWireframe_, nullptr);
+        if (cityBoxPipeline_) vkDestroyPipeline(device_, cityBoxPipeline_, nullptr);
+        if (cityBoxPipelineWireframe_) vkDestroyPipeline(device_, cityBoxPipelineWireframe_, nullptr);
         if (pipelineLayout_) vkDestroyPipelineLayout(device_, pipelineLayout_, nullptr);
 
         if (indexBuffer_) vkDestroyBuffer(device_, indexBuffer_, nullptr);
-        if (indexBufferMemory_) vkFreeMemory(device_, indexBufferMemory_, nullptr);
+        allocator_.free(indexBufferMemory_);
         if (vertexBuffer_) vkDestroyBuffer(device_, vertexBuffer_, nullptr);
-        if (vertexBufferMemory_) vkFreeMemory(device_, vertexBufferMemory_, nullptr);
+        allocator_.free(vertexBufferMemory_);
 
         if (commandPool_) vkDestroyCommandPool(device_, commandPool_, nullptr);
 
         cleanupSwapchain();
 
+        allocator_.printStats();
+        allocator_.destroy();
         vkDestroyDevice(device_, nullptr);
         device_ = VK_NULL_HANDLE;
     }
@@ -280,7 +334,10 @@ void Renderer::update(float deltaSeconds) {
     configCheckTimer += deltaSeconds;
     if (configCheckTimer >= 2.0f) {
         configCheckTimer = 0.0f;
-        g_volumetricConfig.checkAndReload("volumetric_config.json");
+        if (g_volumetricConfig.checkAndReload("volumetric_config.json")) {
+            volumetrics_.lightSelectionValid = false;
+            reallocateVolumetricResources();
+        }
     }
 
     if (debugOverlayVisible_) {
@@ -290,28 +347,44 @@ void Renderer::update(float deltaSeconds) {
     // Process movement based on current input
     processMovement(deltaSeconds);
     
-    // Update chunks based on camera position
+    // Update chunks based on camera position, then swap in a few finished ones
     updateChunks();
+    publishStreamedChunks(chunkPublishBudget_);
     
     // Rebuild geometry if chunks changed
     rebuildGeometryIfNeeded();
     
-    // Update debug chunk visualization if debug mode is enabled
-    if (debugVisualizationMode_ && debugChunkPipeline_) {
-        updateDebugChunkGeometry();
-    }
-    
     checkShaderReload();
 }
 
 void Renderer::drawFrame() {
-    vkWaitForFences(device_, 1, &inFlightFence_, VK_TRUE, UINT64_MAX);
-    vkResetFences(device_, 1, &inFlightFence_);
+    FrameSync& frame = frames_[currentFrame_];
+    vkWaitForFences(device_, 1, &frame.inFlight, VK_TRUE, UINT64_MAX);
+
+    // The last frame submitted from this slot is done, and with one queue so is
+    // every frame before it: objects retired up to then can go and the staging
+    // space their uploads came from can be reused
+    releaseRetiredResources(frame.frameNumber);
+    reclaimUploadSpace(frame.frameNumber);
+    if (postProcessingDescriptorsStale_[currentFrame_]) {
+        writePostProcessingDescriptors(postProcessingDescriptorSets_[currentFrame_]);
+        postProcessingDescriptorsStale_[currentFrame_] = false;
+    }
 
     uint32_t imageIndex = 0;
-    VkResult acquireRes = vkAcquireNextImageKHR(device_, swapchain_, UINT64_MAX, imageAvailableSemaphore_, VK_NULL_HANDLE, &imageIndex);
+    VkResult acquireRes = vkAcquireNextImageKHR(device_, swapchain_, UINT64_MAX, frame.imageAvailable, VK_NULL_HANDLE, &imageIndex);
     if (acquireRes == VK_ERROR_OUT_OF_DATE_KHR) { recreateSwapchain(); return; }
 
+    // Only reset once a submit is certain, an early return must leave the fence signalled
+    vkResetFences(device_, 1, &frame.inFlight);
+    frameNumber_++;
+    frame.frameNumber = frameNumber_;
+
+    // This slot's per-frame buffers are free to write from here on
+    if (debugVisualizationMode_ && debugChunkPipeline_) {
+        updateDebugChunkGeometry();
+    }
+
     // Update UBO
     UniformBufferObject ubo{};
     
@@ -371,7 +444,7 @@ void Renderer::drawFrame() {
     ubo.texTiling = 1.0f;
     ubo.textureCount = static_cast<float>(std::max(1, numBuildingTextures_));
     
-    std::memcpy(uniformBuffers_[0].mapped, &ubo, sizeof(ubo));
+    std::memcpy(uniformBuffers_[currentFrame_].mapped, &ubo, sizeof(ubo));
 
     glm::mat4 viewProj = proj * view;
     updateVolumetricConstants(view, proj, nearPlane, farPlane);
@@ -386,7 +459,7 @@ void Renderer::drawFrame() {
     frameCounter_++;
     
     // Update post-processing UBO (disable effects in debug visualization mode for clearer wireframe view)
-    if (postProcessingUBO_.mapped) {
+    if (postProcessingUBOs_[currentFrame_].mapped) {
         PostProcessingUBO ppUBO{};
         if (debugVisualizationMode_) {
             // Debug mode: bypass all effects for clear wireframe visualization
@@ -434,31 +507,32 @@ void Renderer::drawFrame() {
         ppUBO.sunWorldDir[2] = -skyLightDir_.z;
         ppUBO._pad = 0.0f;  // Padding
         
-        std::memcpy(postProcessingUBO_.mapped, &ppUBO, sizeof(ppUBO));
+        std::memcpy(postProcessingUBOs_[currentFrame_].mapped, &ppUBO, sizeof(ppUBO));
     }
 
-    vkResetCommandBuffer(commandBuffers_[imageIndex], 0);
-    recordCommandBuffer(commandBuffers_[imageIndex], imageIndex);
+    vkResetCommandBuffer(frame.commandBuffer, 0);
+    recordCommandBuffer(frame.commandBuffer, imageIndex);
 
     VkPipelineStageFlags waitStages[] = { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT };
     VkSubmitInfo submitInfo{ VK_STRUCTURE_TYPE_SUBMIT_INFO };
     submitInfo.waitSemaphoreCount = 1;
-    submitInfo.pWaitSemaphores = &imageAvailableSemaphore_;
+    submitInfo.pWaitSemaphores = &frame.imageAvailable;
     submitInfo.pWaitDstStageMask = waitStages;
     submitInfo.commandBufferCount = 1;
-    submitInfo.pCommandBuffers = &commandBuffers_[imageIndex];
+    submitInfo.pCommandBuffers = &frame.commandBuffer;
     submitInfo.signalSemaphoreCount = 1;
-    submitInfo.pSignalSemaphores = &renderFinishedSemaphore_;
-    vkQueueSubmit(graphicsQueue_, 1, &submitInfo, inFlightFence_);
+    submitInfo.pSignalSemaphores = &renderFinished_[imageIndex];
+    vkQueueSubmit(graphicsQueue_, 1, &submitInfo, frame.inFlight);
 
     VkPresentInfoKHR presentInfo{ VK_STRUCTURE_TYPE_PRESENT_INFO_KHR };
     presentInfo.waitSemaphoreCount = 1;
-    presentInfo.pWaitSemaphores = &renderFinishedSemaphore_;
+    presentInfo.pWaitSemaphores = &renderFinished_[imageIndex];
     presentInfo.swapchainCount = 1;
     presentInfo.pSwapchains = &swapchain_;
     presentInfo.pImageIndices = &imageIndex;
 
     VkResult presentRes = vkQueuePresentKHR(presentQueue_, &presentInfo);
+    currentFrame_ = (currentFrame_ + 1) % kMaxFramesInFlight;
     if (presentRes == VK_ERROR_OUT_OF_DATE_KHR || presentRes == VK_SUBOPTIMAL_KHR) {
         recreateSwapchain();
     }
@@ -479,12 +553,7 @@ bool Renderer::createDepthResources() {
     ci.tiling = VK_IMAGE_TILING_OPTIMAL;
     ci.usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
     if (vkCreateImage(device_, &ci, nullptr, &depthImage_) != VK_SUCCESS) return false;
-    VkMemoryRequirements req; vkGetImageMemoryRequirements(device_, depthImage_, &req);
-    VkMemoryAllocateInfo ai{ VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO };
-    ai.allocationSize = req.size;
-    ai.memoryTypeIndex = findMemoryType(req.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-    if (vkAllocateMemory(device_, &ai, nullptr, &depthImageMemory_) != VK_SUCCESS) return false;
-    vkBindImageMemory(device_, depthImage_, depthImageMemory_, 0);
+    if (!allocator_.allocateForImage(depthImage_, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, depthImageMemory_)) return false;
 
     VkImageViewCreateInfo vi{ VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO };
     vi.image = depthImage_;
@@ -494,7 +563,7 @@ bool Renderer::createDepthResources() {
     vi.subresourceRange.levelCount = 1; vi.subresourceRange.layerCount = 1;
     if (vkCreateImageView(device_, &vi, nullptr, &depthImageView_) != VK_SUCCESS) return false;
 
-    if (postProcessingDescriptorSet_ != VK_NULL_HANDLE) {
+    if (postProcessingDescriptorSets_[0] != VK_NULL_HANDLE) {
         updatePostProcessingDescriptors();
     }
     return true;
@@ -518,18 +587,24 @@ bool Renderer::createCommandPoolAndBuffers() {
     pci.queueFamilyIndex = graphicsQueueFamily_;
     pci.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
     if (vkCreateCommandPool(device_, &pci, nullptr, &commandPool_) != VK_SUCCESS) return false;
-    commandBuffers_.resize(framebuffers_.size());
     VkCommandBufferAllocateInfo ai{ VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO };
-    ai.commandPool = commandPool_; ai.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY; ai.commandBufferCount = (uint32_t)commandBuffers_.size();
-    return vkAllocateCommandBuffers(device_, &ai, commandBuffers_.data()) == VK_SUCCESS;
+    ai.commandPool = commandPool_; ai.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY; ai.commandBufferCount = 1;
+    for (auto& frame : frames_) {
+        if (vkAllocateCommandBuffers(device_, &ai, &frame.commandBuffer) != VK_SUCCESS) return false;
+    }
+    return true;
 }
 
 bool Renderer::createSyncObjects() {
     VkSemaphoreCreateInfo si{ VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO };
     VkFenceCreateInfo fi{ VK_STRUCTURE_TYPE_FENCE_CREATE_INFO }; fi.flags = VK_FENCE_CREATE_SIGNALED_BIT;
-    return vkCreateSemaphore(device_, &si, nullptr, &imageAvailableSemaphore_) == VK_SUCCESS &&
-           vkCreateSemaphore(device_, &si, nullptr, &renderFinishedSemaphore_) == VK_SUCCESS &&
-           vkCreateFence(device_, &fi, nullptr, &inFlightFence_) == VK_SUCCESS;
+    for (auto& frame : frames_) {
+        if (vkCreateSemaphore(device_, &si, nullptr, &frame.imageAvailable) != VK_SUCCESS ||
+            vkCreateFence(device_, &fi, nullptr, &frame.inFlight) != VK_SUCCESS) {
+            return false;
+        }
+    }
+    return true;
 }
 
 bool Renderer::createVertexIndexBuffers() {
@@ -559,22 +634,15 @@ bool Renderer::createVertexIndexBuffers() {
     bi.size = sizeof(v);
     bi.usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT;
     if (vkCreateBuffer(device_, &bi, nullptr, &vertexBuffer_) != VK_SUCCESS) return false;
-    VkMemoryRequirements req{}; vkGetBufferMemoryRequirements(device_, vertexBuffer_, &req);
-    VkMemoryAllocateInfo ai{ VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO };
-    ai.allocationSize = req.size; ai.memoryTypeIndex = findMemoryType(req.memoryTypeBits, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
-    if (vkAllocateMemory(device_, &ai, nullptr, &vertexBufferMemory_) != VK_SUCCESS) return false;
-    vkBindBufferMemory(device_, vertexBuffer_, vertexBufferMemory_, 0);
-    void* data = nullptr; vkMapMemory(device_, vertexBufferMemory_, 0, bi.size, 0, &data); std::memcpy(data, v, sizeof(v)); vkUnmapMemory(device_, vertexBufferMemory_);
+    if (!allocator_.allocateForBuffer(vertexBuffer_, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, vertexBufferMemory_, GpuAllocationStrategy::Linear)) return false;
+    std::memcpy(vertexBufferMemory_.mapped, v, sizeof(v));
 
     VkBufferCreateInfo ib{ VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO };
     ib.size = sizeof(idx);
     ib.usage = VK_BUFFER_USAGE_INDEX_BUFFER_BIT;
     if (vkCreateBuffer(device_, &ib, nullptr, &indexBuffer_) != VK_SUCCESS) return false;
-    vkGetBufferMemoryRequirements(device_, indexBuffer_, &req);
-    ai.allocationSize = req.size; ai.memoryTypeIndex = findMemoryType(req.memoryTypeBits, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
-    if (vkAllocateMemory(device_, &ai, nullptr, &indexBufferMemory_) != VK_SUCCESS) return false;
-    vkBindBufferMemory(device_, indexBuffer_, indexBufferMemory_, 0);
-    data = nullptr; vkMapMemory(device_, indexBufferMemory_, 0, ib.size, 0, &data); std::memcpy(data, idx, sizeof(idx)); vkUnmapMemory(device_, indexBufferMemory_);
+    if (!allocator_.allocateForBuffer(indexBuffer_, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, indexBufferMemory_, GpuAllocationStrategy::Linear)) return false;
+    std::memcpy(indexBufferMemory_.mapped, idx, sizeof(idx));
     return true;
 }
 
@@ -582,6 +650,9 @@ void Renderer::recordCommandBuffer(VkCommandBuffer cmd, uint32_t imageIndex) {
     VkCommandBufferBeginInfo bi{ VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO };
     vkBeginCommandBuffer(cmd, &bi);
     
+    // Geometry uploaded since the last frame, before anything draws from it
+    recordPendingUploads(cmd);
+    
     // Render shadow map first
     renderShadowMap(cmd);
 
@@ -618,23 +689,29 @@ void Renderer::recordCommandBuffer(VkCommandBuffer cmd, uint32_t imageIndex) {
     hdrRP.clearValueCount = (uint32_t)clears.size(); hdrRP.pClearValues = clears.data();
     vkCmdBeginRenderPass(cmd, &hdrRP, VK_SUBPASS_CONTENTS_INLINE);
     
-    // Render ground planes first (same pipeline as buildings)
+    // Render ground planes first (per-vertex city pipeline)
     VkPipeline cityPipeline = debugVisualizationMode_ ? graphicsPipelineWireframe_ : graphicsPipeline_;
     vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, cityPipeline);
-    vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout_, 0, 1, &descriptorSets_[0], 0, nullptr);
+    vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout_, 0, 1, &descriptorSets_[currentFrame_], 0, nullptr);
+    
+    // Chunks whose bounds are outside the view frustum are skipped entirely
+    std::vector<const ChunkGeometry*> visibleChunks;
+    visibleChunks.reserve(chunkGeometry_.size());
+    for (const auto& entry : chunkGeometry_) {
+        if (viewFrustum_.intersectsAABB(entry.second.bounds)) {
+            visibleChunks.push_back(&entry.second);
+        }
+    }
     
-    if (groundIndexCount_ > 0) {
-        VkDeviceSize offs = 0;
-        vkCmdBindVertexBuffers(cmd, 0, 1, &groundVertexBuffer_, &offs);
-        vkCmdBindIndexBuffer(cmd, groundIndexBuffer_, 0, VK_INDEX_TYPE_UINT32);
-        vkCmdDrawIndexed(cmd, groundIndexCount_, 1, 0, 0, 0);
+    for (const ChunkGeometry* geometry : visibleChunks) {
+        drawChunkSection(cmd, *geometry, geometry->ground);
     }
     
-    // Render city buildings to HDR (wireframe in debug visualization mode)
-    VkDeviceSize offs = 0; 
-    vkCmdBindVertexBuffers(cmd, 0, 1, &cityVertexBuffer_, &offs);
-    vkCmdBindIndexBuffer(cmd, cityIndexBuffer_, 0, VK_INDEX_TYPE_UINT32);  // Changed from UINT16 to UINT32
-    vkCmdDrawIndexed(cmd, cityIndexCount_, 1, 0, 0, 0);
+    // Render city buildings to HDR as box instances (wireframe in debug visualization mode)
+    vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, debugVisualizationMode_ ? cityBoxPipelineWireframe_ : cityBoxPipeline_);
+    for (const ChunkGeometry* geometry : visibleChunks) {
+        drawChunkBuildings(cmd, *geometry);
+    }
     
     // Render shadow volumes (stencil-only rendering, skip in debug mode)
     if (!debugVisualizationMode_ && shadowVolumesEnabled_) {
@@ -644,10 +721,10 @@ void Renderer::recordCommandBuffer(VkCommandBuffer cmd, uint32_t imageIndex) {
     // Render neon lights with premultiplied alpha blending to HDR (skip in debug visualization mode)
     if (!debugVisualizationMode_ && neonPipeline_ && neonIndexCount_ > 0) {
         vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, neonPipeline_);
-        vkCmdBindVertexBuffers(cmd, 0, 1, &neonVertexBuffer_, &offs);
-        vkCmdBindIndexBuffer(cmd, neonIndexBuffer_, 0, VK_INDEX_TYPE_UINT16);
-        vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout_, 0, 1, &descriptorSets_[0], 0, nullptr);
-        vkCmdDrawIndexed(cmd, neonIndexCount_, 1, 0, 0, 0);
+        vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout_, 0, 1, &descriptorSets_[currentFrame_], 0, nullptr);
+        for (const ChunkGeometry* geometry : visibleChunks) {
+            drawChunkSection(cmd, *geometry, geometry->neon);
+        }
     }
     
     // Render debug chunk boundaries in debug visualization mode
@@ -765,13 +842,7 @@ bool Renderer::createHDRRenderTarget() {
     
     if (vkCreateImage(device_, &imageInfo, nullptr, &hdrColorImage_) != VK_SUCCESS) return false;
     
-    VkMemoryRequirements memReq;
-    vkGetImageMemoryRequirements(device_, hdrColorImage_, &memReq);
-    VkMemoryAllocateInfo allocInfo{ VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO };
-    allocInfo.allocationSize = memReq.size;
-    allocInfo.memoryTypeIndex = findMemoryType(memReq.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-    if (vkAllocateMemory(device_, &allocInfo, nullptr, &hdrColorMemory_) != VK_SUCCESS) return false;
-    vkBindImageMemory(device_, hdrColorImage_, hdrColorMemory_, 0);
+    if (!allocator_.allocateForImage(hdrColorImage_, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, hdrColorMemory_)) return false;
     
     // Create image view
     VkImageViewCreateInfo viewInfo{ VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO };
@@ -856,7 +927,7 @@ bool Renderer::createHDRRenderTarget() {
     fbInfo.layers = 1;
     if (vkCreateFramebuffer(device_, &fbInfo, nullptr, &hdrFramebuffer_) != VK_SUCCESS) return false;
     
-    if (postProcessingDescriptorSet_ != VK_NULL_HANDLE) {
+    if (postProcessingDescriptorSets_[0] != VK_NULL_HANDLE) {
         updatePostProcessingDescriptors();
     }
 
@@ -886,13 +957,7 @@ bool Renderer::createBloomTextures() {
     
     if (vkCreateImage(device_, &imageInfo, nullptr, &bloomImages_[0]) != VK_SUCCESS) return false;
     
-    VkMemoryRequirements memReq;
-    vkGetImageMemoryRequirements(device_, bloomImages_[0], &memReq);
-    VkMemoryAllocateInfo allocInfo{ VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO };
-    allocInfo.allocationSize = memReq.size;
-    allocInfo.memoryTypeIndex = findMemoryType(memReq.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-    if (vkAllocateMemory(device_, &allocInfo, nullptr, &bloomMemories_[0]) != VK_SUCCESS) return false;
-    vkBindImageMemory(device_, bloomImages_[0], bloomMemories_[0], 0);
+    if (!allocator_.allocateForImage(bloomImages_[0], VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, bloomMemories_[0])) return false;
     
     // Create image view
     VkImageViewCreateInfo viewInfo{ VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO };
@@ -939,7 +1004,7 @@ bool Renderer::createBloomTextures() {
     fbInfo.layers = 1;
     if (vkCreateFramebuffer(device_, &fbInfo, nullptr, &bloomFramebuffers_[0]) != VK_SUCCESS) return false;
     
-    if (postProcessingDescriptorSet_ != VK_NULL_HANDLE) {
+    if (postProcessingDescriptorSets_[0] != VK_NULL_HANDLE) {
         updatePostProcessingDescriptors();
     }
 
@@ -1141,67 +1206,58 @@ bool Renderer::createPostProcessingDescriptorSet() {
     bufferInfo.usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT;
     if (vkCreateBuffer(device_, &bufferInfo, nullptr, &fullscreenQuadBuffer_) != VK_SUCCESS) return false;
     
-    VkMemoryRequirements memReq;
-    vkGetBufferMemoryRequirements(device_, fullscreenQuadBuffer_, &memReq);
-    VkMemoryAllocateInfo allocInfo{ VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO };
-    allocInfo.allocationSize = memReq.size;
-    allocInfo.memoryTypeIndex = findMemoryType(memReq.memoryTypeBits, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
-    if (vkAllocateMemory(device_, &allocInfo, nullptr, &fullscreenQuadBufferMemory_) != VK_SUCCESS) return false;
-    vkBindBufferMemory(device_, fullscreenQuadBuffer_, fullscreenQuadBufferMemory_, 0);
-    
-    void* data = nullptr;
-    vkMapMemory(device_, fullscreenQuadBufferMemory_, 0, bufferInfo.size, 0, &data);
-    std::memcpy(data, quadVertices, sizeof(quadVertices));
-    vkUnmapMemory(device_, fullscreenQuadBufferMemory_);
+    if (!allocator_.allocateForBuffer(fullscreenQuadBuffer_, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                                      fullscreenQuadBufferMemory_, GpuAllocationStrategy::Linear)) return false;
+    std::memcpy(fullscreenQuadBufferMemory_.mapped, quadVertices, sizeof(quadVertices));
     
-    // Create descriptor pool
+    // Create descriptor pool, one set per frame in flight
     VkDescriptorPoolSize poolSizes[2]{};
     poolSizes[0].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-    poolSizes[0].descriptorCount = 1;
+    poolSizes[0].descriptorCount = kMaxFramesInFlight;
     poolSizes[1].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-    poolSizes[1].descriptorCount = 6; // HDR + bloom + depth + scattering + transmittance + anamorphicBloom
+    poolSizes[1].descriptorCount = 6 * kMaxFramesInFlight; // HDR + bloom + depth + scattering + transmittance + anamorphicBloom
     
     VkDescriptorPoolCreateInfo poolInfo{ VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO };
-    poolInfo.maxSets = 1;
+    poolInfo.maxSets = kMaxFramesInFlight;
     poolInfo.poolSizeCount = 2;
     poolInfo.pPoolSizes = poolSizes;
     if (vkCreateDescriptorPool(device_, &poolInfo, nullptr, &postProcessingDescriptorPool_) != VK_SUCCESS) return false;
     
-    // Allocate descriptor set
+    // Allocate descriptor sets
+    std::array<VkDescriptorSetLayout, kMaxFramesInFlight> setLayouts;
+    setLayouts.fill(postProcessingDescriptorLayout_);
     VkDescriptorSetAllocateInfo descAllocInfo{ VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO };
     descAllocInfo.descriptorPool = postProcessingDescriptorPool_;
-    descAllocInfo.descriptorSetCount = 1;
-    descAllocInfo.pSetLayouts = &postProcessingDescriptorLayout_;
-    if (vkAllocateDescriptorSets(device_, &descAllocInfo, &postProcessingDescriptorSet_) != VK_SUCCESS) return false;
-    
-    // Create UBO for post-processing
-    VkBufferCreateInfo uboBufferInfo{ VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO };
-    uboBufferInfo.size = sizeof(PostProcessingUBO);
-    uboBufferInfo.usage = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT;
-    if (vkCreateBuffer(device_, &uboBufferInfo, nullptr, &postProcessingUBO_.buffer) != VK_SUCCESS) return false;
-    
-    VkMemoryRequirements uboMemReq;
-    vkGetBufferMemoryRequirements(device_, postProcessingUBO_.buffer, &uboMemReq);
-    VkMemoryAllocateInfo memAlloc{ VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO };
-    memAlloc.allocationSize = uboMemReq.size;
-    memAlloc.memoryTypeIndex = findMemoryType(uboMemReq.memoryTypeBits, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
-    if (vkAllocateMemory(device_, &memAlloc, nullptr, &postProcessingUBO_.memory) != VK_SUCCESS) return false;
-    vkBindBufferMemory(device_, postProcessingUBO_.buffer, postProcessingUBO_.memory, 0);
-    vkMapMemory(device_, postProcessingUBO_.memory, 0, uboMemReq.size, 0, &postProcessingUBO_.mapped);
-    
-    // Update descriptor set
-    VkDescriptorBufferInfo uboInfo{};
-    uboInfo.buffer = postProcessingUBO_.buffer;
-    uboInfo.offset = 0;
-    uboInfo.range = sizeof(PostProcessingUBO);
-    
-    VkWriteDescriptorSet uboWrite{ VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET };
-    uboWrite.dstSet = postProcessingDescriptorSet_;
-    uboWrite.dstBinding = 0;
-    uboWrite.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-    uboWrite.descriptorCount = 1;
-    uboWrite.pBufferInfo = &uboInfo;
-    vkUpdateDescriptorSets(device_, 1, &uboWrite, 0, nullptr);
+    descAllocInfo.descriptorSetCount = kMaxFramesInFlight;
+    descAllocInfo.pSetLayouts = setLayouts.data();
+    if (vkAllocateDescriptorSets(device_, &descAllocInfo, postProcessingDescriptorSets_.data()) != VK_SUCCESS) return false;
+    
+    // Create a UBO for post-processing per frame in flight
+    for (uint32_t i = 0; i < kMaxFramesInFlight; ++i) {
+        BufferWithMemory& ubo = postProcessingUBOs_[i];
+        VkBufferCreateInfo uboBufferInfo{ VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO };
+        uboBufferInfo.size = sizeof(PostProcessingUBO);
+        uboBufferInfo.usage = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT;
+        if (vkCreateBuffer(device_, &uboBufferInfo, nullptr, &ubo.buffer) != VK_SUCCESS) return false;
+        
+        if (!allocator_.allocateForBuffer(ubo.buffer, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                                          ubo.memory, GpuAllocationStrategy::Linear)) return false;
+        ubo.mapped = ubo.memory.mapped;
+        
+        // Update descriptor set
+        VkDescriptorBufferInfo uboInfo{};
+        uboInfo.buffer = ubo.buffer;
+        uboInfo.offset = 0;
+        uboInfo.range = sizeof(PostProcessingUBO);
+        
+        VkWriteDescriptorSet uboWrite{ VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET };
+        uboWrite.dstSet = postProcessingDescriptorSets_[i];
+        uboWrite.dstBinding = 0;
+        uboWrite.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+        uboWrite.descriptorCount = 1;
+        uboWrite.pBufferInfo = &uboInfo;
+        vkUpdateDescriptorSets(device_, 1, &uboWrite, 0, nullptr);
+    }
 
     updatePostProcessingDescriptors();
     
@@ -1209,7 +1265,20 @@ bool Renderer::createPostProcessingDescriptorSet() {
 }
 
 void Renderer::updatePostProcessingDescriptors() {
-    if (!postProcessingDescriptorSet_ || !textureSampler_) {
+    if (!postProcessingDescriptorSets_[0] || !textureSampler_) {
+        return;
+    }
+
+    // Only called with the device idle, every frame's set can be rewritten
+    for (uint32_t frame = 0; frame < kMaxFramesInFlight; ++frame) {
+        writePostProcessingDescriptors(postProcessingDescriptorSets_[frame]);
+        postProcessingDescriptorsStale_[frame] = false;
+    }
+}
+
+// The set must not be in use by a frame in flight
+void Renderer::writePostProcessingDescriptors(VkDescriptorSet set) {
+    if (!set || !textureSampler_) {
         return;
     }
 
@@ -1256,7 +1325,7 @@ void Renderer::updatePostProcessingDescriptors() {
     VkWriteDescriptorSet writes[6]{};
     for (auto& w : writes) {
         w.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-        w.dstSet = postProcessingDescriptorSet_;
+        w.dstSet = set;
         w.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
         w.descriptorCount = 1;
     }
@@ -1290,7 +1359,7 @@ void Renderer::renderBloom(VkCommandBuffer cmd) {
 void Renderer::renderPostProcessing(VkCommandBuffer cmd, uint32_t imageIndex) {
     // Render fullscreen quad with post-processing shader
     vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, postProcessingPipeline_);
-    vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, postProcessingLayout_, 0, 1, &postProcessingDescriptorSet_, 0, nullptr);
+    vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, postProcessingLayout_, 0, 1, &postProcessingDescriptorSets_[currentFrame_], 0, nullptr);
     VkDeviceSize offset = 0;
     vkCmdBindVertexBuffers(cmd, 0, 1, &fullscreenQuadBuffer_, &offset);
     vkCmdDraw(cmd, 4, 1, 0, 0); // Draw quad (2 triangles)
@@ -1298,7 +1367,7 @@ void Renderer::renderPostProcessing(VkCommandBuffer cmd, uint32_t imageIndex) {
 
 void Renderer::updateChunks() {
     CityGenerator* gen = static_cast<CityGenerator*>(cityGenerator_);
-    if (!gen) return;
+    if (!gen || !chunkStreamer_) return;
     
     float chunkSize = gen->getChunkSize();
     
@@ -1327,7 +1396,6 @@ void Renderer::updateChunks() {
     
     // Calculate radius of chunks to keep loaded (in chunk units)
     int loadRadius = static_cast<int>(std::ceil(chunkLoadDistance_ / chunkSize));
-    int unloadRadius = static_cast<int>(std::ceil(chunkUnloadDistance_ / chunkSize));
     
     // Find chunks within load distance
     for (int x = currentChunkX - loadRadius; x <= currentChunkX + loadRadius; ++x) {
@@ -1335,14 +1403,10 @@ void Renderer::updateChunks() {
             auto chunkKey = std::make_pair(x, z);
             
             // Check if chunk is within load distance
-            float chunkCenterX = (x + 0.5f) * chunkSize;
-            float chunkCenterZ = (z + 0.5f) * chunkSize;
-            float dx = camX - chunkCenterX;
-            float dz = camZ - chunkCenterZ;
-            float distSq = dx * dx + dz * dz;
-            
-            if (distSq <= chunkLoadDistance_ * chunkLoadDistance_) {
-                if (activeChunks_.find(chunkKey) == activeChunks_.end()) {
+            if (chunkDistanceSq(x, z) <= chunkLoadDistance_ * chunkLoadDistance_) {
+                if (activeChunks_.find(chunkKey) == activeChunks_.end() &&
+                    failedChunks_.find(chunkKey) == failedChunks_.end() &&
+                    !chunkStreamer_->isPending(x, z)) {
                     chunksToLoad.insert(chunkKey);
                 }
             }
@@ -1351,129 +1415,121 @@ void Renderer::updateChunks() {
     
     // Find chunks to unload (outside unload distance) - DON'T ERASE YET
     for (const auto& chunkKey : activeChunks_) {
-        int x = chunkKey.first;
-        int z = chunkKey.second;
-        float chunkCenterX = (x + 0.5f) * chunkSize;
-        float chunkCenterZ = (z + 0.5f) * chunkSize;
-        float dx = camX - chunkCenterX;
-        float dz = camZ - chunkCenterZ;
-        float distSq = dx * dx + dz * dz;
-        
-        if (distSq > chunkUnloadDistance_ * chunkUnloadDistance_) {
+        if (chunkDistanceSq(chunkKey.first, chunkKey.second) > chunkUnloadDistance_ * chunkUnloadDistance_) {
             chunksToUnload.insert(chunkKey);
         }
     }
     
-    // SIMPLIFIED APPROACH: Never do full regeneration, just keep accumulating chunks
-    // and rebuild geometry as needed. This prevents thrashing and building loss.
-    // We'll only clear chunks when memory becomes an actual issue (not implemented yet).
-    static size_t lastUnloadCount = 0;
-    if (!chunksToUnload.empty() && chunksToUnload.size() != lastUnloadCount) {
-        printf("⚠️  Would unload %zu chunks, but keeping them to prevent thrashing (total active: %zu)\n", 
-               chunksToUnload.size(), activeChunks_.size());
-        lastUnloadCount = chunksToUnload.size();
-        // Don't actually unload anything - just keep growing the city
-        // Future optimization: implement proper per-chunk removal without full regeneration
+    // A failed chunk gets one more attempt after the camera has left and come back
+    for (auto it = failedChunks_.begin(); it != failedChunks_.end();) {
+        if (chunkDistanceSq(it->first, it->second) > chunkUnloadDistance_ * chunkUnloadDistance_) {
+            it = failedChunks_.erase(it);
+        } else {
+            ++it;
+        }
     }
     
-    // Load new chunks (simple case - no index corruption when only adding)
-    if (!chunksToLoad.empty()) {
-        printf("📍 Loading %zu new chunks (current total: %zu buildings, %zu active chunks)\n", 
-               chunksToLoad.size(), gen->getBuildings().size(), activeChunks_.size());
-    }
-    for (const auto& chunkKey : chunksToLoad) {
-        printf("+ Chunk (%d, %d)\n", chunkKey.first, chunkKey.second);
-        gen->generateChunk(chunkKey.first, chunkKey.second, 42);
-        activeChunks_.insert(chunkKey);
+    // Evict chunks beyond the unload distance. Every chunk owns its data and GPU
+    // buffers, so dropping one frees exactly its memory; the gap between the load and unload
+    // distances keeps chunks on the border from thrashing.
+    if (!chunksToUnload.empty()) {
+        for (const auto& chunkKey : chunksToUnload) {
+            gen->removeChunk(chunkKey.first, chunkKey.second);
+            releaseChunkGeometry(chunkKey);
+            activeChunks_.erase(chunkKey);
+        }
         geometryNeedsRebuild_ = true;
+        printf("🗑️  Unloaded %zu chunks (%zu active, %zu buildings)\n", 
+               chunksToUnload.size(), activeChunks_.size(), gen->getBuildingCount());
     }
+    
+    // Request new chunks, nearest first. Generation and meshing run on the worker
+    // pool; finished chunks are swapped in by publishStreamedChunks().
     if (!chunksToLoad.empty()) {
-        printf("✅ After loading: %zu buildings total\n", gen->getBuildings().size());
+        std::vector<std::pair<int, int>> requests(chunksToLoad.begin(), chunksToLoad.end());
+        std::sort(requests.begin(), requests.end(), [this](const std::pair<int, int>& a, const std::pair<int, int>& b) {
+            return chunkDistanceSq(a.first, a.second) < chunkDistanceSq(b.first, b.second);
+        });
+        
+        printf("📍 Requesting %zu new chunks (current total: %zu buildings, %zu active chunks, %zu streaming)\n", 
+               requests.size(), gen->getBuildingCount(), activeChunks_.size(), chunkStreamer_->getPendingCount());
+        for (const auto& chunkKey : requests) {
+            printf("+ Chunk (%d, %d)\n", chunkKey.first, chunkKey.second);
+            chunkStreamer_->request(chunkKey.first, chunkKey.second, 42);
+        }
     }
 }
 
-void Renderer::rebuildGeometryIfNeeded() {
-    if (!geometryNeedsRebuild_) return;
-    
-    geometryNeedsRebuild_ = false;
-    
+size_t Renderer::publishStreamedChunks(size_t maxChunks) {
     CityGenerator* gen = static_cast<CityGenerator*>(cityGenerator_);
-    printf("🔨 Rebuild: %zu buildings, %zu neons, %zu light volumes\n", 
-           gen->getBuildings().size(), gen->getNeonLights().size(), gen->getLightVolumes().size());
-    
-    // Regenerate volumetric lights/densities for new chunks
-    updateVolumetricLights();
-    updateVolumetricDensities();
-    printf("   💡 Updated volumetrics: %u lights, %u densities\n", 
-           volumetricLightCount_, volumetricDensityCount_);
+    if (!gen || !chunkStreamer_) return 0;
     
-    // Wait for GPU to finish before rebuilding
-    vkDeviceWaitIdle(device_);
+    std::vector<StreamedChunk> finished;
+    chunkStreamer_->collectReady(maxChunks, finished);
+    if (finished.empty()) return 0;
     
-    // Clean up old geometry buffers
-    if (cityVertexBuffer_) {
-        vkDestroyBuffer(device_, cityVertexBuffer_, nullptr);
-        cityVertexBuffer_ = VK_NULL_HANDLE;
-    }
-    if (cityVertexBufferMemory_) {
-        vkFreeMemory(device_, cityVertexBufferMemory_, nullptr);
-        cityVertexBufferMemory_ = VK_NULL_HANDLE;
-    }
-    if (cityIndexBuffer_) {
-        vkDestroyBuffer(device_, cityIndexBuffer_, nullptr);
-        cityIndexBuffer_ = VK_NULL_HANDLE;
-    }
-    if (cityIndexBufferMemory_) {
-        vkFreeMemory(device_, cityIndexBufferMemory_, nullptr);
-        cityIndexBufferMemory_ = VK_NULL_HANDLE;
+    size_t published = 0;
+    for (size_t i = 0; i < finished.size(); ++i) {
+        StreamedChunk& streamed = finished[i];
+        // The camera may have moved on while the chunk was being built
+        if (chunkDistanceSq(streamed.chunk.chunkX, streamed.chunk.chunkZ) > chunkUnloadDistance_ * chunkUnloadDistance_) {
+            continue;
+        }
+        auto chunkKey = std::make_pair(streamed.chunk.chunkX, streamed.chunk.chunkZ);
+        if (!chunkGeometryFitsRing(streamed.mesh)) {
+            // Would never stage, even into an empty ring: waiting for space would stall every chunk behind it
+            printf("Geometry for chunk (%d, %d) does not fit the staging ring\n", chunkKey.first, chunkKey.second);
+            failedChunks_.insert(chunkKey);
+            continue;
+        }
+        if (!canStageChunkGeometry(streamed.mesh)) {
+            // Staging ring is full until earlier frames retire: publish the rest later
+            chunkStreamer_->putBack(finished, i);
+            break;
+        }
+        if (!uploadChunkGeometry(chunkKey, streamed.mesh)) {
+            // Rebuilding it would fail the same way: keep updateChunks from requesting it again
+            printf("Failed to upload geometry for chunk (%d, %d)\n", chunkKey.first, chunkKey.second);
+            failedChunks_.insert(chunkKey);
+            continue;
+        }
+        gen->commitChunk(std::move(streamed.chunk));
+        activeChunks_.insert(chunkKey);
+        published++;
     }
+    if (published == 0) return 0;
+    geometryNeedsRebuild_ = true;
     
-    if (neonVertexBuffer_) {
-        vkDestroyBuffer(device_, neonVertexBuffer_, nullptr);
-        neonVertexBuffer_ = VK_NULL_HANDLE;
-    }
-    if (neonVertexBufferMemory_) {
-        vkFreeMemory(device_, neonVertexBufferMemory_, nullptr);
-        neonVertexBufferMemory_ = VK_NULL_HANDLE;
-    }
-    if (neonIndexBuffer_) {
-        vkDestroyBuffer(device_, neonIndexBuffer_, nullptr);
-        neonIndexBuffer_ = VK_NULL_HANDLE;
-    }
-    if (neonIndexBufferMemory_) {
-        vkFreeMemory(device_, neonIndexBufferMemory_, nullptr);
-        neonIndexBufferMemory_ = VK_NULL_HANDLE;
-    }
+    printf("✅ Published %zu chunks: %zu buildings total, %zu still streaming\n", 
+           published, gen->getBuildingCount(), chunkStreamer_->getPendingCount());
+    return published;
+}
+
+float Renderer::chunkDistanceSq(int chunkX, int chunkZ) const {
+    float chunkSize = static_cast<CityGenerator*>(cityGenerator_)->getChunkSize();
+    float dx = cameraPos_.x - (chunkX + 0.5f) * chunkSize;
+    float dz = cameraPos_.z - (chunkZ + 0.5f) * chunkSize;
+    return dx * dx + dz * dz;
+}
+
+void Renderer::rebuildGeometryIfNeeded() {
+    if (!geometryNeedsRebuild_) return;
     
-    if (groundVertexBuffer_) {
-        vkDestroyBuffer(device_, groundVertexBuffer_, nullptr);
-        groundVertexBuffer_ = VK_NULL_HANDLE;
-    }
-    if (groundVertexBufferMemory_) {
-        vkFreeMemory(device_, groundVertexBufferMemory_, nullptr);
-        groundVertexBufferMemory_ = VK_NULL_HANDLE;
-    }
-    if (groundIndexBuffer_) {
-        vkDestroyBuffer(device_, groundIndexBuffer_, nullptr);
-        groundIndexBuffer_ = VK_NULL_HANDLE;
-    }
-    if (groundIndexBufferMemory_) {
-        vkFreeMemory(device_, groundIndexBufferMemory_, nullptr);
-        groundIndexBufferMemory_ = VK_NULL_HANDLE;
-    }
+    geometryNeedsRebuild_ = false;
     
-    // Rebuild geometry
-    if (!createCityGeometry()) {
-        printf("Failed to rebuild city geometry\n");
-    }
-    if (!createNeonGeometry()) {
-        printf("Failed to rebuild neon geometry\n");
-    }
-    if (!createGroundGeometry()) {
-        printf("Failed to rebuild ground geometry\n");
-    }
-    if (!createShadowVolumeGeometry()) {
-        printf("Failed to rebuild shadow volume geometry\n");
+    // Chunk geometry is uploaded and freed per chunk as chunks come and go; only the
+    // whole-city derived data is rebuilt here. Volumetric lights/densities are
+    // refreshed every frame in drawFrame(), after the fence wait.
+    
+    // Shadow volumes cover every building, so skip them while their pipeline is disabled
+    if (shadowVolumePipeline_) {
+        // The previous frame may still be reading the old buffers: retire them instead of
+        // waiting for the device, they are freed once that frame's fence has signalled
+        retireBuffer(shadowVolumeVertexBuffer_, shadowVolumeVertexBufferMemory_);
+        retireBuffer(shadowVolumeIndexBuffer_, shadowVolumeIndexBufferMemory_);
+        if (!createShadowVolumeGeometry()) {
+            printf("Failed to rebuild shadow volume geometry\n");
+        }
     }
     
     // Update light markers if they're enabled
@@ -1507,6 +1563,9 @@ void Renderer::renderDebugOverlayGraphical(VkCommandBuffer cmd) {
     const char* fpsColor = debug_fpsSmoothed_ >= 60.0f ? "\x1F" : // Green
                           (debug_fpsSmoothed_ >= 30.0f ? "\x1E" : "\x1D"); // Yellow : Red
     
+    GpuAllocatorStats gpuMemory = allocator_.getStats();
+    const float mb = 1.0f / (1024.0f * 1024.0f);
+    
     snprintf(overlayText, sizeof(overlayText),
         "PROCEDURAL CITY - DEBUG\n"
         "=======================\n"
@@ -1518,17 +1577,22 @@ void Renderer::renderDebugOverlayGraphical(VkCommandBuffer cmd) {
         "Light Volumes: %zu\n"
         "Vol Lights: %u\n"
         "Vol Densities: %u\n"
+        "Vol Cluster Drops: %u\n"
+        "GPU Mem: %.1f / %.1f MB (%u blocks, %u allocs, frag %.2f)\n"
         "Camera: (%.1f, %.1f, %.1f)\n"
         "Chunk: (%d, %d)\n",
         fpsColor,
         debug_fpsSmoothed_,
-        cityIndexCount_,
+        cityInstanceCount_ * 12,  // 12 triangles per box
         activeChunks_.size(),
-        static_cast<CityGenerator*>(cityGenerator_)->getBuildings().size(),
-        static_cast<CityGenerator*>(cityGenerator_)->getNeonLights().size(),
-        static_cast<CityGenerator*>(cityGenerator_)->getLightVolumes().size(),
+        static_cast<CityGenerator*>(cityGenerator_)->getBuildingCount(),
+        static_cast<CityGenerator*>(cityGenerator_)->getNeonLightCount(),
+        static_cast<CityGenerator*>(cityGenerator_)->getLightVolumeCount(),
         volumetricLightCount_,
         volumetricDensityCount_,
+        volumetricClusterDropped_,
+        gpuMemory.usedBytes * mb, gpuMemory.reservedBytes * mb,
+        gpuMemory.blockCount, gpuMemory.allocationCount, gpuMemory.fragmentation,
         cameraPos_.x, cameraPos_.y, cameraPos_.z,
         int(std::floor(cameraPos_.x / static_cast<CityGenerator*>(cityGenerator_)->getChunkSize())),
         int(std::floor(cameraPos_.z / static_cast<CityGenerator*>(cityGenerator_)->getChunkSize()))
@@ -1544,9 +1608,9 @@ void Renderer::renderDebugOverlayGraphical(VkCommandBuffer cmd) {
     vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, debugTextPipelineLayout_, 
                            0, 1, &debugTextDescriptorSet_, 0, nullptr);
     
-    VkDeviceSize offset = 0;
+    VkDeviceSize offset = currentFrame_ * kDebugTextVertexRegion;
     vkCmdBindVertexBuffers(cmd, 0, 1, &debugTextVertexBuffer_, &offset);
-    vkCmdBindIndexBuffer(cmd, debugTextIndexBuffer_, 0, VK_INDEX_TYPE_UINT16);
+    vkCmdBindIndexBuffer(cmd, debugTextIndexBuffer_, currentFrame_ * kDebugTextIndexRegion, VK_INDEX_TYPE_UINT16);
     vkCmdDrawIndexed(cmd, debugTextIndexCount_, 1, 0, 0, 0);
 }
 
@@ -1611,26 +1675,23 @@ void Renderer::updateDebugTextGeometry(const char* text, float startX, float sta
         
         vertexOffset += 4;
         x += charWidth * 0.6f; // Character spacing (monospace)
+        if (vertexOffset / 4 >= kDebugTextMaxChars) break;
     }
     
     debugTextIndexCount_ = static_cast<uint32_t>(indices.size());
     
     if (debugTextIndexCount_ == 0) return;
     
-    // Update vertex buffer
+    // Update this frame's region of the vertex buffer
     if (debugTextVertexBuffer_) {
-        void* data;
-        vkMapMemory(device_, debugTextVertexMemory_, 0, vertices.size() * sizeof(float), 0, &data);
-        memcpy(data, vertices.data(), vertices.size() * sizeof(float));
-        vkUnmapMemory(device_, debugTextVertexMemory_);
+        memcpy(static_cast<char*>(debugTextVertexMemory_.mapped) + currentFrame_ * kDebugTextVertexRegion,
+               vertices.data(), vertices.size() * sizeof(float));
     }
     
-    // Update index buffer  
+    // Update this frame's region of the index buffer
     if (debugTextIndexBuffer_) {
-        void* data;
-        vkMapMemory(device_, debugTextIndexMemory_, 0, indices.size() * sizeof(uint16_t), 0, &data);
-        memcpy(data, indices.data(), indices.size() * sizeof(uint16_t));
-        vkUnmapMemory(device_, debugTextIndexMemory_);
+        memcpy(static_cast<char*>(debugTextIndexMemory_.mapped) + currentFrame_ * kDebugTextIndexRegion,
+               indices.data(), indices.size() * sizeof(uint16_t));
     }
 }
 
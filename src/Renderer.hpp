@@ -9,14 +9,20 @@
 #include <filesystem>
 #include <memory>
 #include <set>
+#include <map>
+#include <deque>
 #include <glm/glm.hpp>
 #include "FrustumCuller.hpp"
+#include "ChunkMesh.hpp"
+#include "GpuAllocator.hpp"
 
 struct GLFWwindow;
 
 namespace pcengine {
 
 class CityGenerator;
+class WorkerPool;
+class ChunkStreamer;
 
 struct UniformBufferObject {
     float model[16];
@@ -90,6 +96,7 @@ private:
     bool createDescriptorSetLayout();
     bool createPipeline();
     bool createPipelineWireframe();  // Wireframe version of city pipeline
+    bool createCityBoxPipelines();   // Instanced building parts (fill + wireframe)
     bool createNeonPipeline();
     bool createDepthResources();
     bool createFramebuffers();
@@ -99,18 +106,43 @@ private:
     bool createUniformBuffers();
     bool createDescriptorPoolAndSets();
     bool reloadShaders();
-    bool createCityGeometry();
-    bool createNeonGeometry();
-    bool createGroundGeometry();
     void updateChunks();
+    size_t publishStreamedChunks(size_t maxChunks);
+    float chunkDistanceSq(int chunkX, int chunkZ) const;  // Camera to chunk center, XZ only
     void rebuildGeometryIfNeeded();
+    bool uploadGeometryBuffer(const void* data, VkDeviceSize size, VkBufferUsageFlags usage, VkBuffer& buffer, GpuAllocation& memory);
+    bool createBoxGeometry();
+    bool uploadChunkGeometry(const std::pair<int, int>& chunkKey, const ChunkMesh& mesh);
+    bool chunkGeometryFitsRing(const ChunkMesh& mesh) const;
+    bool canStageChunkGeometry(const ChunkMesh& mesh);
+    void releaseChunkGeometry(const std::pair<int, int>& chunkKey);
+    void retireBuffer(VkBuffer& buffer, GpuAllocation& memory);
+    void retireImage(VkImage& image, VkImageView& view, GpuAllocation& memory);
+    void retirePipeline(VkPipeline& pipeline);
+    void retirePipelineLayout(VkPipelineLayout& layout);
+    void retireDescriptorPool(VkDescriptorPool& pool);
+    void retireDescriptorSetLayout(VkDescriptorSetLayout& layout);
+    void retireSampler(VkSampler& sampler);
+    void releaseRetiredResources(uint64_t completedFrame);
+    bool createUploadRing();
+    void destroyUploadRing();
+    bool allocateUploadSpace(VkDeviceSize size, VkDeviceSize& offset);
+    bool uploadsFitRing(std::initializer_list<VkDeviceSize> sizes) const;  // Could ever stage together
+    bool canStageUploads(std::initializer_list<VkDeviceSize> sizes);  // Can stage together right now
+    bool stageBufferUpload(const void* data, VkDeviceSize size, VkBuffer dst, VkDeviceSize dstOffset);
+    void cancelPendingUploads(VkBuffer dst);
+    void recordPendingUploads(VkCommandBuffer cmd);
+    void reclaimUploadSpace(uint64_t completedFrame);
+    void flushUploadsImmediate();
     bool loadTextures();
-    bool createTextureImage(const std::string& filename, VkImage& image, VkDeviceMemory& memory);
+    bool createTextureImage(const std::string& filename, VkImage& image, GpuAllocation& memory);
     bool createTextureImageView(VkImage image, VkImageView& imageView);
     bool createTextureSampler();
     bool loadNeonTextures();
     bool createVolumetricResources();
     void destroyVolumetricResources();
+    void retireVolumetricResources();
+    void reallocateVolumetricResources();
     bool createVolumetricDescriptorSets();
     bool createVolumetricPipelines();
     void recordVolumetricPasses(VkCommandBuffer cmd);
@@ -133,13 +165,13 @@ private:
     bool createPostProcessingDescriptorSet();
     void renderPostProcessing(VkCommandBuffer cmd, uint32_t imageIndex);
     void updatePostProcessingDescriptors();
+    void writePostProcessingDescriptors(VkDescriptorSet set);
     bool createBloomTextures();
     void renderBloom(VkCommandBuffer cmd);
 
     void recreateSwapchain();
     void cleanupSwapchain();
     void recordCommandBuffer(VkCommandBuffer cmd, uint32_t imageIndex);
-    uint32_t findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties);
     VkFormat findDepthFormat();
     
     // Camera control helpers
@@ -155,12 +187,17 @@ private:
     VkQueue presentQueue_ = VK_NULL_HANDLE;
     uint32_t graphicsQueueFamily_ = 0;
     uint32_t presentQueueFamily_ = 0;
+    GpuAllocator allocator_;  // Every buffer and image gets its memory from here
 
     VkSwapchainKHR swapchain_ = VK_NULL_HANDLE;
     VkFormat swapchainFormat_ = VK_FORMAT_B8G8R8A8_UNORM;
     VkExtent2D swapchainExtent_ {0, 0};
     std::vector<VkImage> swapchainImages_;
     std::vector<VkImageView> swapchainImageViews_;
+    // Signalled by the submit, waited on by present. Per image, not per frame slot:
+    // present never says when it is done with the semaphore, but the image coming
+    // back from vkAcquireNextImageKHR means its previous present has consumed it.
+    std::vector<VkSemaphore> renderFinished_;
 
     VkRenderPass renderPass_ = VK_NULL_HANDLE;
     VkDescriptorSetLayout descriptorSetLayout_ = VK_NULL_HANDLE;
@@ -170,12 +207,12 @@ private:
     VkPipeline neonPipeline_ = VK_NULL_HANDLE;
 
     VkImage depthImage_ = VK_NULL_HANDLE;
-    VkDeviceMemory depthImageMemory_ = VK_NULL_HANDLE;
+    GpuAllocation depthImageMemory_;
     VkImageView depthImageView_ = VK_NULL_HANDLE;
 
     // Shadow map resources
     VkImage shadowMapImage_ = VK_NULL_HANDLE;
-    VkDeviceMemory shadowMapMemory_ = VK_NULL_HANDLE;
+    GpuAllocation shadowMapMemory_;
     VkImageView shadowMapView_ = VK_NULL_HANDLE;
     VkFramebuffer shadowMapFramebuffer_ = VK_NULL_HANDLE;
     VkRenderPass shadowMapRenderPass_ = VK_NULL_HANDLE;
@@ -185,89 +222,120 @@ private:
     std::vector<VkFramebuffer> framebuffers_;
 
     VkCommandPool commandPool_ = VK_NULL_HANDLE;
-    std::vector<VkCommandBuffer> commandBuffers_;
 
-    VkSemaphore imageAvailableSemaphore_ = VK_NULL_HANDLE;
-    VkSemaphore renderFinishedSemaphore_ = VK_NULL_HANDLE;
-    VkFence inFlightFence_ = VK_NULL_HANDLE;
+    // Frames the CPU may record ahead of the GPU (2 or 3, set with the
+    // PC_ENGINE_FRAMES_IN_FLIGHT CMake option). Every buffer the CPU
+    // rewrites per frame has one copy per slot, indexed by currentFrame_; a slot
+    // is only reused after its fence, so writing it never stalls on the GPU.
+#ifndef PC_ENGINE_FRAMES_IN_FLIGHT
+#define PC_ENGINE_FRAMES_IN_FLIGHT 2
+#endif
+    static constexpr uint32_t kMaxFramesInFlight = PC_ENGINE_FRAMES_IN_FLIGHT;
+    static_assert(kMaxFramesInFlight >= 2 && kMaxFramesInFlight <= 3, "2 or 3 frames in flight");
+    struct FrameSync {
+        VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+        VkSemaphore imageAvailable = VK_NULL_HANDLE;
+        VkFence inFlight = VK_NULL_HANDLE;
+        uint64_t frameNumber = 0;  // frameNumber_ of the last submission from this slot
+    };
+    std::array<FrameSync, kMaxFramesInFlight> frames_;
+    uint32_t currentFrame_ = 0;
 
     VkBuffer vertexBuffer_ = VK_NULL_HANDLE;
-    VkDeviceMemory vertexBufferMemory_ = VK_NULL_HANDLE;
+    GpuAllocation vertexBufferMemory_;
     VkBuffer indexBuffer_ = VK_NULL_HANDLE;
-    VkDeviceMemory indexBufferMemory_ = VK_NULL_HANDLE;
+    GpuAllocation indexBufferMemory_;
     
     // Fullscreen quad for post-processing
     VkBuffer fullscreenQuadBuffer_ = VK_NULL_HANDLE;
-    VkDeviceMemory fullscreenQuadBufferMemory_ = VK_NULL_HANDLE;
-    
-    // City geometry
-    VkBuffer cityVertexBuffer_ = VK_NULL_HANDLE;
-    VkDeviceMemory cityVertexBufferMemory_ = VK_NULL_HANDLE;
-    VkBuffer cityIndexBuffer_ = VK_NULL_HANDLE;
-    VkDeviceMemory cityIndexBufferMemory_ = VK_NULL_HANDLE;
-    uint32_t cityIndexCount_ = 0;
-    
-    // Ground plane geometry
-    VkBuffer groundVertexBuffer_ = VK_NULL_HANDLE;
-    VkDeviceMemory groundVertexBufferMemory_ = VK_NULL_HANDLE;
-    VkBuffer groundIndexBuffer_ = VK_NULL_HANDLE;
-    VkDeviceMemory groundIndexBufferMemory_ = VK_NULL_HANDLE;
+    GpuAllocation fullscreenQuadBufferMemory_;
+    
+    // Shared unit box for instanced building parts: pos(3) + normal(3) + corner(2)
+    VkBuffer boxVertexBuffer_ = VK_NULL_HANDLE;
+    GpuAllocation boxVertexBufferMemory_;
+    VkBuffer boxIndexBuffer_ = VK_NULL_HANDLE;
+    GpuAllocation boxIndexBufferMemory_;
+    uint32_t boxIndexCount_ = 0;
+    VkPipeline cityBoxPipeline_ = VK_NULL_HANDLE;
+    VkPipeline cityBoxPipelineWireframe_ = VK_NULL_HANDLE;
+    
+    // City, ground and neon geometry, one set of buffers per resident chunk.
+    // A chunk's sections sit back to back in its own vertex and index buffer, so
+    // loading a chunk uploads only its data and evicting it frees only its buffers.
+    // Buildings are box instances, ground and neon are indexed triangles.
+    struct ChunkGeometry {
+        struct Section {
+            VkDeviceSize vertexOffset = 0;  // Byte offset into vertexBuffer
+            uint32_t firstIndex = 0;
+            uint32_t indexCount = 0;
+        };
+        VkBuffer vertexBuffer = VK_NULL_HANDLE;
+        GpuAllocation vertexMemory;
+        VkBuffer indexBuffer = VK_NULL_HANDLE;
+        GpuAllocation indexMemory;
+        VkDeviceSize cityInstanceOffset = 0;  // Byte offset of the part instances
+        uint32_t cityInstanceCount = 0;
+        Section ground;
+        Section neon;
+        glm::vec3 origin = glm::vec3(0.0f);  // Packed positions are relative to this
+        AABB bounds;
+    };
+    void pushChunkOrigin(VkCommandBuffer cmd, const ChunkGeometry& geometry);
+    void drawChunkSection(VkCommandBuffer cmd, const ChunkGeometry& geometry, const ChunkGeometry::Section& section);
+    void drawChunkBuildings(VkCommandBuffer cmd, const ChunkGeometry& geometry);
+    std::map<std::pair<int, int>, ChunkGeometry> chunkGeometry_;
+    uint32_t cityInstanceCount_ = 0;  // Totals over all resident chunks
     uint32_t groundIndexCount_ = 0;
+    uint32_t neonIndexCount_ = 0;
     
     // Shadow volume geometry
     VkBuffer shadowVolumeVertexBuffer_ = VK_NULL_HANDLE;
-    VkDeviceMemory shadowVolumeVertexBufferMemory_ = VK_NULL_HANDLE;
+    GpuAllocation shadowVolumeVertexBufferMemory_;
     VkBuffer shadowVolumeIndexBuffer_ = VK_NULL_HANDLE;
-    VkDeviceMemory shadowVolumeIndexBufferMemory_ = VK_NULL_HANDLE;
+    GpuAllocation shadowVolumeIndexBufferMemory_;
     uint32_t shadowVolumeIndexCount_ = 0;
     VkPipeline shadowVolumePipeline_ = VK_NULL_HANDLE;
     bool shadowVolumesEnabled_ = false;  // Toggle for shadow volume rendering
-    
-    // Neon geometry
-    VkBuffer neonVertexBuffer_ = VK_NULL_HANDLE;
-    VkDeviceMemory neonVertexBufferMemory_ = VK_NULL_HANDLE;
-    VkBuffer neonIndexBuffer_ = VK_NULL_HANDLE;
-    VkDeviceMemory neonIndexBufferMemory_ = VK_NULL_HANDLE;
-    uint32_t neonIndexCount_ = 0;
 
     struct BufferWithMemory {
         VkBuffer buffer = VK_NULL_HANDLE;
-        VkDeviceMemory memory = VK_NULL_HANDLE;
+        GpuAllocation memory;
         void* mapped = nullptr;
     };
 
-    std::vector<BufferWithMemory> uniformBuffers_;
+    std::vector<BufferWithMemory> uniformBuffers_;  // One per frame in flight
     VkDescriptorPool descriptorPool_ = VK_NULL_HANDLE;
-    std::vector<VkDescriptorSet> descriptorSets_;
+    std::vector<VkDescriptorSet> descriptorSets_;  // One per frame in flight, binding 0 = uniformBuffers_[i]
 
+    // GPU light record, unpacked by vol_cluster_build.comp and vol_light_inject.comp
     struct VolumetricLightRecord {
-        glm::vec4 colorIntensity{}; // rgb = color, w = intensity multiplier
-        glm::vec4 positionRadius{}; // xyz = world position, w = radius
+        glm::vec3 position{};           // World position
+        uint32_t sizeShape = 0;         // Low 16 bits = radius or box size (half), bit 31 = box
+        uint32_t colorIntensity[2]{};   // Halves: r | g << 16, b | intensity << 16
     };
+    static_assert(sizeof(VolumetricLightRecord) == 24, "VolumetricLightRecord must match the shader layout");
 
     std::vector<VolumetricLightRecord> volumetricLights_;
     uint32_t volumetricLightCount_ = 0;
 
+    // GPU density record, unpacked by vol_density_inject.comp
     struct VolumetricDensityRecord {
-        glm::vec4 minBoundsSigma{};  // xyz = froxel min, w = sigma boost
-        glm::vec4 maxBounds{};       // xyz = froxel max, w unused
-        glm::vec4 albedo{};          // xyz = albedo, w unused
+        int16_t minCell[3]{};       // Cell min (inclusive), relative to densityCellBase
+        int16_t maxCell[3]{};       // Cell max (inclusive), relative to densityCellBase
+        uint16_t sigma = 0;         // Sigma boost (half)
+        uint16_t albedoIndex = 0;   // Into volumetricAlbedoPalette_
     };
+    static_assert(sizeof(VolumetricDensityRecord) == 16, "VolumetricDensityRecord must match the shader layout");
 
     std::vector<VolumetricDensityRecord> volumetricDensities_;
+    std::vector<glm::vec3> volumetricAlbedoPalette_;  // Shared by all density records, heads the density buffer
     uint32_t volumetricDensityCount_ = 0;
-
-    struct TemporalNeighborhood {
-        glm::vec4 minVals{0.0f};
-        glm::vec4 maxVals{0.0f};
-    };
-
-    std::vector<TemporalNeighborhood> temporalNeighborhoods_;
+    uint32_t volumetricClusterDropped_ = 0;  // Entries the last cluster build had no room for, for the overlay
 
     // Texture resources (array)
     static constexpr int kMaxBuildingTextures = 8;
     VkImage buildingTextures_[kMaxBuildingTextures] = {};
-    VkDeviceMemory buildingTextureMemories_[kMaxBuildingTextures] = {};
+    GpuAllocation buildingTextureMemories_[kMaxBuildingTextures];
     VkImageView buildingTextureViews_[kMaxBuildingTextures] = {};
     VkSampler textureSampler_ = VK_NULL_HANDLE;
     int numBuildingTextures_ = 0;
@@ -275,20 +343,20 @@ private:
 
     // Neon texture resources
     VkImage neonArrayImage_ = VK_NULL_HANDLE;
-    VkDeviceMemory neonArrayMemory_ = VK_NULL_HANDLE;
+    GpuAllocation neonArrayMemory_;
     VkImageView neonArrayView_ = VK_NULL_HANDLE;
     int numNeonTextures_ = 0; // number of layers
     
     // Post-processing resources
     VkImage hdrColorImage_ = VK_NULL_HANDLE;
-    VkDeviceMemory hdrColorMemory_ = VK_NULL_HANDLE;
+    GpuAllocation hdrColorMemory_;
     VkImageView hdrColorView_ = VK_NULL_HANDLE;
     VkFramebuffer hdrFramebuffer_ = VK_NULL_HANDLE;
     VkRenderPass hdrRenderPass_ = VK_NULL_HANDLE;
     
     // Bloom textures (downsampled)
     std::vector<VkImage> bloomImages_;
-    std::vector<VkDeviceMemory> bloomMemories_;
+    std::vector<GpuAllocation> bloomMemories_;
     std::vector<VkImageView> bloomViews_;
     std::vector<VkFramebuffer> bloomFramebuffers_;
     VkRenderPass bloomRenderPass_ = VK_NULL_HANDLE;
@@ -298,10 +366,13 @@ private:
     VkPipelineLayout postProcessingLayout_ = VK_NULL_HANDLE;
     VkDescriptorSetLayout postProcessingDescriptorLayout_ = VK_NULL_HANDLE;
     VkDescriptorPool postProcessingDescriptorPool_ = VK_NULL_HANDLE;
-    VkDescriptorSet postProcessingDescriptorSet_ = VK_NULL_HANDLE;
+    std::array<VkDescriptorSet, kMaxFramesInFlight> postProcessingDescriptorSets_{};
+    // Sets still pointing at retired volumetric images, rewritten once their
+    // frame slot's fence has signalled
+    std::array<bool, kMaxFramesInFlight> postProcessingDescriptorsStale_{};
     
-    // Post-processing uniform buffer
-    BufferWithMemory postProcessingUBO_;
+    // Post-processing uniform buffers, one per frame in flight
+    std::array<BufferWithMemory, kMaxFramesInFlight> postProcessingUBOs_;
 
     float rotation_ = 0.0f;
     float time_ = 0.0f;
@@ -309,7 +380,48 @@ private:
     
     // City generation
     void* cityGenerator_; // Opaque pointer to avoid forward declaration issues
+    WorkerPool* workerPool_ = nullptr; // Background threads for chunk generation
+    ChunkStreamer* chunkStreamer_ = nullptr; // Request -> generate + mesh on workers -> publish
+    size_t chunkPublishBudget_ = 4;  // Finished chunks swapped in per frame
+    
+    // Deferred destruction: objects replaced while submitted frames may still
+    // use them are tagged with the current frame number and destroyed once the
+    // fence of that frame has signalled, so swaps never wait on the device.
+    struct RetiredResource {
+        uint64_t frame = 0;  // Last frame that may reference the objects
+        VkBuffer buffer = VK_NULL_HANDLE;
+        VkImage image = VK_NULL_HANDLE;
+        VkImageView view = VK_NULL_HANDLE;
+        VkPipeline pipeline = VK_NULL_HANDLE;
+        VkPipelineLayout pipelineLayout = VK_NULL_HANDLE;
+        VkDescriptorPool descriptorPool = VK_NULL_HANDLE;
+        VkDescriptorSetLayout descriptorSetLayout = VK_NULL_HANDLE;
+        VkSampler sampler = VK_NULL_HANDLE;
+        GpuAllocation memory;
+    };
+    std::deque<RetiredResource> retiredResources_;  // Oldest frame first
+    uint64_t frameNumber_ = 0;  // Frame being recorded, or the last one submitted
+    
+    // Persistently mapped staging ring feeding DEVICE_LOCAL geometry buffers.
+    // Uploads queue up as copies and are recorded in one batch at the start of
+    // the next frame; their space is reclaimed once that frame's fence signals.
+    static constexpr VkDeviceSize kUploadRingSize = 8 * 1024 * 1024;
+    struct UploadRing {
+        VkBuffer buffer = VK_NULL_HANDLE;
+        GpuAllocation memory;
+        void* mapped = nullptr;
+        VkDeviceSize head = 0;  // Next write offset
+        VkDeviceSize tail = 0;  // Oldest byte the GPU may still read
+        std::deque<std::pair<uint64_t, VkDeviceSize>> batchEnds;  // (frame, head) per recorded batch, oldest first
+    };
+    struct PendingUpload {
+        VkBuffer dst;
+        VkBufferCopy region;
+    };
+    UploadRing uploadRing_;
+    std::vector<PendingUpload> pendingUploads_;
     std::set<std::pair<int, int>> activeChunks_;  // Track which chunks are currently loaded
+    std::set<std::pair<int, int>> failedChunks_;  // Upload failed; not requested again until out of range
     bool geometryNeedsRebuild_ = false;  // Flag to indicate geometry needs updating
     float chunkLoadDistance_ = 150.0f;  // Distance to load chunks (in world units)
     float chunkUnloadDistance_ = 250.0f;  // Distance to unload chunks (in world units) - moderate hysteresis
@@ -361,14 +473,18 @@ private:
     VkDescriptorPool debugTextDescriptorPool_ = VK_NULL_HANDLE;
     VkDescriptorSet debugTextDescriptorSet_ = VK_NULL_HANDLE;
     
+    // Rewritten every frame: one region of kDebugTextMaxChars per frame in flight
+    static constexpr size_t kDebugTextMaxChars = 2000;
+    static constexpr VkDeviceSize kDebugTextVertexRegion = kDebugTextMaxChars * 4 * 7 * sizeof(float);
+    static constexpr VkDeviceSize kDebugTextIndexRegion = kDebugTextMaxChars * 6 * sizeof(uint16_t);
     VkBuffer debugTextVertexBuffer_ = VK_NULL_HANDLE;
-    VkDeviceMemory debugTextVertexMemory_ = VK_NULL_HANDLE;
+    GpuAllocation debugTextVertexMemory_;
     VkBuffer debugTextIndexBuffer_ = VK_NULL_HANDLE;
-    VkDeviceMemory debugTextIndexMemory_ = VK_NULL_HANDLE;
+    GpuAllocation debugTextIndexMemory_;
     uint32_t debugTextIndexCount_ = 0;
     
     VkImage debugFontImage_ = VK_NULL_HANDLE;
-    VkDeviceMemory debugFontMemory_ = VK_NULL_HANDLE;
+    GpuAllocation debugFontMemory_;
     VkImageView debugFontView_ = VK_NULL_HANDLE;
     VkSampler debugFontSampler_ = VK_NULL_HANDLE;
     
@@ -385,8 +501,11 @@ private:
     VkDescriptorPool debugChunkDescriptorPool_ = VK_NULL_HANDLE;
     VkDescriptorSet debugChunkDescriptorSet_ = VK_NULL_HANDLE;
     
+    // One region of kDebugChunkMaxChunks boxes per frame in flight
+    static constexpr size_t kDebugChunkMaxChunks = 100;
+    static constexpr VkDeviceSize kDebugChunkVertexRegion = kDebugChunkMaxChunks * 24 * 6 * sizeof(float);
     VkBuffer debugChunkVertexBuffer_ = VK_NULL_HANDLE;
-    VkDeviceMemory debugChunkVertexMemory_ = VK_NULL_HANDLE;
+    GpuAllocation debugChunkVertexMemory_;
     uint32_t debugChunkVertexCount_ = 0;
     
     bool createDebugChunkVisualization();
@@ -395,9 +514,9 @@ private:
     
     // Light volume debug markers
     VkBuffer debugLightMarkerVertexBuffer_ = VK_NULL_HANDLE;
-    VkDeviceMemory debugLightMarkerVertexMemory_ = VK_NULL_HANDLE;
+    GpuAllocation debugLightMarkerVertexMemory_;
     VkBuffer debugLightMarkerIndexBuffer_ = VK_NULL_HANDLE;
-    VkDeviceMemory debugLightMarkerIndexMemory_ = VK_NULL_HANDLE;
+    GpuAllocation debugLightMarkerIndexMemory_;
     uint32_t debugLightMarkerIndexCount_ = 0;
     bool debugShowLightMarkers_ = false;
     
@@ -433,59 +552,132 @@ private:
     uint32_t frameCounter_ = 0;
 
     struct VolumetricResources {
-        VkImage densityImage = VK_NULL_HANDLE;
-        VkDeviceMemory densityMemory = VK_NULL_HANDLE;
-        VkImageView densityView = VK_NULL_HANDLE;
-
+        // rgb = in-scattered light, a = sigma_t. Written as a storage image by
+        // the inject passes, sampled with hardware trilinear by the raymarch.
         VkImage lightImage = VK_NULL_HANDLE;
-        VkDeviceMemory lightMemory = VK_NULL_HANDLE;
+        GpuAllocation lightMemory;
         VkImageView lightView = VK_NULL_HANDLE;
 
+        // One texel per brick of lightImage: min sigma, max sigma, min light,
+        // max light. Lets the raymarch cross homogeneous bricks in one step.
+        VkImage froxelRangeImage = VK_NULL_HANDLE;
+        GpuAllocation froxelRangeMemory;
+        VkImageView froxelRangeView = VK_NULL_HANDLE;
+
         VkImage scatteringImage = VK_NULL_HANDLE;
-        VkDeviceMemory scatteringMemory = VK_NULL_HANDLE;
+        GpuAllocation scatteringMemory;
         VkImageView scatteringView = VK_NULL_HANDLE;
 
         VkImage transmittanceImage = VK_NULL_HANDLE;
-        VkDeviceMemory transmittanceMemory = VK_NULL_HANDLE;
+        GpuAllocation transmittanceMemory;
         VkImageView transmittanceView = VK_NULL_HANDLE;
 
-        VkImage historyImage = VK_NULL_HANDLE;
-        VkDeviceMemory historyMemory = VK_NULL_HANDLE;
-        VkImageView historyView = VK_NULL_HANDLE;
+        // Temporal history per frame in flight: the frame's set writes
+        // historyImages[frame] and samples the one the previous frame wrote
+        VkImage historyImages[kMaxFramesInFlight] = {};
+        GpuAllocation historyMemories[kMaxFramesInFlight];
+        VkImageView historyViews[kMaxFramesInFlight] = {};
+
+        // Pre-integrated mode only: view-space scattering/transmittance volume
+        VkImage integratedImage = VK_NULL_HANDLE;
+        GpuAllocation integratedMemory;
+        VkImageView integratedView = VK_NULL_HANDLE;
+        VkSampler integratedSampler = VK_NULL_HANDLE;  // Linear, clamped to edge
+        VkExtent3D integratedGrid = {0, 0, 0};
+
+        // View-space layout only: rgb = in-scattered light, a = sigma_t per
+        // froxel of the view frustum, rewritten every frame. Its slices match
+        // integratedImage, which then integrates it instead of lightImage.
+        VkImage viewFroxelImage = VK_NULL_HANDLE;
+        GpuAllocation viewFroxelMemory;
+        VkImageView viewFroxelView = VK_NULL_HANDLE;
+        VkExtent3D viewFroxelGrid = {0, 0, 0};
 
         // Anamorphic bloom resources
         VkImage anamorphicBloomImage = VK_NULL_HANDLE;
-        VkDeviceMemory anamorphicBloomMemory = VK_NULL_HANDLE;
+        GpuAllocation anamorphicBloomMemory;
         VkImageView anamorphicBloomView = VK_NULL_HANDLE;
         
         VkImage anamorphicTempImage = VK_NULL_HANDLE;
-        VkDeviceMemory anamorphicTempMemory = VK_NULL_HANDLE;
+        GpuAllocation anamorphicTempMemory;
         VkImageView anamorphicTempView = VK_NULL_HANDLE;
 
-        BufferWithMemory constantsBuffer;
-        BufferWithMemory lightRecordsBuffer;
+        // Rewritten by the CPU every frame, one copy per frame in flight
+        BufferWithMemory constantsBuffers[kMaxFramesInFlight];
+        BufferWithMemory lightRecordsBuffers[kMaxFramesInFlight];
+        BufferWithMemory densityVolumesBuffers[kMaxFramesInFlight];
+        BufferWithMemory froxelBrickBuffers[kMaxFramesInFlight];      // World bricks injected this frame
+        BufferWithMemory froxelBrickMaskBuffers[kMaxFramesInFlight];  // Same bricks as a bitmask over brickSlots
+        // Per-brick light lists, rebuilt on the GPU for the bricks being injected
         BufferWithMemory clusterIndicesBuffer;
         BufferWithMemory clusterOffsetsBuffer;
-        BufferWithMemory densityVolumesBuffer;
+        BufferWithMemory densityAccumBuffer;  // Fixed-point sigma per froxel, cleared and summed every frame
+        // Header of clusterOffsetsBuffer (allocated, dropped) copied back after each cluster build
+        BufferWithMemory clusterStatsReadbacks[kMaxFramesInFlight];
+        bool clusterStatsCopied[kMaxFramesInFlight] = {};  // Last frame from the slot ran a cluster build
 
         VkDescriptorSetLayout descriptorSetLayouts[3] = {VK_NULL_HANDLE, VK_NULL_HANDLE, VK_NULL_HANDLE};
         VkDescriptorSetLayout anamorphicBloomDescriptorLayout = VK_NULL_HANDLE;
         VkDescriptorPool descriptorPool = VK_NULL_HANDLE;
-        VkDescriptorSet descriptorSets[3] = {VK_NULL_HANDLE, VK_NULL_HANDLE, VK_NULL_HANDLE};
+        VkDescriptorSet descriptorSets[kMaxFramesInFlight][3] = {};  // Per frame: constants, images, buffers
         VkDescriptorPool anamorphicBloomDescriptorPool = VK_NULL_HANDLE;
         VkDescriptorSet anamorphicBloomDescriptorSets[2] = {VK_NULL_HANDLE, VK_NULL_HANDLE}; // horiz and vert
 
         VkPipelineLayout pipelineLayout = VK_NULL_HANDLE;
         VkPipelineLayout anamorphicBloomPipelineLayout = VK_NULL_HANDLE;
         VkPipeline clusterPipeline = VK_NULL_HANDLE;
-        VkPipeline densityPipeline = VK_NULL_HANDLE;
+        VkPipeline densityPipeline = VK_NULL_HANDLE;  // Scatter records into densityAccumBuffer, lightPipeline resolves it
         VkPipeline lightPipeline = VK_NULL_HANDLE;
+        VkPipeline rangePipeline = VK_NULL_HANDLE;     // Rebuilds froxelRangeImage for the injected bricks
         VkPipeline raymarchPipeline = VK_NULL_HANDLE;
+        VkPipeline integratePipeline = VK_NULL_HANDLE;      // Pre-integrated mode, replaces the raymarch
+        VkPipeline scatterLookupPipeline = VK_NULL_HANDLE;
+        VkPipeline viewClusterPipeline = VK_NULL_HANDLE;    // View-space layout: per-brick light and density lists
+        VkPipeline viewInjectPipeline = VK_NULL_HANDLE;     // View-space layout: fills viewFroxelImage
         VkPipeline temporalPipeline = VK_NULL_HANDLE;
         VkPipeline anamorphicBloomPipeline = VK_NULL_HANDLE;
 
-        VkExtent3D froxelGrid = {160, 96, 160};
-        VkExtent2D raymarchExtent = {0, 0};
+        VkExtent3D froxelGrid = {0, 0, 0};  // From VolumetricConfig, brick aligned
+
+        // The density and light volumes scroll with the camera and are addressed
+        // toroidally: world cell c lives at texel c mod froxelGrid. Froxels are
+        // only re-injected when they scroll into range or the records covering
+        // them change, and then only once their brick (kFroxelBrickSize^3
+        // world-aligned froxels) is near the view frustum.
+        glm::ivec3 froxelOrigin{0};  // World cell at the grid's min corner
+        bool froxelOriginValid = false;
+        bool froxelFullRefresh = true;
+        glm::ivec3 brickSlots{0};          // Bricks the grid can straddle along each axis
+        glm::ivec3 froxelBrickBase{0};     // World brick holding froxelOrigin
+        std::vector<uint8_t> staleBricks;  // Per brick slot (world brick mod brickSlots)
+        uint32_t froxelBrickCount = 0;     // Bricks injected this frame
+        float injectedBaseSigma = -1.0f;
+        std::vector<VolumetricLightRecord> injectedLights;      // Sorted bytewise
+        std::vector<VolumetricDensityRecord> injectedDensities;
+
+        // Inputs of the last light selection. volumetricLights_ is reused
+        // while the camera stays within the reselect thresholds of them.
+        bool lightSelectionValid = false;
+        glm::vec3 lightSelectionCameraPos{0.0f};
+        glm::vec3 lightSelectionCameraFront{0.0f};
+        uint64_t lightSelectionChunkGeneration = 0;
+        glm::vec2 lightSelectionScales{0.0f};  // Intensity, radius
+        // Density records cached until the selected cell box or the loaded chunks change
+        bool densitySelectionValid = false;
+        glm::ivec3 densitySelectionOrigin{0};  // Min corner of the box
+        glm::ivec3 densityCellBase{0};         // World cell record bounds are relative to, heads the records
+        uint64_t densitySelectionChunkGeneration = 0;
+        // Bumped whenever a selection is rebuilt. Each frame's record buffers
+        // remember the version and records they last received, so unchanged
+        // frames write nothing and rebuilt ones write only what differs.
+        uint64_t lightRecordsVersion = 0;
+        uint64_t densityRecordsVersion = 0;
+        uint64_t uploadedLightsVersion[kMaxFramesInFlight] = {};
+        uint64_t uploadedDensitiesVersion[kMaxFramesInFlight] = {};
+        std::vector<VolumetricLightRecord> uploadedLights[kMaxFramesInFlight];
+        std::vector<VolumetricDensityRecord> uploadedDensities[kMaxFramesInFlight];
+        size_t uploadedAlbedoPaletteSize[kMaxFramesInFlight] = {};
+        VkExtent2D raymarchExtent = {0, 0};  // scatteringImage, transmittanceImage, history and bloom images
         bool imagesInitialized = false;
         bool historyInitialized = false;
     };
@@ -496,7 +688,11 @@ private:
     uint32_t volumetricFrameIndex_ = 0;
 
     void updateVolumetricLights();
+    void selectVolumetricLights(const CityGenerator& gen);  // Rebuilds volumetricLights_
     void updateVolumetricDensities();
+    void selectVolumetricDensities(const CityGenerator& gen, const glm::ivec3& gridMin, const glm::ivec3& gridMax);  // Rebuilds volumetricDensities_
+    void markFroxelCellsDirty(const glm::ivec3& cellMin, const glm::ivec3& cellMax);
+    uint32_t selectFroxelBricks();
 };
 
 }
@@ -165,18 +165,11 @@ bool Renderer::createDebugFontTexture() {
     
     if (vkCreateImage(device_, &imageInfo, nullptr, &debugFontImage_) != VK_SUCCESS) return false;
     
-    VkMemoryRequirements memReq;
-    vkGetImageMemoryRequirements(device_, debugFontImage_, &memReq);
-    VkMemoryAllocateInfo allocInfo{VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO};
-    allocInfo.allocationSize = memReq.size;
-    allocInfo.memoryTypeIndex = findMemoryType(memReq.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-    
-    if (vkAllocateMemory(device_, &allocInfo, nullptr, &debugFontMemory_) != VK_SUCCESS) return false;
-    vkBindImageMemory(device_, debugFontImage_, debugFontMemory_, 0);
+    if (!allocator_.allocateForImage(debugFontImage_, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, debugFontMemory_, GpuAllocationStrategy::Linear)) return false;
     
     // Create staging buffer and upload font data
     VkBuffer stagingBuffer;
-    VkDeviceMemory stagingMemory;
+    GpuAllocation stagingMemory;
     VkDeviceSize bufferSize = fontData.size();
     
     VkBufferCreateInfo bufferInfo{VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO};
@@ -184,20 +177,16 @@ bool Renderer::createDebugFontTexture() {
     bufferInfo.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
     vkCreateBuffer(device_, &bufferInfo, nullptr, &stagingBuffer);
     
-    vkGetBufferMemoryRequirements(device_, stagingBuffer, &memReq);
-    allocInfo.allocationSize = memReq.size;
-    allocInfo.memoryTypeIndex = findMemoryType(memReq.memoryTypeBits, 
-        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
-    vkAllocateMemory(device_, &allocInfo, nullptr, &stagingMemory);
-    vkBindBufferMemory(device_, stagingBuffer, stagingMemory, 0);
+    if (!allocator_.allocateForBuffer(stagingBuffer,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, stagingMemory)) {
+        vkDestroyBuffer(device_, stagingBuffer, nullptr);
+        return false;
+    }
     
-    void* data;
-    vkMapMemory(device_, stagingMemory, 0, bufferSize, 0, &data);
-    memcpy(data, fontData.data(), bufferSize);
-    vkUnmapMemory(device_, stagingMemory);
+    memcpy(stagingMemory.mapped, fontData.data(), bufferSize);
     
     // Transition image and copy buffer to image
-    VkCommandBuffer cmd = commandBuffers_[0];
+    VkCommandBuffer cmd = frames_[0].commandBuffer;
     VkCommandBufferBeginInfo beginInfo{VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO};
     beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
     vkBeginCommandBuffer(cmd, &beginInfo);
@@ -241,7 +230,7 @@ bool Renderer::createDebugFontTexture() {
     vkQueueWaitIdle(graphicsQueue_);
     
     vkDestroyBuffer(device_, stagingBuffer, nullptr);
-    vkFreeMemory(device_, stagingMemory, nullptr);
+    allocator_.free(stagingMemory);
     
     // Create image view
     VkImageViewCreateInfo viewInfo{VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO};
@@ -449,44 +438,24 @@ bool Renderer::createDebugOverlayResources() {
         return false;
     }
     
-    // Create vertex buffer (large enough for ~2000 characters)
-    const size_t maxChars = 2000;
-    const size_t maxVertices = maxChars * 4;
-    const size_t vertexBufferSize = maxVertices * 7 * sizeof(float);
-    
+    // Create vertex buffer (kDebugTextMaxChars characters per frame in flight)
     VkBufferCreateInfo bufferInfo{VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO};
-    bufferInfo.size = vertexBufferSize;
+    bufferInfo.size = kDebugTextVertexRegion * kMaxFramesInFlight;
     bufferInfo.usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT;
     
     if (vkCreateBuffer(device_, &bufferInfo, nullptr, &debugTextVertexBuffer_) != VK_SUCCESS) return false;
     
-    VkMemoryRequirements memReq;
-    vkGetBufferMemoryRequirements(device_, debugTextVertexBuffer_, &memReq);
-    
-    VkMemoryAllocateInfo allocInfo{VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO};
-    allocInfo.allocationSize = memReq.size;
-    allocInfo.memoryTypeIndex = findMemoryType(memReq.memoryTypeBits, 
-        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
-    
-    if (vkAllocateMemory(device_, &allocInfo, nullptr, &debugTextVertexMemory_) != VK_SUCCESS) return false;
-    vkBindBufferMemory(device_, debugTextVertexBuffer_, debugTextVertexMemory_, 0);
+    if (!allocator_.allocateForBuffer(debugTextVertexBuffer_,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, debugTextVertexMemory_)) return false;
     
     // Create index buffer
-    const size_t maxIndices = maxChars * 6;
-    const size_t indexBufferSize = maxIndices * sizeof(uint16_t);
-    
-    bufferInfo.size = indexBufferSize;
+    bufferInfo.size = kDebugTextIndexRegion * kMaxFramesInFlight;
     bufferInfo.usage = VK_BUFFER_USAGE_INDEX_BUFFER_BIT;
     
     if (vkCreateBuffer(device_, &bufferInfo, nullptr, &debugTextIndexBuffer_) != VK_SUCCESS) return false;
     
-    vkGetBufferMemoryRequirements(device_, debugTextIndexBuffer_, &memReq);
-    allocInfo.allocationSize = memReq.size;
-    allocInfo.memoryTypeIndex = findMemoryType(memReq.memoryTypeBits,
-        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
-    
-    if (vkAllocateMemory(device_, &allocInfo, nullptr, &debugTextIndexMemory_) != VK_SUCCESS) return false;
-    vkBindBufferMemory(device_, debugTextIndexBuffer_, debugTextIndexMemory_, 0);
+    if (!allocator_.allocateForBuffer(debugTextIndexBuffer_,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, debugTextIndexMemory_)) return false;
     
     // Create descriptor pool
     VkDescriptorPoolSize poolSize{};
@@ -671,27 +640,15 @@ bool Renderer::createDebugChunkVisualization() {
     
     // Create vertex buffer if it doesn't exist (for swapchain recreation)
     if (debugChunkVertexBuffer_ == VK_NULL_HANDLE) {
-        const size_t maxChunks = 100;
-        const size_t verticesPerChunk = 24;  // 12 edges * 2 vertices per edge
-        const size_t maxVertices = maxChunks * verticesPerChunk;
-        const size_t vertexBufferSize = maxVertices * 6 * sizeof(float);
-        
+        // 12 edges * 2 vertices per chunk, one region per frame in flight
         VkBufferCreateInfo bufferInfo{VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO};
-        bufferInfo.size = vertexBufferSize;
+        bufferInfo.size = kDebugChunkVertexRegion * kMaxFramesInFlight;
         bufferInfo.usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT;
         
         if (vkCreateBuffer(device_, &bufferInfo, nullptr, &debugChunkVertexBuffer_) != VK_SUCCESS) return false;
         
-        VkMemoryRequirements memReq;
-        vkGetBufferMemoryRequirements(device_, debugChunkVertexBuffer_, &memReq);
-        
-        VkMemoryAllocateInfo allocInfo{VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO};
-        allocInfo.allocationSize = memReq.size;
-        allocInfo.memoryTypeIndex = findMemoryType(memReq.memoryTypeBits, 
-            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
-        
-        if (vkAllocateMemory(device_, &allocInfo, nullptr, &debugChunkVertexMemory_) != VK_SUCCESS) return false;
-        vkBindBufferMemory(device_, debugChunkVertexBuffer_, debugChunkVertexMemory_, 0);
+        if (!allocator_.allocateForBuffer(debugChunkVertexBuffer_,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, debugChunkVertexMemory_)) return false;
     }
     
     printf("Debug chunk visualization created successfully\n");
@@ -705,12 +662,11 @@ void Renderer::updateDebugChunkGeometry() {
     float chunkSize = gen->getChunkSize();
     
     // Limit to prevent buffer overflow (100 chunks = 2400 vertices max)
-    const size_t maxChunksToRender = 100;
     size_t chunksRendered = 0;
     
     // Generate wireframe box for each active chunk
     for (const auto& chunk : activeChunks_) {
-        if (chunksRendered >= maxChunksToRender) break;
+        if (chunksRendered >= kDebugChunkMaxChunks) break;
         int chunkX = chunk.first;
         int chunkZ = chunk.second;
         
@@ -784,10 +740,8 @@ void Renderer::updateDebugChunkGeometry() {
     debugChunkVertexCount_ = static_cast<uint32_t>(vertices.size() / 6);
     
     if (debugChunkVertexCount_ > 0 && debugChunkVertexBuffer_) {
-        void* data;
-        vkMapMemory(device_, debugChunkVertexMemory_, 0, vertices.size() * sizeof(float), 0, &data);
-        memcpy(data, vertices.data(), vertices.size() * sizeof(float));
-        vkUnmapMemory(device_, debugChunkVertexMemory_);
+        memcpy(static_cast<char*>(debugChunkVertexMemory_.mapped) + currentFrame_ * kDebugChunkVertexRegion,
+               vertices.data(), vertices.size() * sizeof(float));
     }
 }
 
@@ -796,9 +750,9 @@ void Renderer::renderDebugChunks(VkCommandBuffer cmd) {
     
     vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, debugChunkPipeline_);
     vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, debugChunkPipelineLayout_, 
-                           0, 1, &descriptorSets_[0], 0, nullptr);
+                           0, 1, &descriptorSets_[currentFrame_], 0, nullptr);
     
-    VkDeviceSize offset = 0;
+    VkDeviceSize offset = currentFrame_ * kDebugChunkVertexRegion;
     vkCmdBindVertexBuffers(cmd, 0, 1, &debugChunkVertexBuffer_, &offset);
     vkCmdDraw(cmd, debugChunkVertexCount_, 1, 0, 0);
 }
@@ -807,24 +761,38 @@ void Renderer::updateDebugLightMarkers() {
     if (!cityGenerator_ || !device_) return;
     
     auto* gen = static_cast<CityGenerator*>(cityGenerator_);
-    const auto& neonLights = gen->getNeonLights();
-    const auto& lightVolumes = gen->getLightVolumes();
+    
+    // Marker counts are capped, so only gather the first lights in chunk order
+    const size_t maxNeons = 300;
+    const size_t maxVolumes = 200;
+    std::vector<const NeonLight*> neonLights;
+    std::vector<const LightVolume*> lightVolumes;
+    for (const auto& entry : gen->getChunks()) {
+        for (const auto& neon : entry.second.neonLights) {
+            if (neonLights.size() >= maxNeons) break;
+            neonLights.push_back(&neon);
+        }
+        for (const auto& volume : entry.second.lightVolumes) {
+            if (lightVolumes.size() >= maxVolumes) break;
+            lightVolumes.push_back(&volume);
+        }
+    }
     
     printf("=== Debug Light Markers ===\n");
-    printf("Total neons: %zu, Total volumes: %zu\n", neonLights.size(), lightVolumes.size());
+    printf("Total neons: %zu, Total volumes: %zu\n", gen->getNeonLightCount(), gen->getLightVolumeCount());
     if (!neonLights.empty()) {
         printf("First 3 neon positions:\n");
         for (size_t i = 0; i < std::min(size_t(3), neonLights.size()); ++i) {
             printf("  [%zu] pos=(%.1f, %.1f, %.1f)\n", i, 
-                   neonLights[i].position.x, neonLights[i].position.y, neonLights[i].position.z);
+                   neonLights[i]->position.x, neonLights[i]->position.y, neonLights[i]->position.z);
         }
     }
     if (!lightVolumes.empty()) {
         printf("First 3 volume positions:\n");
         for (size_t i = 0; i < std::min(size_t(3), lightVolumes.size()); ++i) {
             printf("  [%zu] pos=(%.1f, %.1f, %.1f) %s\n", i,
-                   lightVolumes[i].basePosition.x, lightVolumes[i].basePosition.y, lightVolumes[i].basePosition.z,
-                   lightVolumes[i].isCone ? "CONE" : "CUBE");
+                   lightVolumes[i]->basePosition.x, lightVolumes[i]->basePosition.y, lightVolumes[i]->basePosition.z,
+                   lightVolumes[i]->isCone ? "CONE" : "CUBE");
         }
     }
     
@@ -833,9 +801,8 @@ void Renderer::updateDebugLightMarkers() {
     std::vector<uint32_t> indices;
     
     // Add markers for neon lights (cyan markers) - only show nearby ones
-    size_t maxNeons = std::min(neonLights.size(), size_t(300));
-    for (size_t idx = 0; idx < maxNeons; ++idx) {
-        const auto& neon = neonLights[idx];
+    for (const NeonLight* neonPtr : neonLights) {
+        const auto& neon = *neonPtr;
         glm::vec3 pos = neon.position;
         float size = 1.5f; // Larger markers for visibility
         glm::vec3 color = glm::vec3(0.0f, 1.0f, 1.0f); // Bright cyan for neons
@@ -866,9 +833,8 @@ void Renderer::updateDebugLightMarkers() {
     }
     
     // Add markers for light volumes (red for beams, green for cubes)
-    size_t maxVolumes = std::min(lightVolumes.size(), size_t(200));
-    for (size_t idx = 0; idx < maxVolumes; ++idx) {
-        const auto& volume = lightVolumes[idx];
+    for (const LightVolume* volumePtr : lightVolumes) {
+        const auto& volume = *volumePtr;
         glm::vec3 pos = volume.basePosition;
         float size = 3.0f; // Larger for volume markers
         glm::vec3 color = volume.isCone ? glm::vec3(1.0f, 0.0f, 0.0f) : glm::vec3(0.0f, 1.0f, 0.0f); // Bright red/green
@@ -899,21 +865,19 @@ void Renderer::updateDebugLightMarkers() {
         indices.push_back(baseIndex + 3);
     }
     
-    if (maxNeons < neonLights.size() || maxVolumes < lightVolumes.size()) {
+    if (neonLights.size() < gen->getNeonLightCount() || lightVolumes.size() < gen->getLightVolumeCount()) {
         printf("  Debug markers: %zu/%zu neons (cyan), %zu/%zu volumes (red/green)\n", 
-               maxNeons, neonLights.size(), maxVolumes, lightVolumes.size());
+               neonLights.size(), gen->getNeonLightCount(), lightVolumes.size(), gen->getLightVolumeCount());
     }
     
     debugLightMarkerIndexCount_ = static_cast<uint32_t>(indices.size());
     
     if (debugLightMarkerIndexCount_ == 0) return;
     
-    // Create or recreate buffers
+    // Create or recreate buffers (the old ones may still be in use by the last frame)
     if (debugLightMarkerVertexBuffer_) {
-        vkDestroyBuffer(device_, debugLightMarkerVertexBuffer_, nullptr);
-        vkFreeMemory(device_, debugLightMarkerVertexMemory_, nullptr);
-        vkDestroyBuffer(device_, debugLightMarkerIndexBuffer_, nullptr);
-        vkFreeMemory(device_, debugLightMarkerIndexMemory_, nullptr);
+        retireBuffer(debugLightMarkerVertexBuffer_, debugLightMarkerVertexMemory_);
+        retireBuffer(debugLightMarkerIndexBuffer_, debugLightMarkerIndexMemory_);
     }
     
     // Vertex buffer
@@ -927,25 +891,15 @@ void Renderer::updateDebugLightMarkers() {
         return;
     }
     
-    VkMemoryRequirements memReq;
-    vkGetBufferMemoryRequirements(device_, debugLightMarkerVertexBuffer_, &memReq);
-    
-    VkMemoryAllocateInfo allocInfo{VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO};
-    allocInfo.allocationSize = memReq.size;
-    allocInfo.memoryTypeIndex = findMemoryType(memReq.memoryTypeBits, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
-    
-    if (vkAllocateMemory(device_, &allocInfo, nullptr, &debugLightMarkerVertexMemory_) != VK_SUCCESS) {
+    if (!allocator_.allocateForBuffer(debugLightMarkerVertexBuffer_, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                                      debugLightMarkerVertexMemory_)) {
         vkDestroyBuffer(device_, debugLightMarkerVertexBuffer_, nullptr);
         debugLightMarkerVertexBuffer_ = VK_NULL_HANDLE;
         debugLightMarkerIndexCount_ = 0;
         return;
     }
-    vkBindBufferMemory(device_, debugLightMarkerVertexBuffer_, debugLightMarkerVertexMemory_, 0);
     
-    void* data;
-    vkMapMemory(device_, debugLightMarkerVertexMemory_, 0, vertexBufferSize, 0, &data);
-    std::memcpy(data, vertices.data(), vertexBufferSize);
-    vkUnmapMemory(device_, debugLightMarkerVertexMemory_);
+    std::memcpy(debugLightMarkerVertexMemory_.mapped, vertices.data(), vertexBufferSize);
     
     // Index buffer
     VkDeviceSize indexBufferSize = indices.size() * sizeof(uint32_t);
@@ -958,33 +912,27 @@ void Renderer::updateDebugLightMarkers() {
         return;
     }
     
-    vkGetBufferMemoryRequirements(device_, debugLightMarkerIndexBuffer_, &memReq);
-    allocInfo.allocationSize = memReq.size;
-    allocInfo.memoryTypeIndex = findMemoryType(memReq.memoryTypeBits, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
-    
-    if (vkAllocateMemory(device_, &allocInfo, nullptr, &debugLightMarkerIndexMemory_) != VK_SUCCESS) {
+    if (!allocator_.allocateForBuffer(debugLightMarkerIndexBuffer_, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                                      debugLightMarkerIndexMemory_)) {
         vkDestroyBuffer(device_, debugLightMarkerIndexBuffer_, nullptr);
         debugLightMarkerIndexBuffer_ = VK_NULL_HANDLE;
         debugLightMarkerIndexCount_ = 0;
         return;
     }
-    vkBindBufferMemory(device_, debugLightMarkerIndexBuffer_, debugLightMarkerIndexMemory_, 0);
     
-    vkMapMemory(device_, debugLightMarkerIndexMemory_, 0, indexBufferSize, 0, &data);
-    std::memcpy(data, indices.data(), indexBufferSize);
-    vkUnmapMemory(device_, debugLightMarkerIndexMemory_);
+    std::memcpy(debugLightMarkerIndexMemory_.mapped, indices.data(), indexBufferSize);
 }
 
 void Renderer::renderDebugLightMarkers(VkCommandBuffer cmd) {
     if (!debugShowLightMarkers_ || !debugChunkPipeline_ || !debugChunkPipelineLayout_ || 
-        !descriptorSets_[0] || debugLightMarkerIndexCount_ == 0 || 
+        !descriptorSets_[currentFrame_] || debugLightMarkerIndexCount_ == 0 || 
         !debugLightMarkerVertexBuffer_ || !debugLightMarkerIndexBuffer_) {
         return;
     }
     
     vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, debugChunkPipeline_);
     vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, debugChunkPipelineLayout_, 
-                           0, 1, &descriptorSets_[0], 0, nullptr);
+                           0, 1, &descriptorSets_[currentFrame_], 0, nullptr);
     
     VkDeviceSize offset = 0;
     vkCmdBindVertexBuffers(cmd, 0, 1, &debugLightMarkerVertexBuffer_, &offset);
@@ -2,424 +2,207 @@
 #include "CityGenerator.hpp"
 #include <vulkan/vulkan.h>
 #include <vector>
-#include <cstring>
 #include <cstdio>
 #include <cmath>
 
 namespace pcengine {
 
-bool Renderer::createCityGeometry() {
-    const auto& buildings = static_cast<CityGenerator*>(cityGenerator_)->getBuildings();
-    
-    std::vector<float> vertices;
-    std::vector<uint32_t> indices;  // Changed from uint16_t to support large cities
-    
-    uint32_t vertexOffset = 0;  // Changed from uint16_t to support large cities
-    
-    for (const auto& building : buildings) {
-        // Iterate through all parts (trunk + branches)
-        for (const auto& part : building.parts) {
-            // Calculate absolute position
-            float x = building.position.x + part.position.x;
-            float y = building.position.y + part.position.y;
-            float z = building.position.z + part.position.z;
-            float w = part.size.x;
-            float h = part.size.y;
-            float d = part.size.z;
-        
-        // Create 24 vertices (4 per face) with proper UV coordinates scaled to building dimensions
-        // Scale UV coordinates based on building dimensions to prevent stretching
-        float uvScaleU = w / 4.0f; // Scale U coordinate by width
-        float uvScaleV = h / 4.0f; // Scale V coordinate by height
-        
-        std::vector<float> boxVertices = {
-            // Front face (z+d/2) - width x height
-            x-w/2, y, z+d/2, part.color.x, part.color.y, part.color.z, 0.0f, 0.0f,
-            x+w/2, y, z+d/2, part.color.x, part.color.y, part.color.z, uvScaleU, 0.0f,
-            x+w/2, y+h, z+d/2, part.color.x, part.color.y, part.color.z, uvScaleU, uvScaleV,
-            x-w/2, y+h, z+d/2, part.color.x, part.color.y, part.color.z, 0.0f, uvScaleV,
-            
-            // Back face (z-d/2) - width x height
-            x+w/2, y, z-d/2, part.color.x, part.color.y, part.color.z, 0.0f, 0.0f,
-            x-w/2, y, z-d/2, part.color.x, part.color.y, part.color.z, uvScaleU, 0.0f,
-            x-w/2, y+h, z-d/2, part.color.x, part.color.y, part.color.z, uvScaleU, uvScaleV,
-            x+w/2, y+h, z-d/2, part.color.x, part.color.y, part.color.z, 0.0f, uvScaleV,
-            
-            // Left face (x-w/2) - depth x height
-            x-w/2, y, z-d/2, part.color.x, part.color.y, part.color.z, 0.0f, 0.0f,
-            x-w/2, y, z+d/2, part.color.x, part.color.y, part.color.z, d/4.0f, 0.0f,
-            x-w/2, y+h, z+d/2, part.color.x, part.color.y, part.color.z, d/4.0f, uvScaleV,
-            x-w/2, y+h, z-d/2, part.color.x, part.color.y, part.color.z, 0.0f, uvScaleV,
-            
-            // Right face (x+w/2) - depth x height
-            x+w/2, y, z+d/2, part.color.x, part.color.y, part.color.z, 0.0f, 0.0f,
-            x+w/2, y, z-d/2, part.color.x, part.color.y, part.color.z, d/4.0f, 0.0f,
-            x+w/2, y+h, z-d/2, part.color.x, part.color.y, part.color.z, d/4.0f, uvScaleV,
-            x+w/2, y+h, z+d/2, part.color.x, part.color.y, part.color.z, 0.0f, uvScaleV,
-            
-            // Top face (y+h) - width x depth
-            x-w/2, y+h, z+d/2, part.color.x, part.color.y, part.color.z, 0.0f, 0.0f,
-            x+w/2, y+h, z+d/2, part.color.x, part.color.y, part.color.z, uvScaleU, 0.0f,
-            x+w/2, y+h, z-d/2, part.color.x, part.color.y, part.color.z, uvScaleU, d/4.0f,
-            x-w/2, y+h, z-d/2, part.color.x, part.color.y, part.color.z, 0.0f, d/4.0f,
-            
-            // Bottom face (y) - width x depth
-            x-w/2, y, z-d/2, part.color.x, part.color.y, part.color.z, 0.0f, 0.0f,
-            x+w/2, y, z-d/2, part.color.x, part.color.y, part.color.z, uvScaleU, 0.0f,
-            x+w/2, y, z+d/2, part.color.x, part.color.y, part.color.z, uvScaleU, d/4.0f,
-            x-w/2, y, z+d/2, part.color.x, part.color.y, part.color.z, 0.0f, d/4.0f,
-        };
-        // Expand to include per-vertex texture index and normals
-        // Format: pos(3) + color(3) + uv(2) + texIndex(1) + normal(3) = 12 floats per vertex
-        std::vector<float> boxVerticesComplete;
-        boxVerticesComplete.reserve((boxVertices.size()/8) * 12);
-            int texIndex = ((int)std::round(x + y + z)) & 1;
-        
-        // Face normals: front=0,0,1; back=0,0,-1; left=-1,0,0; right=1,0,0; top=0,1,0; bottom=0,-1,0
-        struct FaceData { int startIdx; float nx, ny, nz; };
-        FaceData faces[6] = {
-            {0, 0.0f, 0.0f, 1.0f},   // Front (vertices 0-3)
-            {32, 0.0f, 0.0f, -1.0f}, // Back (vertices 4-7, offset 32 floats = 4 vertices * 8 floats)
-            {64, -1.0f, 0.0f, 0.0f}, // Left (vertices 8-11, offset 64 floats)
-            {96, 1.0f, 0.0f, 0.0f},  // Right (vertices 12-15, offset 96 floats)
-            {128, 0.0f, 1.0f, 0.0f}, // Top (vertices 16-19, offset 128 floats)
-            {160, 0.0f, -1.0f, 0.0f} // Bottom (vertices 20-23, offset 160 floats)
-        };
-        
-        for (size_t i = 0; i < boxVertices.size(); i += 8) {
-            // Add position, color, uv
-            boxVerticesComplete.insert(boxVerticesComplete.end(), boxVertices.begin() + i, boxVertices.begin() + i + 8);
-            // Add texture index
-            boxVerticesComplete.push_back((float)texIndex);
-            
-            // Find which face this vertex belongs to and add appropriate normal
-            int currentOffset = (int)i;
-            float nx = 0.0f, ny = 0.0f, nz = 0.0f;
-            for (int f = 0; f < 6; f++) {
-                if (currentOffset >= faces[f].startIdx && currentOffset < faces[f].startIdx + 32) {
-                    nx = faces[f].nx;
-                    ny = faces[f].ny;
-                    nz = faces[f].nz;
-                    break;
-                }
-            }
-            boxVerticesComplete.push_back(nx);
-            boxVerticesComplete.push_back(ny);
-            boxVerticesComplete.push_back(nz);
-        }
-        
-        // 12 triangles (2 per face) - each face uses 4 consecutive vertices
-        std::vector<uint32_t> boxIndices = {
-            // Front face
-            vertexOffset+0, vertexOffset+1, vertexOffset+2,
-            vertexOffset+2, vertexOffset+3, vertexOffset+0,
-            // Back face
-            vertexOffset+4, vertexOffset+5, vertexOffset+6,
-            vertexOffset+6, vertexOffset+7, vertexOffset+4,
-            // Left face
-            vertexOffset+8, vertexOffset+9, vertexOffset+10,
-            vertexOffset+10, vertexOffset+11, vertexOffset+8,
-            // Right face
-            vertexOffset+12, vertexOffset+13, vertexOffset+14,
-            vertexOffset+14, vertexOffset+15, vertexOffset+12,
-            // Top face
-            vertexOffset+16, vertexOffset+17, vertexOffset+18,
-            vertexOffset+18, vertexOffset+19, vertexOffset+16,
-            // Bottom face
-            vertexOffset+20, vertexOffset+21, vertexOffset+22,
-            vertexOffset+22, vertexOffset+23, vertexOffset+20,
-        };
-        
-            vertices.insert(vertices.end(), boxVerticesComplete.begin(), boxVerticesComplete.end());
-            indices.insert(indices.end(), boxIndices.begin(), boxIndices.end());
-            
-            vertexOffset += 24;
-        }
-    }
-    
-    cityIndexCount_ = static_cast<uint32_t>(indices.size());
-    
-    // Create vertex buffer
+bool Renderer::uploadGeometryBuffer(const void* data, VkDeviceSize size, VkBufferUsageFlags usage, VkBuffer& buffer, GpuAllocation& memory) {
+    // Static geometry lives in DEVICE_LOCAL memory, filled through the staging ring
     VkBufferCreateInfo bufferInfo{ VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO };
-    bufferInfo.size = vertices.size() * sizeof(float);
-    bufferInfo.usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT;
-    if (vkCreateBuffer(device_, &bufferInfo, nullptr, &cityVertexBuffer_) != VK_SUCCESS) return false;
-    
-    VkMemoryRequirements memReq;
-    vkGetBufferMemoryRequirements(device_, cityVertexBuffer_, &memReq);
-    VkMemoryAllocateInfo allocInfo{ VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO };
-    allocInfo.allocationSize = memReq.size;
-    allocInfo.memoryTypeIndex = findMemoryType(memReq.memoryTypeBits, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
-    if (vkAllocateMemory(device_, &allocInfo, nullptr, &cityVertexBufferMemory_) != VK_SUCCESS) return false;
-    vkBindBufferMemory(device_, cityVertexBuffer_, cityVertexBufferMemory_, 0);
-    
-    void* data;
-    vkMapMemory(device_, cityVertexBufferMemory_, 0, bufferInfo.size, 0, &data);
-    std::memcpy(data, vertices.data(), bufferInfo.size);
-    vkUnmapMemory(device_, cityVertexBufferMemory_);
-    
-    // Create index buffer
-    bufferInfo.size = indices.size() * sizeof(uint32_t);  // Changed from uint16_t to uint32_t
-    bufferInfo.usage = VK_BUFFER_USAGE_INDEX_BUFFER_BIT;
-    if (vkCreateBuffer(device_, &bufferInfo, nullptr, &cityIndexBuffer_) != VK_SUCCESS) return false;
-    
-    vkGetBufferMemoryRequirements(device_, cityIndexBuffer_, &memReq);
-    allocInfo.allocationSize = memReq.size;
-    allocInfo.memoryTypeIndex = findMemoryType(memReq.memoryTypeBits, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
-    if (vkAllocateMemory(device_, &allocInfo, nullptr, &cityIndexBufferMemory_) != VK_SUCCESS) return false;
-    vkBindBufferMemory(device_, cityIndexBuffer_, cityIndexBufferMemory_, 0);
-    
-    vkMapMemory(device_, cityIndexBufferMemory_, 0, bufferInfo.size, 0, &data);
-    std::memcpy(data, indices.data(), bufferInfo.size);
-    vkUnmapMemory(device_, cityIndexBufferMemory_);
+    bufferInfo.size = size;
+    bufferInfo.usage = usage | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+    if (vkCreateBuffer(device_, &bufferInfo, nullptr, &buffer) != VK_SUCCESS) return false;
+    
+    if (!allocator_.allocateForBuffer(buffer, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, memory)) {
+        vkDestroyBuffer(device_, buffer, nullptr);
+        buffer = VK_NULL_HANDLE;
+        return false;
+    }
     
-    size_t totalParts = 0;
-    for (const auto& building : buildings) {
-        totalParts += building.parts.size();
+    if (!stageBufferUpload(data, size, buffer, 0)) {
+        vkDestroyBuffer(device_, buffer, nullptr);
+        allocator_.free(memory);
+        buffer = VK_NULL_HANDLE;
+        return false;
     }
-    printf("Created city geometry: %zu vertices, %zu indices from %zu buildings with %zu total parts\n", 
-           vertices.size() / 12, indices.size(), buildings.size(), totalParts);
     return true;
 }
 
-bool Renderer::createNeonGeometry() {
-    const auto& neonLights = static_cast<CityGenerator*>(cityGenerator_)->getNeonLights();
-    
-    std::vector<float> vertices;
-    std::vector<uint16_t> indices;
-    
-    uint16_t vertexOffset = 0;
-    
-    for (const auto& light : neonLights) {
-        // Use the light's individual width and height
-        float halfW = light.width * 0.5f;
-        float halfH = light.height * 0.5f;
-        float x = light.position.x;
-        float y = light.position.y;
-        float z = light.position.z;
-        
-        // Format: pos(3) + color(3) + intensity(1) + uv(2) + texIndex(1) = 10 floats per vertex
-        int texIndex = 0;
-        {
-            int layerCount = (numNeonTextures_ > 0) ? numNeonTextures_ : 1;
-            int seed = static_cast<int>(std::round(x + y + z));
-            int mod = seed % layerCount;
-            texIndex = (mod < 0) ? (mod + layerCount) : mod;
+bool Renderer::createBoxGeometry() {
+    // Unit box with its base at y=0: x/z in [-0.5, 0.5], y in [0, 1].
+    // 4 vertices per face so every face gets its own normal and UV corners.
+    // pos(3) + normal(3) + corner(2)
+    static const float kBoxVertices[24][8] = {
+        // Front face (+Z)
+        { -0.5f, 0.0f,  0.5f,  0.0f, 0.0f,  1.0f,  0.0f, 0.0f },
+        {  0.5f, 0.0f,  0.5f,  0.0f, 0.0f,  1.0f,  1.0f, 0.0f },
+        {  0.5f, 1.0f,  0.5f,  0.0f, 0.0f,  1.0f,  1.0f, 1.0f },
+        { -0.5f, 1.0f,  0.5f,  0.0f, 0.0f,  1.0f,  0.0f, 1.0f },
+        // Back face (-Z)
+        {  0.5f, 0.0f, -0.5f,  0.0f, 0.0f, -1.0f,  0.0f, 0.0f },
+        { -0.5f, 0.0f, -0.5f,  0.0f, 0.0f, -1.0f,  1.0f, 0.0f },
+        { -0.5f, 1.0f, -0.5f,  0.0f, 0.0f, -1.0f,  1.0f, 1.0f },
+        {  0.5f, 1.0f, -0.5f,  0.0f, 0.0f, -1.0f,  0.0f, 1.0f },
+        // Left face (-X)
+        { -0.5f, 0.0f, -0.5f, -1.0f, 0.0f,  0.0f,  0.0f, 0.0f },
+        { -0.5f, 0.0f,  0.5f, -1.0f, 0.0f,  0.0f,  1.0f, 0.0f },
+        { -0.5f, 1.0f,  0.5f, -1.0f, 0.0f,  0.0f,  1.0f, 1.0f },
+        { -0.5f, 1.0f, -0.5f, -1.0f, 0.0f,  0.0f,  0.0f, 1.0f },
+        // Right face (+X)
+        {  0.5f, 0.0f,  0.5f,  1.0f, 0.0f,  0.0f,  0.0f, 0.0f },
+        {  0.5f, 0.0f, -0.5f,  1.0f, 0.0f,  0.0f,  1.0f, 0.0f },
+        {  0.5f, 1.0f, -0.5f,  1.0f, 0.0f,  0.0f,  1.0f, 1.0f },
+        {  0.5f, 1.0f,  0.5f,  1.0f, 0.0f,  0.0f,  0.0f, 1.0f },
+        // Top face (+Y)
+        { -0.5f, 1.0f,  0.5f,  0.0f, 1.0f,  0.0f,  0.0f, 0.0f },
+        {  0.5f, 1.0f,  0.5f,  0.0f, 1.0f,  0.0f,  1.0f, 0.0f },
+        {  0.5f, 1.0f, -0.5f,  0.0f, 1.0f,  0.0f,  1.0f, 1.0f },
+        { -0.5f, 1.0f, -0.5f,  0.0f, 1.0f,  0.0f,  0.0f, 1.0f },
+        // Bottom face (-Y)
+        { -0.5f, 0.0f, -0.5f,  0.0f, -1.0f, 0.0f,  0.0f, 0.0f },
+        {  0.5f, 0.0f, -0.5f,  0.0f, -1.0f, 0.0f,  1.0f, 0.0f },
+        {  0.5f, 0.0f,  0.5f,  0.0f, -1.0f, 0.0f,  1.0f, 1.0f },
+        { -0.5f, 0.0f,  0.5f,  0.0f, -1.0f, 0.0f,  0.0f, 1.0f },
+    };
+    
+    // 12 triangles (2 per face) - each face uses 4 consecutive vertices
+    static const uint16_t kQuad[6] = { 0, 1, 2, 2, 3, 0 };
+    uint16_t indices[36];
+    for (int face = 0; face < 6; ++face) {
+        for (int i = 0; i < 6; ++i) {
+            indices[face * 6 + i] = static_cast<uint16_t>(face * 4 + kQuad[i]);
         }
-        
-        std::vector<float> quadVertices;
-        
-        // Create quad oriented based on wall face
-        // face: 0=front(+Z), 1=back(-Z), 2=left(-X), 3=right(+X)
-        switch (light.face) {
-            case 0: // Front face (+Z) - facing forward
-                quadVertices = {
-                    x-halfW, y-halfH, z, light.color.x, light.color.y, light.color.z, light.intensity, 0.0f, 1.0f, (float)texIndex,
-                    x+halfW, y-halfH, z, light.color.x, light.color.y, light.color.z, light.intensity, 1.0f, 1.0f, (float)texIndex,
-                    x+halfW, y+halfH, z, light.color.x, light.color.y, light.color.z, light.intensity, 1.0f, 0.0f, (float)texIndex,
-                    x-halfW, y+halfH, z, light.color.x, light.color.y, light.color.z, light.intensity, 0.0f, 0.0f, (float)texIndex,
-                };
-                break;
-            case 1: // Back face (-Z) - facing backward (flip winding)
-                quadVertices = {
-                    x+halfW, y-halfH, z, light.color.x, light.color.y, light.color.z, light.intensity, 0.0f, 1.0f, (float)texIndex,
-                    x-halfW, y-halfH, z, light.color.x, light.color.y, light.color.z, light.intensity, 1.0f, 1.0f, (float)texIndex,
-                    x-halfW, y+halfH, z, light.color.x, light.color.y, light.color.z, light.intensity, 1.0f, 0.0f, (float)texIndex,
-                    x+halfW, y+halfH, z, light.color.x, light.color.y, light.color.z, light.intensity, 0.0f, 0.0f, (float)texIndex,
-                };
-                break;
-            case 2: // Left face (-X) - facing left
-                quadVertices = {
-                    x, y-halfH, z+halfW, light.color.x, light.color.y, light.color.z, light.intensity, 0.0f, 1.0f, (float)texIndex,
-                    x, y-halfH, z-halfW, light.color.x, light.color.y, light.color.z, light.intensity, 1.0f, 1.0f, (float)texIndex,
-                    x, y+halfH, z-halfW, light.color.x, light.color.y, light.color.z, light.intensity, 1.0f, 0.0f, (float)texIndex,
-                    x, y+halfH, z+halfW, light.color.x, light.color.y, light.color.z, light.intensity, 0.0f, 0.0f, (float)texIndex,
-                };
-                break;
-            case 3: // Right face (+X) - facing right (flip winding)
-                quadVertices = {
-                    x, y-halfH, z-halfW, light.color.x, light.color.y, light.color.z, light.intensity, 0.0f, 1.0f, (float)texIndex,
-                    x, y-halfH, z+halfW, light.color.x, light.color.y, light.color.z, light.intensity, 1.0f, 1.0f, (float)texIndex,
-                    x, y+halfH, z+halfW, light.color.x, light.color.y, light.color.z, light.intensity, 1.0f, 0.0f, (float)texIndex,
-                    x, y+halfH, z-halfW, light.color.x, light.color.y, light.color.z, light.intensity, 0.0f, 0.0f, (float)texIndex,
-                };
-                break;
-            default: // Should never happen, but use front face as fallback
-                quadVertices = {
-                    x-halfW, y-halfH, z, light.color.x, light.color.y, light.color.z, light.intensity, 0.0f, 1.0f, (float)texIndex,
-                    x+halfW, y-halfH, z, light.color.x, light.color.y, light.color.z, light.intensity, 1.0f, 1.0f, (float)texIndex,
-                    x+halfW, y+halfH, z, light.color.x, light.color.y, light.color.z, light.intensity, 1.0f, 0.0f, (float)texIndex,
-                    x-halfW, y+halfH, z, light.color.x, light.color.y, light.color.z, light.intensity, 0.0f, 0.0f, (float)texIndex,
-                };
-                break;
-        }
-        
-        std::vector<uint16_t> quadIndices = {
-            static_cast<uint16_t>(vertexOffset+0), static_cast<uint16_t>(vertexOffset+1), static_cast<uint16_t>(vertexOffset+2),
-            static_cast<uint16_t>(vertexOffset+2), static_cast<uint16_t>(vertexOffset+3), static_cast<uint16_t>(vertexOffset+0),
-        };
-        
-        vertices.insert(vertices.end(), quadVertices.begin(), quadVertices.end());
-        indices.insert(indices.end(), quadIndices.begin(), quadIndices.end());
-        
-        vertexOffset += 4;
     }
+    boxIndexCount_ = 36;
     
-    neonIndexCount_ = static_cast<uint32_t>(indices.size());
-    
-    // Create vertex buffer
-    VkBufferCreateInfo bufferInfo{ VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO };
-    bufferInfo.size = vertices.size() * sizeof(float);
-    bufferInfo.usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT;
-    if (vkCreateBuffer(device_, &bufferInfo, nullptr, &neonVertexBuffer_) != VK_SUCCESS) return false;
-    
-    VkMemoryRequirements memReq;
-    vkGetBufferMemoryRequirements(device_, neonVertexBuffer_, &memReq);
-    VkMemoryAllocateInfo allocInfo{ VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO };
-    allocInfo.allocationSize = memReq.size;
-    allocInfo.memoryTypeIndex = findMemoryType(memReq.memoryTypeBits, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
-    if (vkAllocateMemory(device_, &allocInfo, nullptr, &neonVertexBufferMemory_) != VK_SUCCESS) return false;
-    vkBindBufferMemory(device_, neonVertexBuffer_, neonVertexBufferMemory_, 0);
-    
-    void* data;
-    vkMapMemory(device_, neonVertexBufferMemory_, 0, bufferInfo.size, 0, &data);
-    std::memcpy(data, vertices.data(), bufferInfo.size);
-    vkUnmapMemory(device_, neonVertexBufferMemory_);
-    
-    // Create index buffer
-    bufferInfo.size = indices.size() * sizeof(uint16_t);
-    bufferInfo.usage = VK_BUFFER_USAGE_INDEX_BUFFER_BIT;
-    if (vkCreateBuffer(device_, &bufferInfo, nullptr, &neonIndexBuffer_) != VK_SUCCESS) return false;
-    
-    vkGetBufferMemoryRequirements(device_, neonIndexBuffer_, &memReq);
-    allocInfo.allocationSize = memReq.size;
-    allocInfo.memoryTypeIndex = findMemoryType(memReq.memoryTypeBits, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
-    if (vkAllocateMemory(device_, &allocInfo, nullptr, &neonIndexBufferMemory_) != VK_SUCCESS) return false;
-    vkBindBufferMemory(device_, neonIndexBuffer_, neonIndexBufferMemory_, 0);
-    
-    vkMapMemory(device_, neonIndexBufferMemory_, 0, bufferInfo.size, 0, &data);
-    std::memcpy(data, indices.data(), bufferInfo.size);
-    vkUnmapMemory(device_, neonIndexBufferMemory_);
-    
-    printf("Created neon geometry: %zu lights\n", neonLights.size());
-    return true;
+    if (!uploadGeometryBuffer(kBoxVertices, sizeof(kBoxVertices), VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+                              boxVertexBuffer_, boxVertexBufferMemory_)) return false;
+    return uploadGeometryBuffer(indices, sizeof(indices), VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
+                                boxIndexBuffer_, boxIndexBufferMemory_);
 }
 
-bool Renderer::createGroundGeometry() {
-    std::vector<float> vertices;
+namespace {
+
+// Same sizes uploadChunkGeometry() packs into its vertex and index buffers
+VkDeviceSize chunkVertexBytes(const ChunkMesh& mesh) {
+    return mesh.cityInstances.size() * sizeof(CityInstance) +
+           mesh.groundVertices.size() * sizeof(GroundVertex) +
+           mesh.neonVertices.size() * sizeof(float);
+}
+
+VkDeviceSize chunkIndexBytes(const ChunkMesh& mesh) {
+    return (mesh.groundIndices.size() + mesh.neonIndices.size()) * sizeof(uint32_t);
+}
+
+}
+
+bool Renderer::chunkGeometryFitsRing(const ChunkMesh& mesh) const {
+    return uploadsFitRing({ chunkVertexBytes(mesh), chunkIndexBytes(mesh) });
+}
+
+bool Renderer::canStageChunkGeometry(const ChunkMesh& mesh) {
+    return canStageUploads({ chunkVertexBytes(mesh), chunkIndexBytes(mesh) });
+}
+
+bool Renderer::uploadChunkGeometry(const std::pair<int, int>& chunkKey, const ChunkMesh& mesh) {
+    releaseChunkGeometry(chunkKey);
+    
+    // Pack part instances, ground and neon sections back to back. Indices stay
+    // chunk-local, each section binds the vertex buffer at its own byte offset.
+    const size_t instanceBytes = mesh.cityInstances.size() * sizeof(CityInstance);
+    const size_t groundBytes = mesh.groundVertices.size() * sizeof(GroundVertex);
+    const size_t neonBytes = mesh.neonVertices.size() * sizeof(float);
+    std::vector<uint8_t> vertices;
     std::vector<uint32_t> indices;
-    
-    CityGenerator* gen = static_cast<CityGenerator*>(cityGenerator_);
-    float chunkSize = gen->getChunkSize();
-    
-    uint32_t vertexOffset = 0;
-    
-    // Create a ground quad for each active chunk
-    for (const auto& chunk : activeChunks_) {
-        int chunkX = chunk.first;
-        int chunkZ = chunk.second;
-        
-        // Calculate chunk boundaries in world space
-        float minX = chunkX * chunkSize;
-        float maxX = (chunkX + 1) * chunkSize;
-        float minZ = chunkZ * chunkSize;
-        float maxZ = (chunkZ + 1) * chunkSize;
-        float y = 0.0f;  // Ground level
-        
-        // Dark ground color (almost black with subtle blue tint for dystopian aesthetic)
-        glm::vec3 groundColor(0.02f, 0.025f, 0.03f);
-        
-        // Add some variation based on chunk position
-        int seed = chunkX * 73856093 ^ chunkZ * 19349663;
-        float variation = ((seed % 100) / 100.0f) * 0.01f;
-        groundColor += glm::vec3(variation);
-        
-        // UV coordinates for tiling texture (if we add ground textures later)
-        float uvScale = 1.0f;  // 1:1 scale with world units
-        
-        // Format: pos(3) + color(3) + uv(2) + texIndex(1) + normal(3) = 12 floats per vertex
-        // (Same format as building geometry for compatibility)
-        int texIndex = 0;  // Use first texture or specific ground texture
-        glm::vec3 normal(0.0f, -1.0f, 0.0f);  // Normal points down (flipped for proper lighting)
-        
-        // Create ground quad vertices (4 corners)
-        std::vector<float> quadVertices = {
-            // Bottom-left
-            minX, y, minZ, groundColor.x, groundColor.y, groundColor.z, 
-            0.0f, 0.0f, (float)texIndex, normal.x, normal.y, normal.z,
-            
-            // Bottom-right
-            maxX, y, minZ, groundColor.x, groundColor.y, groundColor.z,
-            uvScale, 0.0f, (float)texIndex, normal.x, normal.y, normal.z,
-            
-            // Top-right
-            maxX, y, maxZ, groundColor.x, groundColor.y, groundColor.z,
-            uvScale, uvScale, (float)texIndex, normal.x, normal.y, normal.z,
-            
-            // Top-left
-            minX, y, maxZ, groundColor.x, groundColor.y, groundColor.z,
-            0.0f, uvScale, (float)texIndex, normal.x, normal.y, normal.z,
-        };
-        
-        // Two triangles for the quad
-        std::vector<uint32_t> quadIndices = {
-            vertexOffset+0, vertexOffset+1, vertexOffset+2,
-            vertexOffset+2, vertexOffset+3, vertexOffset+0,
-        };
-        
-        vertices.insert(vertices.end(), quadVertices.begin(), quadVertices.end());
-        indices.insert(indices.end(), quadIndices.begin(), quadIndices.end());
-        
-        vertexOffset += 4;
+    vertices.reserve(instanceBytes + groundBytes + neonBytes);
+    indices.reserve(mesh.groundIndices.size() + mesh.neonIndices.size());
+    
+    auto appendSection = [&](const void* sectionVertices, size_t sectionBytes, const std::vector<uint32_t>& sectionIndices,
+                             ChunkGeometry::Section& section) {
+        section.vertexOffset = vertices.size();
+        section.firstIndex = static_cast<uint32_t>(indices.size());
+        section.indexCount = static_cast<uint32_t>(sectionIndices.size());
+        const uint8_t* bytes = static_cast<const uint8_t*>(sectionVertices);
+        vertices.insert(vertices.end(), bytes, bytes + sectionBytes);
+        indices.insert(indices.end(), sectionIndices.begin(), sectionIndices.end());
+    };
+    
+    ChunkGeometry geometry;
+    geometry.cityInstanceOffset = 0;
+    geometry.cityInstanceCount = static_cast<uint32_t>(mesh.cityInstances.size());
+    const uint8_t* instanceData = reinterpret_cast<const uint8_t*>(mesh.cityInstances.data());
+    vertices.insert(vertices.end(), instanceData, instanceData + instanceBytes);
+    appendSection(mesh.groundVertices.data(), groundBytes, mesh.groundIndices, geometry.ground);
+    // Neon floats need 4-byte alignment, the packed sections above are multiples of 4
+    appendSection(mesh.neonVertices.data(), neonBytes, mesh.neonIndices, geometry.neon);
+    geometry.origin = mesh.origin;
+    geometry.bounds = mesh.bounds;
+    
+    if (vertices.empty()) {
+        return true;
     }
     
-    groundIndexCount_ = static_cast<uint32_t>(indices.size());
-    
-    if (groundIndexCount_ == 0) {
-        printf("No ground geometry to create (no active chunks)\n");
-        return true;  // Not an error, just no chunks yet
+    if (!uploadGeometryBuffer(vertices.data(), vertices.size(), VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+                              geometry.vertexBuffer, geometry.vertexMemory)) return false;
+    if (!indices.empty() &&
+        !uploadGeometryBuffer(indices.data(), indices.size() * sizeof(uint32_t), VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
+                              geometry.indexBuffer, geometry.indexMemory)) {
+        retireBuffer(geometry.vertexBuffer, geometry.vertexMemory);
+        return false;
     }
     
-    // Create vertex buffer
-    VkBufferCreateInfo bufferInfo{ VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO };
-    bufferInfo.size = vertices.size() * sizeof(float);
-    bufferInfo.usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT;
-    if (vkCreateBuffer(device_, &bufferInfo, nullptr, &groundVertexBuffer_) != VK_SUCCESS) return false;
-    
-    VkMemoryRequirements memReq;
-    vkGetBufferMemoryRequirements(device_, groundVertexBuffer_, &memReq);
-    VkMemoryAllocateInfo allocInfo{ VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO };
-    allocInfo.allocationSize = memReq.size;
-    allocInfo.memoryTypeIndex = findMemoryType(memReq.memoryTypeBits, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
-    if (vkAllocateMemory(device_, &allocInfo, nullptr, &groundVertexBufferMemory_) != VK_SUCCESS) return false;
-    vkBindBufferMemory(device_, groundVertexBuffer_, groundVertexBufferMemory_, 0);
-    
-    void* data;
-    vkMapMemory(device_, groundVertexBufferMemory_, 0, bufferInfo.size, 0, &data);
-    std::memcpy(data, vertices.data(), bufferInfo.size);
-    vkUnmapMemory(device_, groundVertexBufferMemory_);
-    
-    // Create index buffer
-    bufferInfo.size = indices.size() * sizeof(uint32_t);
-    bufferInfo.usage = VK_BUFFER_USAGE_INDEX_BUFFER_BIT;
-    if (vkCreateBuffer(device_, &bufferInfo, nullptr, &groundIndexBuffer_) != VK_SUCCESS) return false;
-    
-    vkGetBufferMemoryRequirements(device_, groundIndexBuffer_, &memReq);
-    allocInfo.allocationSize = memReq.size;
-    allocInfo.memoryTypeIndex = findMemoryType(memReq.memoryTypeBits, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
-    if (vkAllocateMemory(device_, &allocInfo, nullptr, &groundIndexBufferMemory_) != VK_SUCCESS) return false;
-    vkBindBufferMemory(device_, groundIndexBuffer_, groundIndexBufferMemory_, 0);
-    
-    vkMapMemory(device_, groundIndexBufferMemory_, 0, bufferInfo.size, 0, &data);
-    std::memcpy(data, indices.data(), bufferInfo.size);
-    vkUnmapMemory(device_, groundIndexBufferMemory_);
-    
-    printf("Created ground geometry: %zu chunks (%u indices)\n", activeChunks_.size(), groundIndexCount_);
+    cityInstanceCount_ += geometry.cityInstanceCount;
+    groundIndexCount_ += geometry.ground.indexCount;
+    neonIndexCount_ += geometry.neon.indexCount;
+    chunkGeometry_[chunkKey] = geometry;
     return true;
 }
 
+void Renderer::releaseChunkGeometry(const std::pair<int, int>& chunkKey) {
+    auto it = chunkGeometry_.find(chunkKey);
+    if (it == chunkGeometry_.end()) return;
+    
+    ChunkGeometry& geometry = it->second;
+    cityInstanceCount_ -= geometry.cityInstanceCount;
+    groundIndexCount_ -= geometry.ground.indexCount;
+    neonIndexCount_ -= geometry.neon.indexCount;
+    
+    // The last recorded frame may still draw from these
+    retireBuffer(geometry.vertexBuffer, geometry.vertexMemory);
+    retireBuffer(geometry.indexBuffer, geometry.indexMemory);
+    chunkGeometry_.erase(it);
+}
+
+void Renderer::pushChunkOrigin(VkCommandBuffer cmd, const ChunkGeometry& geometry) {
+    // Packed city positions are relative to this, see ChunkMesh.hpp
+    float origin[4] = { geometry.origin.x, geometry.origin.y, geometry.origin.z, 0.0f };
+    vkCmdPushConstants(cmd, pipelineLayout_, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(origin), origin);
+}
+
+void Renderer::drawChunkSection(VkCommandBuffer cmd, const ChunkGeometry& geometry, const ChunkGeometry::Section& section) {
+    if (section.indexCount == 0) return;
+    
+    pushChunkOrigin(cmd, geometry);
+    vkCmdBindVertexBuffers(cmd, 0, 1, &geometry.vertexBuffer, &section.vertexOffset);
+    vkCmdBindIndexBuffer(cmd, geometry.indexBuffer, 0, VK_INDEX_TYPE_UINT32);
+    vkCmdDrawIndexed(cmd, section.indexCount, 1, section.firstIndex, 0, 0);
+}
+
+void Renderer::drawChunkBuildings(VkCommandBuffer cmd, const ChunkGeometry& geometry) {
+    if (geometry.cityInstanceCount == 0) return;
+    
+    pushChunkOrigin(cmd, geometry);
+    // Binding 0: shared unit box, binding 1: this chunk's part instances
+    VkBuffer buffers[2] = { boxVertexBuffer_, geometry.vertexBuffer };
+    VkDeviceSize offsets[2] = { 0, geometry.cityInstanceOffset };
+    vkCmdBindVertexBuffers(cmd, 0, 2, buffers, offsets);
+    vkCmdBindIndexBuffer(cmd, boxIndexBuffer_, 0, VK_INDEX_TYPE_UINT16);
+    vkCmdDrawIndexed(cmd, boxIndexCount_, geometry.cityInstanceCount, 0, 0, 0);
+}
+
 bool Renderer::createShadowVolumeGeometry() {
-    const auto& buildings = static_cast<CityGenerator*>(cityGenerator_)->getBuildings();
+    auto* gen = static_cast<CityGenerator*>(cityGenerator_);
     
     std::vector<float> vertices;
     std::vector<uint32_t> indices;
@@ -431,101 +214,103 @@ bool Renderer::createShadowVolumeGeometry() {
     // Shadow extrusion distance (very far to ensure shadows reach ground)
     const float shadowExtrusionDist = 500.0f;
     
-    for (const auto& building : buildings) {
-        for (const auto& part : building.parts) {
-            // Calculate absolute position
-            glm::vec3 partPos = building.position + part.position;
-            float w = part.size.x;
-            float h = part.size.y;
-            float d = part.size.z;
+    for (const auto& entry : gen->getChunks()) {
+        for (const auto& building : entry.second.buildings) {
+            for (const auto& part : building.parts) {
+                // Calculate absolute position
+                glm::vec3 partPos = building.position + part.position;
+                float w = part.size.x;
+                float h = part.size.y;
+                float d = part.size.z;
             
-            // Define the 8 corners of the building part
-            glm::vec3 corners[8] = {
-                partPos + glm::vec3(-w/2, 0, -d/2),  // 0: bottom-front-left
-                partPos + glm::vec3( w/2, 0, -d/2),  // 1: bottom-front-right
-                partPos + glm::vec3( w/2, 0,  d/2),  // 2: bottom-back-right
-                partPos + glm::vec3(-w/2, 0,  d/2),  // 3: bottom-back-left
-                partPos + glm::vec3(-w/2, h, -d/2),  // 4: top-front-left
-                partPos + glm::vec3( w/2, h, -d/2),  // 5: top-front-right
-                partPos + glm::vec3( w/2, h,  d/2),  // 6: top-back-right
-                partPos + glm::vec3(-w/2, h,  d/2),  // 7: top-back-left
-            };
+                // Define the 8 corners of the building part
+                glm::vec3 corners[8] = {
+                    partPos + glm::vec3(-w/2, 0, -d/2),  // 0: bottom-front-left
+                    partPos + glm::vec3( w/2, 0, -d/2),  // 1: bottom-front-right
+                    partPos + glm::vec3( w/2, 0,  d/2),  // 2: bottom-back-right
+                    partPos + glm::vec3(-w/2, 0,  d/2),  // 3: bottom-back-left
+                    partPos + glm::vec3(-w/2, h, -d/2),  // 4: top-front-left
+                    partPos + glm::vec3( w/2, h, -d/2),  // 5: top-front-right
+                    partPos + glm::vec3( w/2, h,  d/2),  // 6: top-back-right
+                    partPos + glm::vec3(-w/2, h,  d/2),  // 7: top-back-left
+                };
             
-            // Extrude corners away from light (opposite direction of sun position)
-            glm::vec3 extrudedCorners[8];
-            for (int i = 0; i < 8; ++i) {
-                extrudedCorners[i] = corners[i] - lightDir * shadowExtrusionDist;
-            }
+                // Extrude corners away from light (opposite direction of sun position)
+                glm::vec3 extrudedCorners[8];
+                for (int i = 0; i < 8; ++i) {
+                    extrudedCorners[i] = corners[i] - lightDir * shadowExtrusionDist;
+                }
             
-            // Format: just position (3 floats) - shadow volumes don't need color/UV
-            // We'll add all vertices for the shadow volume
-            std::vector<glm::vec3> shadowVerts;
+                // Format: just position (3 floats) - shadow volumes don't need color/UV
+                // We'll add all vertices for the shadow volume
+                std::vector<glm::vec3> shadowVerts;
             
-            // Add original corners
-            for (int i = 0; i < 8; ++i) {
-                shadowVerts.push_back(corners[i]);
-            }
-            // Add extruded corners
-            for (int i = 0; i < 8; ++i) {
-                shadowVerts.push_back(extrudedCorners[i]);
-            }
+                // Add original corners
+                for (int i = 0; i < 8; ++i) {
+                    shadowVerts.push_back(corners[i]);
+                }
+                // Add extruded corners
+                for (int i = 0; i < 8; ++i) {
+                    shadowVerts.push_back(extrudedCorners[i]);
+                }
             
-            // Convert to float array
-            for (const auto& v : shadowVerts) {
-                vertices.push_back(v.x);
-                vertices.push_back(v.y);
-                vertices.push_back(v.z);
-            }
+                // Convert to float array
+                for (const auto& v : shadowVerts) {
+                    vertices.push_back(v.x);
+                    vertices.push_back(v.y);
+                    vertices.push_back(v.z);
+                }
             
-            // Now create quads for the sides (silhouette edges)
-            // We create quads between original and extruded edges
-            // Original: 0-7, Extruded: 8-15
+                // Now create quads for the sides (silhouette edges)
+                // We create quads between original and extruded edges
+                // Original: 0-7, Extruded: 8-15
             
-            // Side edges that form the shadow volume sides
-            // Bottom edges (assuming light from above, these edges cast shadows down)
-            struct Edge { int v0, v1; };
-            Edge bottomEdges[] = {
-                {0, 1}, {1, 2}, {2, 3}, {3, 0}  // Bottom square
-            };
+                // Side edges that form the shadow volume sides
+                // Bottom edges (assuming light from above, these edges cast shadows down)
+                struct Edge { int v0, v1; };
+                Edge bottomEdges[] = {
+                    {0, 1}, {1, 2}, {2, 3}, {3, 0}  // Bottom square
+                };
             
-            for (const Edge& edge : bottomEdges) {
-                int v0 = edge.v0;
-                int v1 = edge.v1;
-                int v0_ext = v0 + 8;  // Extruded version
-                int v1_ext = v1 + 8;
+                for (const Edge& edge : bottomEdges) {
+                    int v0 = edge.v0;
+                    int v1 = edge.v1;
+                    int v0_ext = v0 + 8;  // Extruded version
+                    int v1_ext = v1 + 8;
                 
-                // Create quad: v0, v1, v1_ext, v0_ext
-                // Two triangles with counter-clockwise winding
-                indices.push_back(vertexOffset + v0);
-                indices.push_back(vertexOffset + v1);
-                indices.push_back(vertexOffset + v1_ext);
+                    // Create quad: v0, v1, v1_ext, v0_ext
+                    // Two triangles with counter-clockwise winding
+                    indices.push_back(vertexOffset + v0);
+                    indices.push_back(vertexOffset + v1);
+                    indices.push_back(vertexOffset + v1_ext);
                 
-                indices.push_back(vertexOffset + v1_ext);
-                indices.push_back(vertexOffset + v0_ext);
-                indices.push_back(vertexOffset + v0);
-            }
+                    indices.push_back(vertexOffset + v1_ext);
+                    indices.push_back(vertexOffset + v0_ext);
+                    indices.push_back(vertexOffset + v0);
+                }
             
-            // Front cap (light-facing, at building position)
-            // Bottom face
-            indices.push_back(vertexOffset + 0);
-            indices.push_back(vertexOffset + 2);
-            indices.push_back(vertexOffset + 1);
+                // Front cap (light-facing, at building position)
+                // Bottom face
+                indices.push_back(vertexOffset + 0);
+                indices.push_back(vertexOffset + 2);
+                indices.push_back(vertexOffset + 1);
             
-            indices.push_back(vertexOffset + 0);
-            indices.push_back(vertexOffset + 3);
-            indices.push_back(vertexOffset + 2);
+                indices.push_back(vertexOffset + 0);
+                indices.push_back(vertexOffset + 3);
+                indices.push_back(vertexOffset + 2);
             
-            // Back cap (far end of shadow)
-            // Bottom face (extruded)
-            indices.push_back(vertexOffset + 8);
-            indices.push_back(vertexOffset + 9);
-            indices.push_back(vertexOffset + 10);
+                // Back cap (far end of shadow)
+                // Bottom face (extruded)
+                indices.push_back(vertexOffset + 8);
+                indices.push_back(vertexOffset + 9);
+                indices.push_back(vertexOffset + 10);
             
-            indices.push_back(vertexOffset + 10);
-            indices.push_back(vertexOffset + 11);
-            indices.push_back(vertexOffset + 8);
+                indices.push_back(vertexOffset + 10);
+                indices.push_back(vertexOffset + 11);
+                indices.push_back(vertexOffset + 8);
             
-            vertexOffset += 16;  // 8 original + 8 extruded
+                vertexOffset += 16;  // 8 original + 8 extruded
+            }
         }
     }
     
@@ -536,41 +321,12 @@ bool Renderer::createShadowVolumeGeometry() {
         return true;
     }
     
-    // Create vertex buffer
-    VkBufferCreateInfo bufferInfo{ VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO };
-    bufferInfo.size = vertices.size() * sizeof(float);
-    bufferInfo.usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT;
-    if (vkCreateBuffer(device_, &bufferInfo, nullptr, &shadowVolumeVertexBuffer_) != VK_SUCCESS) return false;
-    
-    VkMemoryRequirements memReq;
-    vkGetBufferMemoryRequirements(device_, shadowVolumeVertexBuffer_, &memReq);
-    VkMemoryAllocateInfo allocInfo{ VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO };
-    allocInfo.allocationSize = memReq.size;
-    allocInfo.memoryTypeIndex = findMemoryType(memReq.memoryTypeBits, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
-    if (vkAllocateMemory(device_, &allocInfo, nullptr, &shadowVolumeVertexBufferMemory_) != VK_SUCCESS) return false;
-    vkBindBufferMemory(device_, shadowVolumeVertexBuffer_, shadowVolumeVertexBufferMemory_, 0);
-    
-    void* data;
-    vkMapMemory(device_, shadowVolumeVertexBufferMemory_, 0, bufferInfo.size, 0, &data);
-    std::memcpy(data, vertices.data(), bufferInfo.size);
-    vkUnmapMemory(device_, shadowVolumeVertexBufferMemory_);
-    
-    // Create index buffer
-    bufferInfo.size = indices.size() * sizeof(uint32_t);
-    bufferInfo.usage = VK_BUFFER_USAGE_INDEX_BUFFER_BIT;
-    if (vkCreateBuffer(device_, &bufferInfo, nullptr, &shadowVolumeIndexBuffer_) != VK_SUCCESS) return false;
-    
-    vkGetBufferMemoryRequirements(device_, shadowVolumeIndexBuffer_, &memReq);
-    allocInfo.allocationSize = memReq.size;
-    allocInfo.memoryTypeIndex = findMemoryType(memReq.memoryTypeBits, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
-    if (vkAllocateMemory(device_, &allocInfo, nullptr, &shadowVolumeIndexBufferMemory_) != VK_SUCCESS) return false;
-    vkBindBufferMemory(device_, shadowVolumeIndexBuffer_, shadowVolumeIndexBufferMemory_, 0);
-    
-    vkMapMemory(device_, shadowVolumeIndexBufferMemory_, 0, bufferInfo.size, 0, &data);
-    std::memcpy(data, indices.data(), bufferInfo.size);
-    vkUnmapMemory(device_, shadowVolumeIndexBufferMemory_);
+    if (!uploadGeometryBuffer(vertices.data(), vertices.size() * sizeof(float), VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+                              shadowVolumeVertexBuffer_, shadowVolumeVertexBufferMemory_)) return false;
+    if (!uploadGeometryBuffer(indices.data(), indices.size() * sizeof(uint32_t), VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
+                              shadowVolumeIndexBuffer_, shadowVolumeIndexBufferMemory_)) return false;
     
-    printf("Created shadow volume geometry: %u indices for %zu buildings\n", shadowVolumeIndexCount_, buildings.size());
+    printf("Created shadow volume geometry: %u indices for %zu buildings\n", shadowVolumeIndexCount_, gen->getBuildingCount());
     return true;
 }
 
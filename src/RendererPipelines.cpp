@@ -98,17 +98,16 @@ bool Renderer::createPipeline() {
     fs.stage = VK_SHADER_STAGE_FRAGMENT_BIT; fs.module = frag; fs.pName = "main";
     VkPipelineShaderStageCreateInfo stages[2] = { vs, fs };
 
-    // Vertex format: position (vec3), color (vec3), uv (vec2), texIndex (float), normal (vec3) = 12 floats
-    VkVertexInputBindingDescription binding{}; binding.binding = 0; binding.stride = sizeof(float)*12; binding.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
-    VkVertexInputAttributeDescription attrs[5]{};
-    attrs[0].location = 0; attrs[0].binding = 0; attrs[0].format = VK_FORMAT_R32G32B32_SFLOAT; attrs[0].offset = 0;
-    attrs[1].location = 1; attrs[1].binding = 0; attrs[1].format = VK_FORMAT_R32G32B32_SFLOAT; attrs[1].offset = sizeof(float)*3;
-    attrs[2].location = 2; attrs[2].binding = 0; attrs[2].format = VK_FORMAT_R32G32_SFLOAT; attrs[2].offset = sizeof(float)*6;
-    attrs[3].location = 3; attrs[3].binding = 0; attrs[3].format = VK_FORMAT_R32_SFLOAT; attrs[3].offset = sizeof(float)*8;
-    attrs[4].location = 4; attrs[4].binding = 0; attrs[4].format = VK_FORMAT_R32G32B32_SFLOAT; attrs[4].offset = sizeof(float)*9;
+    // Packed ground vertex: position (snorm16x4), color (rgba8), uv (half2), face + texIndex (u8x4) = 20 bytes
+    VkVertexInputBindingDescription binding{}; binding.binding = 0; binding.stride = sizeof(GroundVertex); binding.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+    VkVertexInputAttributeDescription attrs[4]{};
+    attrs[0].location = 0; attrs[0].binding = 0; attrs[0].format = VK_FORMAT_R16G16B16A16_SNORM; attrs[0].offset = offsetof(GroundVertex, position);
+    attrs[1].location = 1; attrs[1].binding = 0; attrs[1].format = VK_FORMAT_R8G8B8A8_UNORM; attrs[1].offset = offsetof(GroundVertex, color);
+    attrs[2].location = 2; attrs[2].binding = 0; attrs[2].format = VK_FORMAT_R16G16_SFLOAT; attrs[2].offset = offsetof(GroundVertex, uv);
+    attrs[3].location = 3; attrs[3].binding = 0; attrs[3].format = VK_FORMAT_R8G8B8A8_UINT; attrs[3].offset = offsetof(GroundVertex, face);
     VkPipelineVertexInputStateCreateInfo vi{ VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO };
     vi.vertexBindingDescriptionCount = 1; vi.pVertexBindingDescriptions = &binding;
-    vi.vertexAttributeDescriptionCount = 5; vi.pVertexAttributeDescriptions = attrs;
+    vi.vertexAttributeDescriptionCount = 4; vi.pVertexAttributeDescriptions = attrs;
 
     VkPipelineInputAssemblyStateCreateInfo ia{ VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO };
     ia.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
@@ -131,9 +130,12 @@ bool Renderer::createPipeline() {
     VkPipelineColorBlendStateCreateInfo cb{ VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO };
     cb.attachmentCount = 1; cb.pAttachments = &cbAtt;
 
+    // Chunk origin for the packed city positions
+    VkPushConstantRange pushRange{ VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(float)*4 };
     VkDescriptorSetLayout setLayouts[] = { descriptorSetLayout_ };
     VkPipelineLayoutCreateInfo plci{ VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO };
     plci.setLayoutCount = 1; plci.pSetLayouts = setLayouts;
+    plci.pushConstantRangeCount = 1; plci.pPushConstantRanges = &pushRange;
     if (vkCreatePipelineLayout(device_, &plci, nullptr, &pipelineLayout_) != VK_SUCCESS) return false;
 
     VkGraphicsPipelineCreateInfo pci{ VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO };
@@ -175,17 +177,16 @@ bool Renderer::createPipelineWireframe() {
     fs.stage = VK_SHADER_STAGE_FRAGMENT_BIT; fs.module = frag; fs.pName = "main";
     VkPipelineShaderStageCreateInfo stages[2] = { vs, fs };
 
-    // Vertex format: position (vec3), color (vec3), uv (vec2), texIndex (float), normal (vec3) = 12 floats
-    VkVertexInputBindingDescription binding{}; binding.binding = 0; binding.stride = sizeof(float)*12; binding.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
-    VkVertexInputAttributeDescription attrs[5]{};
-    attrs[0].location = 0; attrs[0].binding = 0; attrs[0].format = VK_FORMAT_R32G32B32_SFLOAT; attrs[0].offset = 0;
-    attrs[1].location = 1; attrs[1].binding = 0; attrs[1].format = VK_FORMAT_R32G32B32_SFLOAT; attrs[1].offset = sizeof(float)*3;
-    attrs[2].location = 2; attrs[2].binding = 0; attrs[2].format = VK_FORMAT_R32G32_SFLOAT; attrs[2].offset = sizeof(float)*6;
-    attrs[3].location = 3; attrs[3].binding = 0; attrs[3].format = VK_FORMAT_R32_SFLOAT; attrs[3].offset = sizeof(float)*8;
-    attrs[4].location = 4; attrs[4].binding = 0; attrs[4].format = VK_FORMAT_R32G32B32_SFLOAT; attrs[4].offset = sizeof(float)*9;
+    // Packed ground vertex: position (snorm16x4), color (rgba8), uv (half2), face + texIndex (u8x4) = 20 bytes
+    VkVertexInputBindingDescription binding{}; binding.binding = 0; binding.stride = sizeof(GroundVertex); binding.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+    VkVertexInputAttributeDescription attrs[4]{};
+    attrs[0].location = 0; attrs[0].binding = 0; attrs[0].format = VK_FORMAT_R16G16B16A16_SNORM; attrs[0].offset = offsetof(GroundVertex, position);
+    attrs[1].location = 1; attrs[1].binding = 0; attrs[1].format = VK_FORMAT_R8G8B8A8_UNORM; attrs[1].offset = offsetof(GroundVertex, color);
+    attrs[2].location = 2; attrs[2].binding = 0; attrs[2].format = VK_FORMAT_R16G16_SFLOAT; attrs[2].offset = offsetof(GroundVertex, uv);
+    attrs[3].location = 3; attrs[3].binding = 0; attrs[3].format = VK_FORMAT_R8G8B8A8_UINT; attrs[3].offset = offsetof(GroundVertex, face);
     VkPipelineVertexInputStateCreateInfo vi{ VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO };
     vi.vertexBindingDescriptionCount = 1; vi.pVertexBindingDescriptions = &binding;
-    vi.vertexAttributeDescriptionCount = 5; vi.pVertexAttributeDescriptions = attrs;
+    vi.vertexAttributeDescriptionCount = 4; vi.pVertexAttributeDescriptions = attrs;
 
     VkPipelineInputAssemblyStateCreateInfo ia{ VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO };
     ia.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
@@ -230,6 +231,88 @@ bool Renderer::createPipelineWireframe() {
     return ok;
 }
 
+bool Renderer::createCityBoxPipelines() {
+    std::string base = std::string(PC_ENGINE_SHADER_DIR);
+    auto vertCode = readFile(base + "/city_box.vert.spv");
+    auto fragCode = readFile(base + "/city.frag.spv");
+    if (vertCode.empty() || fragCode.empty()) return false;
+
+    auto createShader = [&](const std::vector<char>& code) {
+        VkShaderModuleCreateInfo ci{ VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO };
+        ci.codeSize = code.size();
+        ci.pCode = reinterpret_cast<const uint32_t*>(code.data());
+        VkShaderModule m{}; vkCreateShaderModule(device_, &ci, nullptr, &m); return m;
+    };
+    VkShaderModule vert = createShader(vertCode);
+    VkShaderModule frag = createShader(fragCode);
+
+    VkPipelineShaderStageCreateInfo vs{ VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO };
+    vs.stage = VK_SHADER_STAGE_VERTEX_BIT; vs.module = vert; vs.pName = "main";
+    VkPipelineShaderStageCreateInfo fs{ VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO };
+    fs.stage = VK_SHADER_STAGE_FRAGMENT_BIT; fs.module = frag; fs.pName = "main";
+    VkPipelineShaderStageCreateInfo stages[2] = { vs, fs };
+
+    // Binding 0: unit box vertex, pos(3) + normal(3) + corner(2) = 8 floats
+    // Binding 1: packed part instance, position + size (snorm16x4 each), color (rgba8), texIndex (u8x4) = 24 bytes
+    VkVertexInputBindingDescription bindings[2]{};
+    bindings[0].binding = 0; bindings[0].stride = sizeof(float)*8; bindings[0].inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+    bindings[1].binding = 1; bindings[1].stride = sizeof(CityInstance); bindings[1].inputRate = VK_VERTEX_INPUT_RATE_INSTANCE;
+    VkVertexInputAttributeDescription attrs[7]{};
+    attrs[0].location = 0; attrs[0].binding = 0; attrs[0].format = VK_FORMAT_R32G32B32_SFLOAT; attrs[0].offset = 0;
+    attrs[1].location = 1; attrs[1].binding = 0; attrs[1].format = VK_FORMAT_R32G32B32_SFLOAT; attrs[1].offset = sizeof(float)*3;
+    attrs[2].location = 2; attrs[2].binding = 0; attrs[2].format = VK_FORMAT_R32G32_SFLOAT; attrs[2].offset = sizeof(float)*6;
+    attrs[3].location = 3; attrs[3].binding = 1; attrs[3].format = VK_FORMAT_R16G16B16A16_SNORM; attrs[3].offset = offsetof(CityInstance, position);
+    attrs[4].location = 4; attrs[4].binding = 1; attrs[4].format = VK_FORMAT_R16G16B16A16_SNORM; attrs[4].offset = offsetof(CityInstance, size);
+    attrs[5].location = 5; attrs[5].binding = 1; attrs[5].format = VK_FORMAT_R8G8B8A8_UNORM; attrs[5].offset = offsetof(CityInstance, color);
+    attrs[6].location = 6; attrs[6].binding = 1; attrs[6].format = VK_FORMAT_R8G8B8A8_UINT; attrs[6].offset = offsetof(CityInstance, texIndex);
+    VkPipelineVertexInputStateCreateInfo vi{ VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO };
+    vi.vertexBindingDescriptionCount = 2; vi.pVertexBindingDescriptions = bindings;
+    vi.vertexAttributeDescriptionCount = 7; vi.pVertexAttributeDescriptions = attrs;
+
+    VkPipelineInputAssemblyStateCreateInfo ia{ VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO };
+    ia.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+
+    VkViewport viewport{ 0, 0, (float)swapchainExtent_.width, (float)swapchainExtent_.height, 0, 1 };
+    VkRect2D scissor{ {0,0}, swapchainExtent_ };
+    VkPipelineViewportStateCreateInfo vp{ VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO };
+    vp.viewportCount = 1; vp.pViewports = &viewport; vp.scissorCount = 1; vp.pScissors = &scissor;
+
+    VkPipelineMultisampleStateCreateInfo ms{ VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO };
+    ms.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+
+    VkPipelineDepthStencilStateCreateInfo ds{ VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO };
+    ds.depthTestEnable = VK_TRUE; ds.depthWriteEnable = VK_TRUE; ds.depthCompareOp = VK_COMPARE_OP_LESS;
+
+    VkPipelineColorBlendAttachmentState cbAtt{}; cbAtt.colorWriteMask = 0xF; cbAtt.blendEnable = VK_FALSE;
+    VkPipelineColorBlendStateCreateInfo cb{ VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO };
+    cb.attachmentCount = 1; cb.pAttachments = &cbAtt;
+
+    // Same raster state as createPipeline() / createPipelineWireframe()
+    VkPipelineRasterizationStateCreateInfo rsFill{ VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO };
+    rsFill.polygonMode = VK_POLYGON_MODE_FILL; rsFill.cullMode = VK_CULL_MODE_BACK_BIT; rsFill.frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE; rsFill.lineWidth = 1.0f;
+    VkPipelineRasterizationStateCreateInfo rsWire = rsFill;
+    rsWire.polygonMode = VK_POLYGON_MODE_LINE; rsWire.cullMode = VK_CULL_MODE_NONE; rsWire.lineWidth = 1.5f;
+
+    VkGraphicsPipelineCreateInfo pci{ VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO };
+    pci.stageCount = 2; pci.pStages = stages;
+    pci.pVertexInputState = &vi;
+    pci.pInputAssemblyState = &ia;
+    pci.pViewportState = &vp;
+    pci.pRasterizationState = &rsFill;
+    pci.pMultisampleState = &ms;
+    pci.pDepthStencilState = &ds;
+    pci.pColorBlendState = &cb;
+    pci.layout = pipelineLayout_;  // Reuse city layout
+    pci.renderPass = hdrRenderPass_; // Use HDR render pass for scene rendering
+    pci.subpass = 0;
+    bool ok = (vkCreateGraphicsPipelines(device_, VK_NULL_HANDLE, 1, &pci, nullptr, &cityBoxPipeline_) == VK_SUCCESS);
+    pci.pRasterizationState = &rsWire;
+    ok = ok && (vkCreateGraphicsPipelines(device_, VK_NULL_HANDLE, 1, &pci, nullptr, &cityBoxPipelineWireframe_) == VK_SUCCESS);
+    vkDestroyShaderModule(device_, vert, nullptr);
+    vkDestroyShaderModule(device_, frag, nullptr);
+    return ok;
+}
+
 bool Renderer::createNeonPipeline() {
     std::string base = std::string(PC_ENGINE_SHADER_DIR);
     auto vertCode = readFile(base + "/neon.vert.spv");
@@ -293,9 +376,13 @@ bool Renderer::createNeonPipeline() {
     VkPipelineColorBlendStateCreateInfo cb{ VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO };
     cb.attachmentCount = 1; cb.pAttachments = &cbAtt;
 
+    // Same push constant range as pipelineLayout_ so the descriptor set bound
+    // through pipelineLayout_ stays compatible with this pipeline
+    VkPushConstantRange pushRange{ VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(float)*4 };
     VkDescriptorSetLayout setLayouts[] = { descriptorSetLayout_ };
     VkPipelineLayoutCreateInfo plci{ VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO };
     plci.setLayoutCount = 1; plci.pSetLayouts = setLayouts;
+    plci.pushConstantRangeCount = 1; plci.pPushConstantRanges = &pushRange;
     VkPipelineLayout neonLayout;
     if (vkCreatePipelineLayout(device_, &plci, nullptr, &neonLayout) != VK_SUCCESS) {
         vkDestroyShaderModule(device_, vert, nullptr);
@@ -323,17 +410,16 @@ bool Renderer::createNeonPipeline() {
 }
 
 bool Renderer::reloadShaders() {
-    // Wait for device to be idle before recreating pipeline
-    vkDeviceWaitIdle(device_);
-    
-    // Destroy old pipeline
-    if (graphicsPipeline_ != VK_NULL_HANDLE) {
-        vkDestroyPipeline(device_, graphicsPipeline_, nullptr);
-        graphicsPipeline_ = VK_NULL_HANDLE;
-    }
+    // The frame in flight may still be using the old pipelines: retire them
+    // rather than idling the device. createPipeline makes a new layout too.
+    retirePipeline(graphicsPipeline_);
+    retirePipeline(graphicsPipelineWireframe_);
+    retirePipeline(cityBoxPipeline_);
+    retirePipeline(cityBoxPipelineWireframe_);
+    retirePipelineLayout(pipelineLayout_);
     
-    // Recreate pipeline with new shaders
-    return createPipeline();
+    // Recreate pipelines with new shaders
+    return createPipeline() && createPipelineWireframe() && createCityBoxPipelines();
 }
 
 }
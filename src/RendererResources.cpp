@@ -23,118 +23,194 @@ bool Renderer::createBuffer(BufferWithMemory& buffer, VkDeviceSize size, VkBuffe
     bi.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
     if (vkCreateBuffer(device_, &bi, nullptr, &buffer.buffer) != VK_SUCCESS) return false;
 
-    VkMemoryRequirements req{};
-    vkGetBufferMemoryRequirements(device_, buffer.buffer, &req);
-
-    VkMemoryAllocateInfo ai{ VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO };
-    ai.allocationSize = req.size;
-    ai.memoryTypeIndex = findMemoryType(req.memoryTypeBits, properties);
-    if (vkAllocateMemory(device_, &ai, nullptr, &buffer.memory) != VK_SUCCESS) {
+    if (!allocator_.allocateForBuffer(buffer.buffer, properties, buffer.memory)) {
         vkDestroyBuffer(device_, buffer.buffer, nullptr);
         buffer.buffer = VK_NULL_HANDLE;
         return false;
     }
 
-    if (vkBindBufferMemory(device_, buffer.buffer, buffer.memory, 0) != VK_SUCCESS) {
-        vkDestroyBuffer(device_, buffer.buffer, nullptr);
-        vkFreeMemory(device_, buffer.memory, nullptr);
-        buffer.buffer = VK_NULL_HANDLE;
-        buffer.memory = VK_NULL_HANDLE;
+    // Host-visible allocations are persistently mapped by the allocator
+    buffer.mapped = map ? buffer.memory.mapped : nullptr;
+    if (map && !buffer.mapped) {
+        destroyBuffer(buffer);
         return false;
     }
 
-    buffer.mapped = nullptr;
-    if (map) {
-        if (vkMapMemory(device_, buffer.memory, 0, size, 0, &buffer.mapped) != VK_SUCCESS) {
-            vkDestroyBuffer(device_, buffer.buffer, nullptr);
-            vkFreeMemory(device_, buffer.memory, nullptr);
-            buffer.buffer = VK_NULL_HANDLE;
-            buffer.memory = VK_NULL_HANDLE;
-            buffer.mapped = nullptr;
-            return false;
-        }
-    }
-
     return true;
 }
 
 void Renderer::destroyBuffer(BufferWithMemory& buffer) {
-    if (buffer.mapped) {
-        vkUnmapMemory(device_, buffer.memory);
-        buffer.mapped = nullptr;
-    }
+    buffer.mapped = nullptr;
     if (buffer.buffer) {
         vkDestroyBuffer(device_, buffer.buffer, nullptr);
         buffer.buffer = VK_NULL_HANDLE;
     }
-    if (buffer.memory) {
-        vkFreeMemory(device_, buffer.memory, nullptr);
-        buffer.memory = VK_NULL_HANDLE;
+    allocator_.free(buffer.memory);
+}
+
+void Renderer::retireBuffer(VkBuffer& buffer, GpuAllocation& memory) {
+    if (buffer) {
+        // Nothing will draw from it, don't copy into it either
+        cancelPendingUploads(buffer);
+    }
+    if (buffer || memory) {
+        RetiredResource retired;
+        retired.frame = frameNumber_;
+        retired.buffer = buffer;
+        retired.memory = memory;
+        retiredResources_.push_back(retired);
+    }
+    buffer = VK_NULL_HANDLE;
+    memory = GpuAllocation{};
+}
+
+void Renderer::retireImage(VkImage& image, VkImageView& view, GpuAllocation& memory) {
+    if (image || view || memory) {
+        RetiredResource retired;
+        retired.frame = frameNumber_;
+        retired.image = image;
+        retired.view = view;
+        retired.memory = memory;
+        retiredResources_.push_back(retired);
+    }
+    image = VK_NULL_HANDLE;
+    view = VK_NULL_HANDLE;
+    memory = GpuAllocation{};
+}
+
+void Renderer::retirePipeline(VkPipeline& pipeline) {
+    if (pipeline) {
+        RetiredResource retired;
+        retired.frame = frameNumber_;
+        retired.pipeline = pipeline;
+        retiredResources_.push_back(retired);
+    }
+    pipeline = VK_NULL_HANDLE;
+}
+
+void Renderer::retirePipelineLayout(VkPipelineLayout& layout) {
+    if (layout) {
+        RetiredResource retired;
+        retired.frame = frameNumber_;
+        retired.pipelineLayout = layout;
+        retiredResources_.push_back(retired);
+    }
+    layout = VK_NULL_HANDLE;
+}
+
+void Renderer::retireDescriptorPool(VkDescriptorPool& pool) {
+    if (pool) {
+        // Takes the sets allocated from it along
+        RetiredResource retired;
+        retired.frame = frameNumber_;
+        retired.descriptorPool = pool;
+        retiredResources_.push_back(retired);
+    }
+    pool = VK_NULL_HANDLE;
+}
+
+void Renderer::retireDescriptorSetLayout(VkDescriptorSetLayout& layout) {
+    if (layout) {
+        RetiredResource retired;
+        retired.frame = frameNumber_;
+        retired.descriptorSetLayout = layout;
+        retiredResources_.push_back(retired);
+    }
+    layout = VK_NULL_HANDLE;
+}
+
+void Renderer::retireSampler(VkSampler& sampler) {
+    if (sampler) {
+        RetiredResource retired;
+        retired.frame = frameNumber_;
+        retired.sampler = sampler;
+        retiredResources_.push_back(retired);
+    }
+    sampler = VK_NULL_HANDLE;
+}
+
+void Renderer::releaseRetiredResources(uint64_t completedFrame) {
+    // Frame numbers only grow, so everything releasable sits at the front
+    while (!retiredResources_.empty() && retiredResources_.front().frame <= completedFrame) {
+        RetiredResource& retired = retiredResources_.front();
+        if (retired.pipeline) vkDestroyPipeline(device_, retired.pipeline, nullptr);
+        if (retired.pipelineLayout) vkDestroyPipelineLayout(device_, retired.pipelineLayout, nullptr);
+        if (retired.descriptorPool) vkDestroyDescriptorPool(device_, retired.descriptorPool, nullptr);
+        if (retired.descriptorSetLayout) vkDestroyDescriptorSetLayout(device_, retired.descriptorSetLayout, nullptr);
+        if (retired.sampler) vkDestroySampler(device_, retired.sampler, nullptr);
+        if (retired.view) vkDestroyImageView(device_, retired.view, nullptr);
+        if (retired.image) vkDestroyImage(device_, retired.image, nullptr);
+        if (retired.buffer) vkDestroyBuffer(device_, retired.buffer, nullptr);
+        allocator_.free(retired.memory);
+        retiredResources_.pop_front();
     }
 }
 
 bool Renderer::createUniformBuffers() {
-    uniformBuffers_.resize(1);
+    uniformBuffers_.resize(kMaxFramesInFlight);
     VkBufferCreateInfo bi{ VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO };
     bi.size = sizeof(UniformBufferObject);
     bi.usage = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT;
-    if (vkCreateBuffer(device_, &bi, nullptr, &uniformBuffers_[0].buffer) != VK_SUCCESS) return false;
-    VkMemoryRequirements req{}; vkGetBufferMemoryRequirements(device_, uniformBuffers_[0].buffer, &req);
-    VkMemoryAllocateInfo ai{ VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO };
-    ai.allocationSize = req.size; ai.memoryTypeIndex = findMemoryType(req.memoryTypeBits, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
-    if (vkAllocateMemory(device_, &ai, nullptr, &uniformBuffers_[0].memory) != VK_SUCCESS) return false;
-    vkBindBufferMemory(device_, uniformBuffers_[0].buffer, uniformBuffers_[0].memory, 0);
-    return vkMapMemory(device_, uniformBuffers_[0].memory, 0, bi.size, 0, &uniformBuffers_[0].mapped) == VK_SUCCESS;
+    for (auto& ub : uniformBuffers_) {
+        if (vkCreateBuffer(device_, &bi, nullptr, &ub.buffer) != VK_SUCCESS) return false;
+        if (!allocator_.allocateForBuffer(ub.buffer, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                                          ub.memory, GpuAllocationStrategy::Linear)) return false;
+        ub.mapped = ub.memory.mapped;
+    }
+    return true;
 }
 
 bool Renderer::createDescriptorPoolAndSets() {
     VkDescriptorPoolSize sizes[4]{};
-    sizes[0].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER; sizes[0].descriptorCount = 1;
-    sizes[1].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER; sizes[1].descriptorCount = kMaxBuildingTextures;
-    sizes[2].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER; sizes[2].descriptorCount = 1; // Neon array texture
-    sizes[3].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER; sizes[3].descriptorCount = 1; // Shadow map
+    sizes[0].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER; sizes[0].descriptorCount = kMaxFramesInFlight;
+    sizes[1].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER; sizes[1].descriptorCount = kMaxBuildingTextures * kMaxFramesInFlight;
+    sizes[2].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER; sizes[2].descriptorCount = kMaxFramesInFlight; // Neon array texture
+    sizes[3].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER; sizes[3].descriptorCount = kMaxFramesInFlight; // Shadow map
     
     VkDescriptorPoolCreateInfo pci{ VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO };
-    pci.maxSets = 1; pci.poolSizeCount = 4; pci.pPoolSizes = sizes;
+    pci.maxSets = kMaxFramesInFlight; pci.poolSizeCount = 4; pci.pPoolSizes = sizes;
     if (vkCreateDescriptorPool(device_, &pci, nullptr, &descriptorPool_) != VK_SUCCESS) return false;
 
     VkDescriptorSetAllocateInfo ai{ VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO };
     ai.descriptorPool = descriptorPool_;
-    ai.descriptorSetCount = 1;
-    VkDescriptorSetLayout layouts[] = { descriptorSetLayout_ };
-    ai.pSetLayouts = layouts;
-    descriptorSets_.resize(1);
+    ai.descriptorSetCount = kMaxFramesInFlight;
+    std::vector<VkDescriptorSetLayout> layouts(kMaxFramesInFlight, descriptorSetLayout_);
+    ai.pSetLayouts = layouts.data();
+    descriptorSets_.resize(kMaxFramesInFlight);
     if (vkAllocateDescriptorSets(device_, &ai, descriptorSets_.data()) != VK_SUCCESS) return false;
 
-    VkDescriptorBufferInfo bi{}; bi.buffer = uniformBuffers_[0].buffer; bi.offset = 0; bi.range = sizeof(UniformBufferObject);
-    VkWriteDescriptorSet write[4]{};
-    write[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-    write[0].dstSet = descriptorSets_[0]; write[0].dstBinding = 0; write[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER; write[0].descriptorCount = 1; write[0].pBufferInfo = &bi;
+    // Same textures in every frame's set, only the uniform buffer differs
+    for (uint32_t frame = 0; frame < kMaxFramesInFlight; ++frame) {
+        VkDescriptorBufferInfo bi{}; bi.buffer = uniformBuffers_[frame].buffer; bi.offset = 0; bi.range = sizeof(UniformBufferObject);
+        VkWriteDescriptorSet write[4]{};
+        write[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        write[0].dstSet = descriptorSets_[frame]; write[0].dstBinding = 0; write[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER; write[0].descriptorCount = 1; write[0].pBufferInfo = &bi;
     
-    std::vector<VkDescriptorImageInfo> imageInfos(kMaxBuildingTextures);
-    for (int i = 0; i < kMaxBuildingTextures; ++i) {
-        imageInfos[i].imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-        imageInfos[i].imageView = (i < numBuildingTextures_ && buildingTextureViews_[i]) ? buildingTextureViews_[i] : (numBuildingTextures_ > 0 ? buildingTextureViews_[0] : VK_NULL_HANDLE);
-        imageInfos[i].sampler = textureSampler_;
-    }
-    write[1].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-    write[1].dstSet = descriptorSets_[0]; write[1].dstBinding = 1; write[1].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER; write[1].descriptorCount = kMaxBuildingTextures; write[1].pImageInfo = imageInfos.data();
-
-    VkDescriptorImageInfo neonInfo{};
-    neonInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-    neonInfo.imageView = neonArrayView_;
-    neonInfo.sampler = textureSampler_;
-    write[2].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-    write[2].dstSet = descriptorSets_[0]; write[2].dstBinding = 2; write[2].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER; write[2].descriptorCount = 1; write[2].pImageInfo = &neonInfo;
+        std::vector<VkDescriptorImageInfo> imageInfos(kMaxBuildingTextures);
+        for (int i = 0; i < kMaxBuildingTextures; ++i) {
+            imageInfos[i].imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+            imageInfos[i].imageView = (i < numBuildingTextures_ && buildingTextureViews_[i]) ? buildingTextureViews_[i] : (numBuildingTextures_ > 0 ? buildingTextureViews_[0] : VK_NULL_HANDLE);
+            imageInfos[i].sampler = textureSampler_;
+        }
+        write[1].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        write[1].dstSet = descriptorSets_[frame]; write[1].dstBinding = 1; write[1].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER; write[1].descriptorCount = kMaxBuildingTextures; write[1].pImageInfo = imageInfos.data();
+
+        VkDescriptorImageInfo neonInfo{};
+        neonInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        neonInfo.imageView = neonArrayView_;
+        neonInfo.sampler = textureSampler_;
+        write[2].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        write[2].dstSet = descriptorSets_[frame]; write[2].dstBinding = 2; write[2].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER; write[2].descriptorCount = 1; write[2].pImageInfo = &neonInfo;
     
-    VkDescriptorImageInfo shadowMapInfo{};
-    shadowMapInfo.imageLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
-    shadowMapInfo.imageView = shadowMapView_;
-    shadowMapInfo.sampler = shadowMapSampler_;
-    write[3].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-    write[3].dstSet = descriptorSets_[0]; write[3].dstBinding = 3; write[3].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER; write[3].descriptorCount = 1; write[3].pImageInfo = &shadowMapInfo;
+        VkDescriptorImageInfo shadowMapInfo{};
+        shadowMapInfo.imageLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
+        shadowMapInfo.imageView = shadowMapView_;
+        shadowMapInfo.sampler = shadowMapSampler_;
+        write[3].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        write[3].dstSet = descriptorSets_[frame]; write[3].dstBinding = 3; write[3].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER; write[3].descriptorCount = 1; write[3].pImageInfo = &shadowMapInfo;
     
-    vkUpdateDescriptorSets(device_, 4, write, 0, nullptr);
+        vkUpdateDescriptorSets(device_, 4, write, 0, nullptr);
+    }
     return true;
 }
 
@@ -242,26 +318,17 @@ bool Renderer::loadNeonTextures() {
     imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
     if (vkCreateImage(device_, &imageInfo, nullptr, &neonArrayImage_) != VK_SUCCESS) return false;
 
-    VkMemoryRequirements memReq;
-    vkGetImageMemoryRequirements(device_, neonArrayImage_, &memReq);
-    VkMemoryAllocateInfo allocInfo{ VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO };
-    allocInfo.allocationSize = memReq.size;
-    allocInfo.memoryTypeIndex = findMemoryType(memReq.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-    if (vkAllocateMemory(device_, &allocInfo, nullptr, &neonArrayMemory_) != VK_SUCCESS) return false;
-    vkBindImageMemory(device_, neonArrayImage_, neonArrayMemory_, 0);
+    if (!allocator_.allocateForImage(neonArrayImage_, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, neonArrayMemory_, GpuAllocationStrategy::Linear)) return false;
 
     // Staging buffer
     VkDeviceSize bufferSize = pixels.size();
     VkBuffer stagingBuffer;
-    VkDeviceMemory stagingMemory;
+    GpuAllocation stagingMemory;
     VkBufferCreateInfo bi{ VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO };
     bi.size = bufferSize; bi.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT; bi.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
     if (vkCreateBuffer(device_, &bi, nullptr, &stagingBuffer) != VK_SUCCESS) return false;
-    vkGetBufferMemoryRequirements(device_, stagingBuffer, &memReq);
-    allocInfo.allocationSize = memReq.size; allocInfo.memoryTypeIndex = findMemoryType(memReq.memoryTypeBits, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
-    if (vkAllocateMemory(device_, &allocInfo, nullptr, &stagingMemory) != VK_SUCCESS) return false;
-    vkBindBufferMemory(device_, stagingBuffer, stagingMemory, 0);
-    void* data; if (vkMapMemory(device_, stagingMemory, 0, bufferSize, 0, &data) != VK_SUCCESS) return false; std::memcpy(data, pixels.data(), (size_t)bufferSize); vkUnmapMemory(device_, stagingMemory);
+    if (!allocator_.allocateForBuffer(stagingBuffer, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, stagingMemory)) return false;
+    std::memcpy(stagingMemory.mapped, pixels.data(), (size_t)bufferSize);
 
     // Copy to image
     VkCommandBufferAllocateInfo cai{ VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO };
@@ -292,7 +359,7 @@ bool Renderer::loadNeonTextures() {
     VkSubmitInfo submit{ VK_STRUCTURE_TYPE_SUBMIT_INFO }; submit.commandBufferCount = 1; submit.pCommandBuffers = &cmd;
     vkQueueSubmit(graphicsQueue_, 1, &submit, VK_NULL_HANDLE); vkQueueWaitIdle(graphicsQueue_);
     vkFreeCommandBuffers(device_, commandPool_, 1, &cmd);
-    vkFreeMemory(device_, stagingMemory, nullptr); vkDestroyBuffer(device_, stagingBuffer, nullptr);
+    vkDestroyBuffer(device_, stagingBuffer, nullptr); allocator_.free(stagingMemory);
 
     // View
     VkImageViewCreateInfo viewInfo{ VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO };
@@ -304,7 +371,7 @@ bool Renderer::loadNeonTextures() {
     return true;
 }
 
-bool Renderer::createTextureImage(const std::string& filename, VkImage& image, VkDeviceMemory& memory) {
+bool Renderer::createTextureImage(const std::string& filename, VkImage& image, GpuAllocation& memory) {
 #if defined(__APPLE__)
     // Load image using CoreGraphics
     CFStringRef cfPath = CFStringCreateWithCString(kCFAllocatorDefault, filename.c_str(), kCFStringEncodingUTF8);
@@ -353,19 +420,10 @@ bool Renderer::createTextureImage(const std::string& filename, VkImage& image, V
         
     if (vkCreateImage(device_, &imageInfo, nullptr, &image) != VK_SUCCESS) return false;
         
-    VkMemoryRequirements memReq;
-    vkGetImageMemoryRequirements(device_, image, &memReq);
-    VkMemoryAllocateInfo allocInfo{ VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO };
-    allocInfo.allocationSize = memReq.size;
-    allocInfo.memoryTypeIndex = findMemoryType(memReq.memoryTypeBits, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
-    if (vkAllocateMemory(device_, &allocInfo, nullptr, &memory) != VK_SUCCESS) return false;
-    vkBindImageMemory(device_, image, memory, 0);
+    if (!allocator_.allocateForImage(image, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, memory, GpuAllocationStrategy::Linear)) return false;
     
     // Copy pixel data
-    void* data = nullptr;
-    if (vkMapMemory(device_, memory, 0, memReq.size, 0, &data) != VK_SUCCESS) return false;
-    std::memcpy(data, pixels.data(), pixels.size());
-    vkUnmapMemory(device_, memory);
+    std::memcpy(memory.mapped, pixels.data(), pixels.size());
     
     return true;
 #else
@@ -20,13 +20,7 @@ bool Renderer::createShadowMapResources() {
     
     if (vkCreateImage(device_, &imageInfo, nullptr, &shadowMapImage_) != VK_SUCCESS) return false;
     
-    VkMemoryRequirements memReq;
-    vkGetImageMemoryRequirements(device_, shadowMapImage_, &memReq);
-    VkMemoryAllocateInfo allocInfo{ VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO };
-    allocInfo.allocationSize = memReq.size;
-    allocInfo.memoryTypeIndex = findMemoryType(memReq.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-    if (vkAllocateMemory(device_, &allocInfo, nullptr, &shadowMapMemory_) != VK_SUCCESS) return false;
-    vkBindImageMemory(device_, shadowMapImage_, shadowMapMemory_, 0);
+    if (!allocator_.allocateForImage(shadowMapImage_, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, shadowMapMemory_, GpuAllocationStrategy::Linear)) return false;
     
     // Create shadow map image view
     VkImageViewCreateInfo viewInfo{ VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO };
@@ -114,12 +108,11 @@ void Renderer::renderShadowMap(VkCommandBuffer cmd) {
     vkCmdBeginRenderPass(cmd, &rpInfo, VK_SUBPASS_CONTENTS_INLINE);
     
     // Render city geometry from light's perspective
-    vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, graphicsPipeline_);
-    VkDeviceSize offs = 0;
-    vkCmdBindVertexBuffers(cmd, 0, 1, &cityVertexBuffer_, &offs);
-    vkCmdBindIndexBuffer(cmd, cityIndexBuffer_, 0, VK_INDEX_TYPE_UINT32);  // Changed from UINT16 to UINT32
-    vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout_, 0, 1, &descriptorSets_[0], 0, nullptr);
-    vkCmdDrawIndexed(cmd, cityIndexCount_, 1, 0, 0, 0);
+    vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, cityBoxPipeline_);
+    vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout_, 0, 1, &descriptorSets_[currentFrame_], 0, nullptr);
+    for (const auto& entry : chunkGeometry_) {
+        drawChunkBuildings(cmd, entry.second);
+    }
     
     vkCmdEndRenderPass(cmd);
     
@@ -161,7 +161,7 @@ void Renderer::renderShadowVolumes(VkCommandBuffer cmd) {
     // Bind shadow volume pipeline
     vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, shadowVolumePipeline_);
     vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout_,
-                           0, 1, &descriptorSets_[0], 0, nullptr);
+                           0, 1, &descriptorSets_[currentFrame_], 0, nullptr);
     
     VkDeviceSize offset = 0;
     vkCmdBindVertexBuffers(cmd, 0, 1, &shadowVolumeVertexBuffer_, &offset);
@@ -29,6 +29,12 @@ bool Renderer::createSwapchain() {
     if (vkCreateSwapchainKHR(device_, &ci, nullptr, &swapchain_) != VK_SUCCESS) return false;
     uint32_t count = 0; vkGetSwapchainImagesKHR(device_, swapchain_, &count, nullptr);
     swapchainImages_.resize(count); vkGetSwapchainImagesKHR(device_, swapchain_, &count, swapchainImages_.data());
+    // The image count can change with the swapchain, so these are rebuilt with it
+    VkSemaphoreCreateInfo si{ VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO };
+    renderFinished_.assign(count, VK_NULL_HANDLE);
+    for (auto& semaphore : renderFinished_) {
+        if (vkCreateSemaphore(device_, &si, nullptr, &semaphore) != VK_SUCCESS) return false;
+    }
     return true;
 }
 
@@ -52,10 +58,14 @@ void Renderer::cleanupSwapchain() {
     for (auto fb : framebuffers_) vkDestroyFramebuffer(device_, fb, nullptr); framebuffers_.clear();
     if (depthImageView_) vkDestroyImageView(device_, depthImageView_, nullptr); depthImageView_ = VK_NULL_HANDLE;
     if (depthImage_) vkDestroyImage(device_, depthImage_, nullptr); depthImage_ = VK_NULL_HANDLE;
-    if (depthImageMemory_) vkFreeMemory(device_, depthImageMemory_, nullptr); depthImageMemory_ = VK_NULL_HANDLE;
+    allocator_.free(depthImageMemory_);
     for (auto iv : swapchainImageViews_) vkDestroyImageView(device_, iv, nullptr); swapchainImageViews_.clear();
     if (renderPass_) vkDestroyRenderPass(device_, renderPass_, nullptr); renderPass_ = VK_NULL_HANDLE;
     if (swapchain_) vkDestroySwapchainKHR(device_, swapchain_, nullptr); swapchain_ = VK_NULL_HANDLE;
+    for (auto semaphore : renderFinished_) {
+        if (semaphore) vkDestroySemaphore(device_, semaphore, nullptr);
+    }
+    renderFinished_.clear();
 }
 
 void Renderer::recreateSwapchain() {
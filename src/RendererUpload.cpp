@@ -0,0 +1,186 @@
+#include "Renderer.hpp"
+#include <vulkan/vulkan.h>
+#include <algorithm>
+#include <cstring>
+#include <cstdio>
+
+namespace pcengine {
+
+namespace {
+
+constexpr VkDeviceSize kUploadAlignment = 16;
+
+VkDeviceSize alignUp(VkDeviceSize value, VkDeviceSize alignment) {
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+}
+
+bool Renderer::createUploadRing() {
+    VkBufferCreateInfo bufferInfo{ VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO };
+    bufferInfo.size = kUploadRingSize;
+    bufferInfo.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+    if (vkCreateBuffer(device_, &bufferInfo, nullptr, &uploadRing_.buffer) != VK_SUCCESS) return false;
+
+    if (!allocator_.allocateForBuffer(uploadRing_.buffer, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                                      uploadRing_.memory, GpuAllocationStrategy::Linear)) return false;
+
+    // Mapped for the lifetime of the renderer
+    uploadRing_.mapped = uploadRing_.memory.mapped;
+    return uploadRing_.mapped != nullptr;
+}
+
+void Renderer::destroyUploadRing() {
+    pendingUploads_.clear();
+    uploadRing_.batchEnds.clear();
+    if (uploadRing_.buffer) vkDestroyBuffer(device_, uploadRing_.buffer, nullptr);
+    allocator_.free(uploadRing_.memory);
+    uploadRing_ = UploadRing{};
+}
+
+bool Renderer::allocateUploadSpace(VkDeviceSize size, VkDeviceSize& offset) {
+    UploadRing& ring = uploadRing_;
+    VkDeviceSize aligned = alignUp(ring.head, kUploadAlignment);
+
+    if (ring.tail <= ring.head) {
+        // Live data in [tail, head): use the end of the ring, or wrap to the front
+        if (aligned + size <= kUploadRingSize) {
+            offset = aligned;
+        } else if (size < ring.tail) {
+            offset = 0;
+        } else {
+            return false;
+        }
+    } else {
+        // Wrapped, live data in [tail, end) and [0, head). Stay strictly below
+        // tail so head == tail keeps meaning "empty".
+        if (aligned + size < ring.tail) {
+            offset = aligned;
+        } else {
+            return false;
+        }
+    }
+    ring.head = offset + size;
+    return true;
+}
+
+bool Renderer::uploadsFitRing(std::initializer_list<VkDeviceSize> sizes) const {
+    // Conservative: an empty ring may still have its tail off zero, which
+    // leaves it one byte short of kUploadRingSize
+    VkDeviceSize total = 0;
+    for (VkDeviceSize size : sizes) {
+        total += alignUp(size, kUploadAlignment);
+    }
+    return total < kUploadRingSize;
+}
+
+bool Renderer::canStageUploads(std::initializer_list<VkDeviceSize> sizes) {
+    // Trial allocation: only head moves, so put it back afterwards
+    VkDeviceSize savedHead = uploadRing_.head;
+    bool fits = true;
+    for (VkDeviceSize size : sizes) {
+        VkDeviceSize offset = 0;
+        if (size != 0 && !allocateUploadSpace(size, offset)) {
+            fits = false;
+            break;
+        }
+    }
+    uploadRing_.head = savedHead;
+    return fits;
+}
+
+bool Renderer::stageBufferUpload(const void* data, VkDeviceSize size, VkBuffer dst, VkDeviceSize dstOffset) {
+    if (size == 0) return true;
+    if (size > kUploadRingSize) {
+        printf("Upload of %llu bytes does not fit the %llu byte staging ring\n",
+               (unsigned long long)size, (unsigned long long)kUploadRingSize);
+        return false;
+    }
+
+    VkDeviceSize offset = 0;
+    if (!allocateUploadSpace(size, offset)) {
+        // Ring is full of data the GPU has not consumed yet. Callers that can wait
+        // check canStageUploads() first and retry on a later frame.
+        return false;
+    }
+
+    std::memcpy(static_cast<char*>(uploadRing_.mapped) + offset, data, static_cast<size_t>(size));
+
+    PendingUpload upload;
+    upload.dst = dst;
+    upload.region.srcOffset = offset;
+    upload.region.dstOffset = dstOffset;
+    upload.region.size = size;
+    pendingUploads_.push_back(upload);
+    return true;
+}
+
+void Renderer::cancelPendingUploads(VkBuffer dst) {
+    // The staging space is reclaimed with the rest of the batch
+    pendingUploads_.erase(std::remove_if(pendingUploads_.begin(), pendingUploads_.end(),
+                                         [dst](const PendingUpload& upload) { return upload.dst == dst; }),
+                          pendingUploads_.end());
+}
+
+void Renderer::recordPendingUploads(VkCommandBuffer cmd) {
+    if (pendingUploads_.empty()) return;
+
+    // Consecutive copies into the same buffer go out as one command
+    size_t first = 0;
+    std::vector<VkBufferCopy> regions;
+    while (first < pendingUploads_.size()) {
+        VkBuffer dst = pendingUploads_[first].dst;
+        regions.clear();
+        size_t last = first;
+        while (last < pendingUploads_.size() && pendingUploads_[last].dst == dst) {
+            regions.push_back(pendingUploads_[last].region);
+            ++last;
+        }
+        vkCmdCopyBuffer(cmd, uploadRing_.buffer, dst, static_cast<uint32_t>(regions.size()), regions.data());
+        first = last;
+    }
+
+    // Everything this frame draws comes after, one barrier covers all copies
+    VkMemoryBarrier barrier{ VK_STRUCTURE_TYPE_MEMORY_BARRIER };
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT;
+    vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+
+    pendingUploads_.clear();
+    uploadRing_.batchEnds.emplace_back(frameNumber_, uploadRing_.head);
+}
+
+void Renderer::reclaimUploadSpace(uint64_t completedFrame) {
+    // Batches recorded up to completedFrame have been consumed; later frames may still be reading theirs
+    while (!uploadRing_.batchEnds.empty() && uploadRing_.batchEnds.front().first <= completedFrame) {
+        uploadRing_.tail = uploadRing_.batchEnds.front().second;
+        uploadRing_.batchEnds.pop_front();
+    }
+    if (pendingUploads_.empty() && uploadRing_.batchEnds.empty() && uploadRing_.tail == uploadRing_.head) {
+        uploadRing_.head = 0;
+        uploadRing_.tail = 0;
+    }
+}
+
+// Setup only: waits for the queue to go idle, frames defer uploads that don't fit instead
+void Renderer::flushUploadsImmediate() {
+    VkCommandBuffer cmd = VK_NULL_HANDLE;
+    if (!pendingUploads_.empty()) {
+        VkCommandBufferAllocateInfo cai{ VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO };
+        cai.commandPool = commandPool_; cai.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY; cai.commandBufferCount = 1;
+        if (vkAllocateCommandBuffers(device_, &cai, &cmd) != VK_SUCCESS) return;
+        VkCommandBufferBeginInfo cbi{ VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO };
+        cbi.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT; vkBeginCommandBuffer(cmd, &cbi);
+        recordPendingUploads(cmd);
+        vkEndCommandBuffer(cmd);
+        VkSubmitInfo submit{ VK_STRUCTURE_TYPE_SUBMIT_INFO }; submit.commandBufferCount = 1; submit.pCommandBuffers = &cmd;
+        vkQueueSubmit(graphicsQueue_, 1, &submit, VK_NULL_HANDLE);
+    }
+    vkQueueWaitIdle(graphicsQueue_);
+    if (cmd) vkFreeCommandBuffers(device_, commandPool_, 1, &cmd);
+    uploadRing_.batchEnds.clear();
+    uploadRing_.head = 0;
+    uploadRing_.tail = 0;
+}
+
+}
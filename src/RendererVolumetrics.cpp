@@ -14,6 +14,7 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_inverse.hpp>
 #include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/packing.hpp>
 
 namespace pcengine {
 
@@ -51,23 +52,91 @@ float henyeGreenstein(float cosTheta, float g) {
     return (1.0f - g * g) / (denom * std::sqrt(denom));
 }
 
-constexpr VkFormat kFroxelDensityFormat = VK_FORMAT_R16_SFLOAT;
 constexpr VkFormat kFroxelLightFormat = VK_FORMAT_R16G16B16A16_SFLOAT;
 constexpr VkFormat kScatteringFormat = VK_FORMAT_R16G16B16A16_SFLOAT;
 constexpr VkFormat kTransmittanceFormat = VK_FORMAT_R16_SFLOAT;
 
 constexpr uint32_t kMaxVolumetricLights = 1024;
 constexpr uint32_t kMaxClusterEntries = 512u * 1024u;
+constexpr uint32_t kMaxViewClusterEntries = 256;   // Per view-space brick, lights + densities in vol_view_cluster_build.comp
 constexpr uint32_t kMaxDensityVolumes = 2048;
+constexpr uint32_t kDensityAlbedoPaletteSize = 64;  // Entries ahead of the records, matches vol_density_inject.comp
+constexpr VkDeviceSize kDensityPaletteBytes = kDensityAlbedoPaletteSize * 2 * sizeof(uint32_t);
+constexpr VkDeviceSize kDensityHeaderBytes = kDensityPaletteBytes + sizeof(glm::ivec4);  // Palette, then the cell base
+constexpr int kDensityCellBaseSnap = 8192;  // Cells, keeps record bounds well within int16 of the base
+constexpr uint32_t kLightShapeBoxBit = 0x80000000u; // Matches vol_light_inject.comp
 constexpr float kFroxelCellSizeXZ = 4.0f;
 constexpr float kFroxelCellSizeY = 4.0f;
+constexpr int kFroxelBrickSize = 4;               // Brick edge in froxels, matches kBrickSize in the shaders
+constexpr float kIntegrationNearSlice = 1.0f;      // Far end of the first integration slice, the rest are exponential
+constexpr float kLightBeamMaxHeight = 400.0f;     // Beam cutoff in vol_light_inject.comp
+constexpr float kLightBeamMaxSpread = 1.2f * (1.0f + kLightBeamMaxHeight * 0.001f);
+
+// Bricks of kFroxelBrickSize^3 froxels covering the view-space volume
+glm::ivec3 viewFroxelBricks(const VkExtent3D& grid) {
+    return (glm::ivec3(grid.width, grid.height, grid.depth) + (kFroxelBrickSize - 1)) / kFroxelBrickSize;
+}
+
+// Image sizes createVolumetricResources allocates for a config
+struct VolumetricExtents {
+    VkExtent3D froxelGrid;
+    VkExtent3D viewFroxelGrid;  // Zero unless view-space froxels are on
+    VkExtent3D integratedGrid;  // Zero unless pre-integrated or view-space
+    VkExtent2D raymarchExtent;
+};
+
+VolumetricExtents volumetricExtents(const VolumetricConfig& config, const VkExtent2D& swapchainExtent) {
+    VolumetricExtents extents{};
+    // Whole bricks only: texel = world cell mod grid, so texel bricks then
+    // line up with world bricks and froxelRangeImage can be kept per brick
+    auto brickAligned = [](int cells) {
+        return static_cast<uint32_t>((std::max(cells, 1) + kFroxelBrickSize - 1) / kFroxelBrickSize * kFroxelBrickSize);
+    };
+    extents.froxelGrid = {brickAligned(config.froxelGridX), brickAligned(config.froxelGridY), brickAligned(config.froxelGridZ)};
+    if (config.viewSpaceFroxels) {
+        // The view-space volume replaces the world one, a single brick keeps its bindings valid
+        extents.froxelGrid = {kFroxelBrickSize, kFroxelBrickSize, kFroxelBrickSize};
+        extents.viewFroxelGrid = { static_cast<uint32_t>(std::max(1, config.viewFroxelGridX)),
+                                   static_cast<uint32_t>(std::max(1, config.viewFroxelGridY)),
+                                   static_cast<uint32_t>(std::max(2, config.viewFroxelSlices)) };
+        // Integrated column by column, slice for slice
+        extents.integratedGrid = extents.viewFroxelGrid;
+    } else if (config.preintegratedScattering) {
+        extents.integratedGrid = { static_cast<uint32_t>(std::max(1, config.integrationGridX)),
+                                   static_cast<uint32_t>(std::max(1, config.integrationGridY)),
+                                   static_cast<uint32_t>(std::max(2, config.integrationSlices)) };
+    }
+    // Scattering is marched at a fraction of the swapchain resolution and
+    // upsampled depth-aware in postprocess.frag
+    const uint32_t resolutionDivisor = static_cast<uint32_t>(std::clamp(config.scatteringResolutionDivisor, 1, 4));
+    extents.raymarchExtent.width = std::max(1u, swapchainExtent.width / resolutionDivisor);
+    extents.raymarchExtent.height = std::max(1u, swapchainExtent.height / resolutionDivisor);
+    return extents;
+}
+
+bool sameExtent(const VkExtent3D& a, const VkExtent3D& b) {
+    return a.width == b.width && a.height == b.height && a.depth == b.depth;
+}
+
+uint32_t packHalf2(float low, float high) {
+    return static_cast<uint32_t>(glm::packHalf1x16(low)) | (static_cast<uint32_t>(glm::packHalf1x16(high)) << 16);
+}
+
+// Offset of a cell from the density cell base. The base is never more than
+// kDensityCellBaseSnap cells from the selection box, so only bounds that
+// reach far outside it are clamped, and those cells are never injected.
+int16_t packCellCoord(float cell, int base) {
+    return static_cast<int16_t>(glm::clamp(cell - static_cast<float>(base), -32768.0f, 32767.0f));
+}
 
 struct VolumetricPushConstants {
     glm::ivec4 dims{0};      // xyz = dimensions, w = history enabled flag (0/1)
-    glm::vec4 scalars0{0.0f}; // x = time, y = step length, z = sigma_t, w = albedo
+    glm::vec4 scalars0{0.0f}; // x = time, y = step size multiplier, z = sigma_t, w = albedo
     glm::vec4 scalars1{0.0f}; // x = history alpha, y = history valid, z = light count, w = density count
-    glm::vec4 scalars2{0.0f}; // light g (x), clamp min (y), clamp max (z), reserved
-    glm::vec4 scalars3{0.0f}; // falloff multiplier (x), reserved
+    glm::vec4 scalars2{0.0f}; // light g (x), step jitter (y), view-space froxels flag 0/1 (z), raymarch steps (w)
+    glm::vec4 scalars3{0.0f}; // falloff multiplier (x), first integration slice end (y), integration distance (z), skip tolerance (w)
+    glm::ivec4 brickBase{0};  // xyz = world brick holding the grid's min corner, w = bricks injected
+    glm::ivec4 brickDims{0};  // xyz = brick mask dimensions (brickSlots)
 };
 
 struct VolumetricConstantsGPU {
@@ -87,8 +156,115 @@ struct VolumetricConstantsGPU {
     glm::vec4 jitterFrameTime; // x = frame index, y = time, z/w reserved
     glm::vec4 skyLightDir;    // xyz normalized direction (points TO sun), w = intensity
     glm::vec4 skyLightColor;  // xyz color, w = scattering boost
+    glm::ivec4 froxelOrigin;  // xyz = world cell at the grid's min corner
+    glm::ivec4 froxelWrap;    // xyz = texel holding that cell (froxelOrigin mod grid size)
 };
 
+int positiveMod(int value, int divisor) {
+    int r = value % divisor;
+    return r < 0 ? r + divisor : r;
+}
+
+glm::ivec3 brickOfCell(const glm::ivec3& cell) {
+    return (cell - glm::ivec3(positiveMod(cell.x, kFroxelBrickSize),
+                              positiveMod(cell.y, kFroxelBrickSize),
+                              positiveMod(cell.z, kFroxelBrickSize))) / kFroxelBrickSize;
+}
+
+size_t brickSlotIndex(const glm::ivec3& brick, const glm::ivec3& slots) {
+    return static_cast<size_t>(positiveMod(brick.x, slots.x)) +
+           static_cast<size_t>(slots.x) * (static_cast<size_t>(positiveMod(brick.y, slots.y)) +
+                                           static_cast<size_t>(slots.y) * static_cast<size_t>(positiveMod(brick.z, slots.z)));
+}
+
+// Calls onChanged for every record that is in only one of the two sets, then
+// replaces previous with current. Records are compared bytewise, so the order
+// current was built in does not matter.
+template <typename Record, typename Fn>
+void forEachChangedRecord(std::vector<Record>& previous, const std::vector<Record>& current, Fn&& onChanged) {
+    auto less = [](const Record& a, const Record& b) { return std::memcmp(&a, &b, sizeof(Record)) < 0; };
+    std::vector<Record> sorted(current);
+    std::sort(sorted.begin(), sorted.end(), less);
+
+    size_t i = 0;
+    size_t j = 0;
+    while (i < previous.size() || j < sorted.size()) {
+        if (j == sorted.size() || (i < previous.size() && less(previous[i], sorted[j]))) {
+            onChanged(previous[i++]);
+        } else if (i == previous.size() || less(sorted[j], previous[i])) {
+            onChanged(sorted[j++]);
+        } else {
+            ++i;
+            ++j;
+        }
+    }
+    previous.swap(sorted);
+}
+
+// Writes the records of current that differ from what the buffer last
+// received, as contiguous runs, and remembers current as the buffer's
+// contents. Records past current.size() are left stale: the shaders only
+// read up to the count in the push constants.
+template <typename Record>
+void uploadChangedRecords(void* mapped, std::vector<Record>& uploaded, const std::vector<Record>& current) {
+    auto same = [&](size_t i) {
+        return i < uploaded.size() && std::memcmp(&uploaded[i], &current[i], sizeof(Record)) == 0;
+    };
+    size_t first = 0;
+    while (first < current.size()) {
+        if (same(first)) {
+            ++first;
+            continue;
+        }
+        size_t last = first + 1;
+        while (last < current.size() && !same(last)) {
+            ++last;
+        }
+        std::memcpy(static_cast<char*>(mapped) + first * sizeof(Record), &current[first], (last - first) * sizeof(Record));
+        first = last;
+    }
+    uploaded.assign(current.begin(), current.end());
+}
+
+// Calls fn for every loaded chunk whose square overlaps the world XZ
+// rectangle. What a chunk generates can overhang its square, so one extra
+// ring of chunks is visited.
+template <typename Fn>
+void forEachChunkInRect(const CityGenerator& gen, const glm::vec2& rectMin, const glm::vec2& rectMax, Fn&& fn) {
+    const float chunkSize = gen.getChunkSize();
+    const int minX = static_cast<int>(std::floor(rectMin.x / chunkSize)) - 1;
+    const int maxX = static_cast<int>(std::floor(rectMax.x / chunkSize)) + 1;
+    const int minZ = static_cast<int>(std::floor(rectMin.y / chunkSize)) - 1;
+    const int maxZ = static_cast<int>(std::floor(rectMax.y / chunkSize)) + 1;
+
+    const auto& chunks = gen.getChunks();
+    const size_t rangeChunks = static_cast<size_t>(maxX - minX + 1) * static_cast<size_t>(maxZ - minZ + 1);
+    if (rangeChunks >= chunks.size()) {
+        // Fewer loaded chunks than squares in range: filter the map instead
+        for (const auto& entry : chunks) {
+            const int x = entry.first.first;
+            const int z = entry.first.second;
+            if (x >= minX && x <= maxX && z >= minZ && z <= maxZ) {
+                fn(entry.second);
+            }
+        }
+        return;
+    }
+    for (int x = minX; x <= maxX; ++x) {
+        for (int z = minZ; z <= maxZ; ++z) {
+            if (const CityChunk* chunk = gen.findChunk(x, z)) {
+                fn(*chunk);
+            }
+        }
+    }
+}
+
+template <typename Fn>
+void forEachChunkNear(const CityGenerator& gen, const glm::vec3& center, float radius, Fn&& fn) {
+    const glm::vec2 centerXZ(center.x, center.z);
+    forEachChunkInRect(gen, centerXZ - glm::vec2(radius), centerXZ + glm::vec2(radius), std::forward<Fn>(fn));
+}
+
 static std::vector<char> readShaderFile(const std::string& path) {
     FILE* f = fopen(path.c_str(), "rb");
     if (!f) {
@@ -117,13 +293,13 @@ bool Renderer::createVolumetricResources() {
 
     auto& v = volumetrics_;
     v.imagesInitialized = false;
-    v.froxelGrid = {static_cast<uint32_t>(g_volumetricConfig.froxelGridX), 
-                    static_cast<uint32_t>(g_volumetricConfig.froxelGridY), 
-                    static_cast<uint32_t>(g_volumetricConfig.froxelGridZ)};
-    v.raymarchExtent.width = swapchainExtent_.width;
-    v.raymarchExtent.height = swapchainExtent_.height;
+    const VolumetricExtents extents = volumetricExtents(g_volumetricConfig, swapchainExtent_);
+    v.froxelGrid = extents.froxelGrid;
+    v.viewFroxelGrid = extents.viewFroxelGrid;
+    v.integratedGrid = extents.integratedGrid;
+    v.raymarchExtent = extents.raymarchExtent;
 
-    auto create3DImage = [&](VkExtent3D extent, VkFormat format, VkImage& image, VkDeviceMemory& memory, VkImageView& view) -> bool {
+    auto create3DImage = [&](VkExtent3D extent, VkFormat format, VkImage& image, GpuAllocation& memory, VkImageView& view) -> bool {
         VkImageCreateInfo info{ VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO };
         info.imageType = VK_IMAGE_TYPE_3D;
         info.extent = extent;
@@ -138,23 +314,11 @@ bool Renderer::createVolumetricResources() {
             return false;
         }
 
-        VkMemoryRequirements req{};
-        vkGetImageMemoryRequirements(device_, image, &req);
-        VkMemoryAllocateInfo alloc{ VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO };
-        alloc.allocationSize = req.size;
-        alloc.memoryTypeIndex = findMemoryType(req.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-        if (vkAllocateMemory(device_, &alloc, nullptr, &memory) != VK_SUCCESS) {
+        if (!allocator_.allocateForImage(image, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, memory)) {
             vkDestroyImage(device_, image, nullptr);
             image = VK_NULL_HANDLE;
             return false;
         }
-        if (vkBindImageMemory(device_, image, memory, 0) != VK_SUCCESS) {
-            vkDestroyImage(device_, image, nullptr);
-            vkFreeMemory(device_, memory, nullptr);
-            image = VK_NULL_HANDLE;
-            memory = VK_NULL_HANDLE;
-            return false;
-        }
 
         VkImageViewCreateInfo viewInfo{ VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO };
         viewInfo.image = image;
@@ -165,15 +329,14 @@ bool Renderer::createVolumetricResources() {
         viewInfo.subresourceRange.layerCount = 1;
         if (vkCreateImageView(device_, &viewInfo, nullptr, &view) != VK_SUCCESS) {
             vkDestroyImage(device_, image, nullptr);
-            vkFreeMemory(device_, memory, nullptr);
+            allocator_.free(memory);
             image = VK_NULL_HANDLE;
-            memory = VK_NULL_HANDLE;
             return false;
         }
         return true;
     };
 
-    auto create2DImage = [&](VkExtent2D extent, VkFormat format, VkImage& image, VkDeviceMemory& memory, VkImageView& view) -> bool {
+    auto create2DImage = [&](VkExtent2D extent, VkFormat format, VkImage& image, GpuAllocation& memory, VkImageView& view) -> bool {
         VkImageCreateInfo info{ VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO };
         info.imageType = VK_IMAGE_TYPE_2D;
         info.extent = { extent.width, extent.height, 1 };
@@ -182,29 +345,19 @@ bool Renderer::createVolumetricResources() {
         info.format = format;
         info.tiling = VK_IMAGE_TILING_OPTIMAL;
         info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-        info.usage = VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+        // Transfer: the temporal pass copies its history into scatteringImage
+        info.usage = VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT |
+                     VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
         info.samples = VK_SAMPLE_COUNT_1_BIT;
         if (vkCreateImage(device_, &info, nullptr, &image) != VK_SUCCESS) {
             return false;
         }
 
-        VkMemoryRequirements req{};
-        vkGetImageMemoryRequirements(device_, image, &req);
-        VkMemoryAllocateInfo alloc{ VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO };
-        alloc.allocationSize = req.size;
-        alloc.memoryTypeIndex = findMemoryType(req.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-        if (vkAllocateMemory(device_, &alloc, nullptr, &memory) != VK_SUCCESS) {
+        if (!allocator_.allocateForImage(image, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, memory)) {
             vkDestroyImage(device_, image, nullptr);
             image = VK_NULL_HANDLE;
             return false;
         }
-        if (vkBindImageMemory(device_, image, memory, 0) != VK_SUCCESS) {
-            vkDestroyImage(device_, image, nullptr);
-            vkFreeMemory(device_, memory, nullptr);
-            image = VK_NULL_HANDLE;
-            memory = VK_NULL_HANDLE;
-            return false;
-        }
 
         VkImageViewCreateInfo viewInfo{ VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO };
         viewInfo.image = image;
@@ -215,59 +368,131 @@ bool Renderer::createVolumetricResources() {
         viewInfo.subresourceRange.layerCount = 1;
         if (vkCreateImageView(device_, &viewInfo, nullptr, &view) != VK_SUCCESS) {
             vkDestroyImage(device_, image, nullptr);
-            vkFreeMemory(device_, memory, nullptr);
+            allocator_.free(memory);
             image = VK_NULL_HANDLE;
-            memory = VK_NULL_HANDLE;
             return false;
         }
         return true;
     };
 
-    if (!create3DImage(v.froxelGrid, kFroxelDensityFormat, v.densityImage, v.densityMemory, v.densityView)) return false;
     if (!create3DImage(v.froxelGrid, kFroxelLightFormat, v.lightImage, v.lightMemory, v.lightView)) return false;
+    const VkExtent3D rangeGrid{ v.froxelGrid.width / kFroxelBrickSize, v.froxelGrid.height / kFroxelBrickSize, v.froxelGrid.depth / kFroxelBrickSize };
+    if (!create3DImage(rangeGrid, kScatteringFormat, v.froxelRangeImage, v.froxelRangeMemory, v.froxelRangeView)) return false;
 
-    VkExtent2D scatterExtent{ std::max(1u, swapchainExtent_.width / 2), std::max(1u, swapchainExtent_.height / 2) };
+    const VkExtent2D scatterExtent = v.raymarchExtent;
     if (!create2DImage(scatterExtent, kScatteringFormat, v.scatteringImage, v.scatteringMemory, v.scatteringView)) return false;
     if (!create2DImage(scatterExtent, kTransmittanceFormat, v.transmittanceImage, v.transmittanceMemory, v.transmittanceView)) return false;
-    if (!create2DImage(scatterExtent, kScatteringFormat, v.historyImage, v.historyMemory, v.historyView)) return false;
+    for (uint32_t i = 0; i < kMaxFramesInFlight; ++i) {
+        if (!create2DImage(scatterExtent, kScatteringFormat, v.historyImages[i], v.historyMemories[i], v.historyViews[i])) return false;
+    }
     
     // Anamorphic bloom images (same resolution as scattering buffer)
     if (!create2DImage(scatterExtent, kScatteringFormat, v.anamorphicBloomImage, v.anamorphicBloomMemory, v.anamorphicBloomView)) return false;
     if (!create2DImage(scatterExtent, kScatteringFormat, v.anamorphicTempImage, v.anamorphicTempMemory, v.anamorphicTempView)) return false;
 
+    if (v.viewFroxelGrid.width > 0) {
+        if (!create3DImage(v.viewFroxelGrid, kFroxelLightFormat, v.viewFroxelImage, v.viewFroxelMemory, v.viewFroxelView)) return false;
+    }
+    if (v.integratedGrid.width > 0) {
+        if (!create3DImage(v.integratedGrid, kScatteringFormat, v.integratedImage, v.integratedMemory, v.integratedView)) return false;
+
+        VkSamplerCreateInfo samplerInfo{ VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO };
+        samplerInfo.magFilter = VK_FILTER_LINEAR;
+        samplerInfo.minFilter = VK_FILTER_LINEAR;
+        samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+        samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+        samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+        samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+        samplerInfo.maxAnisotropy = 1.0f;
+        samplerInfo.maxLod = 0.0f;
+        if (vkCreateSampler(device_, &samplerInfo, nullptr, &v.integratedSampler) != VK_SUCCESS) {
+            return false;
+        }
+    }
+
     v.historyInitialized = false;
 
-    const VkDeviceSize constantsSize = sizeof(VolumetricConstantsGPU);
-    if (!createBuffer(v.constantsBuffer, constantsSize, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, true)) {
-        return false;
+    // New images hold nothing yet. Bricks are world aligned, so an unaligned
+    // grid straddles one more of them per axis.
+    const glm::ivec3 grid(v.froxelGrid.width, v.froxelGrid.height, v.froxelGrid.depth);
+    v.brickSlots = (grid + (kFroxelBrickSize - 1)) / kFroxelBrickSize + 1;
+    const size_t brickSlotCount = static_cast<size_t>(v.brickSlots.x) * v.brickSlots.y * v.brickSlots.z;
+    v.staleBricks.assign(brickSlotCount, 1);
+    v.froxelBrickCount = 0;
+    v.froxelOriginValid = false;
+    v.froxelFullRefresh = true;
+    v.injectedLights.clear();
+    v.injectedDensities.clear();
+    v.lightSelectionValid = false;
+    v.densitySelectionValid = false;
+    volumetricAlbedoPalette_.clear();
+    for (uint32_t frame = 0; frame < kMaxFramesInFlight; ++frame) {
+        // The buffers are created zeroed below
+        v.uploadedLightsVersion[frame] = 0;
+        v.uploadedDensitiesVersion[frame] = 0;
+        v.uploadedLights[frame].clear();
+        v.uploadedDensities[frame].clear();
+        v.uploadedAlbedoPaletteSize[frame] = 0;
     }
 
+    const VkDeviceSize constantsSize = sizeof(VolumetricConstantsGPU);
     const VkDeviceSize lightBufferSize = static_cast<VkDeviceSize>(sizeof(VolumetricLightRecord) * kMaxVolumetricLights);
-    if (!createBuffer(v.lightRecordsBuffer, lightBufferSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, true)) {
-        return false;
-    }
-    if (v.lightRecordsBuffer.mapped) {
-        std::memset(v.lightRecordsBuffer.mapped, 0, static_cast<size_t>(lightBufferSize));
+    const VkDeviceSize densityBufferSize = kDensityHeaderBytes + static_cast<VkDeviceSize>(sizeof(VolumetricDensityRecord) * kMaxDensityVolumes);
+    for (uint32_t frame = 0; frame < kMaxFramesInFlight; ++frame) {
+        if (!createBuffer(v.constantsBuffers[frame], constantsSize, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, true)) {
+            return false;
+        }
+
+        if (!createBuffer(v.lightRecordsBuffers[frame], lightBufferSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, true)) {
+            return false;
+        }
+        if (v.lightRecordsBuffers[frame].mapped) {
+            std::memset(v.lightRecordsBuffers[frame].mapped, 0, static_cast<size_t>(lightBufferSize));
+        }
+
+        if (!createBuffer(v.densityVolumesBuffers[frame], densityBufferSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, true)) {
+            return false;
+        }
+        if (v.densityVolumesBuffers[frame].mapped) {
+            std::memset(v.densityVolumesBuffers[frame].mapped, 0, static_cast<size_t>(densityBufferSize));
+        }
+
+        if (!createBuffer(v.froxelBrickBuffers[frame], sizeof(glm::ivec4) * brickSlotCount, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, true)) {
+            return false;
+        }
+        if (!createBuffer(v.froxelBrickMaskBuffers[frame], sizeof(uint32_t) * ((brickSlotCount + 31) / 32), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, true)) {
+            return false;
+        }
+        if (!createBuffer(v.clusterStatsReadbacks[frame], sizeof(uint32_t) * 2, VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, true)) {
+            return false;
+        }
+        if (v.clusterStatsReadbacks[frame].mapped) {
+            std::memset(v.clusterStatsReadbacks[frame].mapped, 0, sizeof(uint32_t) * 2);
+        }
     }
 
-    const VkDeviceSize clusterIndexSize = static_cast<VkDeviceSize>(sizeof(uint32_t) * kMaxClusterEntries);
+    // The view-space volume bins every brick every frame: room for each one's
+    // full list, so only the per-brick caps ever drop entries
+    const glm::ivec3 viewBricks = viewFroxelBricks(v.viewFroxelGrid);
+    const size_t viewBrickCount = static_cast<size_t>(viewBricks.x) * viewBricks.y * viewBricks.z;
+    const size_t clusterEntries = v.viewFroxelGrid.width > 0 ? viewBrickCount * kMaxViewClusterEntries : kMaxClusterEntries;
+    const VkDeviceSize clusterIndexSize = static_cast<VkDeviceSize>(sizeof(uint32_t) * clusterEntries);
     if (!createBuffer(v.clusterIndicesBuffer, clusterIndexSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)) {
         return false;
     }
 
-    const VkDeviceSize froxelCount = static_cast<VkDeviceSize>(v.froxelGrid.width) * v.froxelGrid.height * v.froxelGrid.depth;
-    const VkDeviceSize clusterOffsetSize = static_cast<VkDeviceSize>(sizeof(uint32_t) * (froxelCount + 1));
-    if (!createBuffer(v.clusterOffsetsBuffer, clusterOffsetSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)) {
+    // Allocation and dropped entry counters, then an (offset, count) pair per
+    // injected brick, or per brick of the view-space volume
+    const VkDeviceSize clusterOffsetSize = static_cast<VkDeviceSize>(sizeof(uint32_t) * 2 * (std::max(brickSlotCount, viewBrickCount) + 1));
+    if (!createBuffer(v.clusterOffsetsBuffer, clusterOffsetSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)) {
         return false;
     }
 
-    const VkDeviceSize densityBufferSize = static_cast<VkDeviceSize>(sizeof(VolumetricDensityRecord) * kMaxDensityVolumes);
-    if (!createBuffer(v.densityVolumesBuffer, densityBufferSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, true)) {
+    // Fixed-point sigma per froxel, summed by the density scatter pass
+    const VkDeviceSize densityAccumSize = static_cast<VkDeviceSize>(sizeof(uint32_t)) * v.froxelGrid.width * v.froxelGrid.height * v.froxelGrid.depth;
+    if (!createBuffer(v.densityAccumBuffer, densityAccumSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)) {
         return false;
     }
-    if (v.densityVolumesBuffer.mapped) {
-        std::memset(v.densityVolumesBuffer.mapped, 0, static_cast<size_t>(densityBufferSize));
-    }
 
     if (!createVolumetricDescriptorSets()) {
         return false;
@@ -280,10 +505,7 @@ bool Renderer::createVolumetricResources() {
     volumetricFrameIndex_ = 0;
     volumetricLightCount_ = 0;
     volumetricDensityCount_ = 0;
-
-    if (postProcessingDescriptorSet_ != VK_NULL_HANDLE) {
-        updatePostProcessingDescriptors();
-    }
+    volumetricClusterDropped_ = 0;
     return true;
 }
 
@@ -298,7 +520,12 @@ void Renderer::destroyVolumetricResources() {
     if (v.clusterPipeline) { vkDestroyPipeline(device_, v.clusterPipeline, nullptr); v.clusterPipeline = VK_NULL_HANDLE; }
     if (v.densityPipeline) { vkDestroyPipeline(device_, v.densityPipeline, nullptr); v.densityPipeline = VK_NULL_HANDLE; }
     if (v.lightPipeline) { vkDestroyPipeline(device_, v.lightPipeline, nullptr); v.lightPipeline = VK_NULL_HANDLE; }
+    if (v.rangePipeline) { vkDestroyPipeline(device_, v.rangePipeline, nullptr); v.rangePipeline = VK_NULL_HANDLE; }
     if (v.raymarchPipeline) { vkDestroyPipeline(device_, v.raymarchPipeline, nullptr); v.raymarchPipeline = VK_NULL_HANDLE; }
+    if (v.integratePipeline) { vkDestroyPipeline(device_, v.integratePipeline, nullptr); v.integratePipeline = VK_NULL_HANDLE; }
+    if (v.scatterLookupPipeline) { vkDestroyPipeline(device_, v.scatterLookupPipeline, nullptr); v.scatterLookupPipeline = VK_NULL_HANDLE; }
+    if (v.viewClusterPipeline) { vkDestroyPipeline(device_, v.viewClusterPipeline, nullptr); v.viewClusterPipeline = VK_NULL_HANDLE; }
+    if (v.viewInjectPipeline) { vkDestroyPipeline(device_, v.viewInjectPipeline, nullptr); v.viewInjectPipeline = VK_NULL_HANDLE; }
     if (v.temporalPipeline) { vkDestroyPipeline(device_, v.temporalPipeline, nullptr); v.temporalPipeline = VK_NULL_HANDLE; }
     if (v.anamorphicBloomPipeline) { vkDestroyPipeline(device_, v.anamorphicBloomPipeline, nullptr); v.anamorphicBloomPipeline = VK_NULL_HANDLE; }
     if (v.pipelineLayout) { vkDestroyPipelineLayout(device_, v.pipelineLayout, nullptr); v.pipelineLayout = VK_NULL_HANDLE; }
@@ -314,47 +541,149 @@ void Renderer::destroyVolumetricResources() {
     }
     if (v.anamorphicBloomDescriptorLayout) { vkDestroyDescriptorSetLayout(device_, v.anamorphicBloomDescriptorLayout, nullptr); v.anamorphicBloomDescriptorLayout = VK_NULL_HANDLE; }
 
-    destroyBuffer(v.constantsBuffer);
+    for (uint32_t frame = 0; frame < kMaxFramesInFlight; ++frame) {
+        destroyBuffer(v.constantsBuffers[frame]);
+        destroyBuffer(v.lightRecordsBuffers[frame]);
+        destroyBuffer(v.densityVolumesBuffers[frame]);
+        destroyBuffer(v.froxelBrickBuffers[frame]);
+        destroyBuffer(v.froxelBrickMaskBuffers[frame]);
+        destroyBuffer(v.clusterStatsReadbacks[frame]);
+    }
     destroyBuffer(v.clusterOffsetsBuffer);
     destroyBuffer(v.clusterIndicesBuffer);
-    destroyBuffer(v.lightRecordsBuffer);
-    destroyBuffer(v.densityVolumesBuffer);
+    destroyBuffer(v.densityAccumBuffer);
 
     if (v.transmittanceView) { vkDestroyImageView(device_, v.transmittanceView, nullptr); v.transmittanceView = VK_NULL_HANDLE; }
     if (v.transmittanceImage) { vkDestroyImage(device_, v.transmittanceImage, nullptr); v.transmittanceImage = VK_NULL_HANDLE; }
-    if (v.transmittanceMemory) { vkFreeMemory(device_, v.transmittanceMemory, nullptr); v.transmittanceMemory = VK_NULL_HANDLE; }
+    allocator_.free(v.transmittanceMemory);
+
+    for (uint32_t i = 0; i < kMaxFramesInFlight; ++i) {
+        if (v.historyViews[i]) { vkDestroyImageView(device_, v.historyViews[i], nullptr); v.historyViews[i] = VK_NULL_HANDLE; }
+        if (v.historyImages[i]) { vkDestroyImage(device_, v.historyImages[i], nullptr); v.historyImages[i] = VK_NULL_HANDLE; }
+        allocator_.free(v.historyMemories[i]);
+    }
 
-    if (v.historyView) { vkDestroyImageView(device_, v.historyView, nullptr); v.historyView = VK_NULL_HANDLE; }
-    if (v.historyImage) { vkDestroyImage(device_, v.historyImage, nullptr); v.historyImage = VK_NULL_HANDLE; }
-    if (v.historyMemory) { vkFreeMemory(device_, v.historyMemory, nullptr); v.historyMemory = VK_NULL_HANDLE; }
+    if (v.integratedView) { vkDestroyImageView(device_, v.integratedView, nullptr); v.integratedView = VK_NULL_HANDLE; }
+    if (v.integratedImage) { vkDestroyImage(device_, v.integratedImage, nullptr); v.integratedImage = VK_NULL_HANDLE; }
+    allocator_.free(v.integratedMemory);
+    if (v.integratedSampler) { vkDestroySampler(device_, v.integratedSampler, nullptr); v.integratedSampler = VK_NULL_HANDLE; }
+
+    if (v.viewFroxelView) { vkDestroyImageView(device_, v.viewFroxelView, nullptr); v.viewFroxelView = VK_NULL_HANDLE; }
+    if (v.viewFroxelImage) { vkDestroyImage(device_, v.viewFroxelImage, nullptr); v.viewFroxelImage = VK_NULL_HANDLE; }
+    allocator_.free(v.viewFroxelMemory);
 
     if (v.scatteringView) { vkDestroyImageView(device_, v.scatteringView, nullptr); v.scatteringView = VK_NULL_HANDLE; }
     if (v.scatteringImage) { vkDestroyImage(device_, v.scatteringImage, nullptr); v.scatteringImage = VK_NULL_HANDLE; }
-    if (v.scatteringMemory) { vkFreeMemory(device_, v.scatteringMemory, nullptr); v.scatteringMemory = VK_NULL_HANDLE; }
+    allocator_.free(v.scatteringMemory);
 
     if (v.lightView) { vkDestroyImageView(device_, v.lightView, nullptr); v.lightView = VK_NULL_HANDLE; }
     if (v.lightImage) { vkDestroyImage(device_, v.lightImage, nullptr); v.lightImage = VK_NULL_HANDLE; }
-    if (v.lightMemory) { vkFreeMemory(device_, v.lightMemory, nullptr); v.lightMemory = VK_NULL_HANDLE; }
+    allocator_.free(v.lightMemory);
 
-    if (v.densityView) { vkDestroyImageView(device_, v.densityView, nullptr); v.densityView = VK_NULL_HANDLE; }
-    if (v.densityImage) { vkDestroyImage(device_, v.densityImage, nullptr); v.densityImage = VK_NULL_HANDLE; }
-    if (v.densityMemory) { vkFreeMemory(device_, v.densityMemory, nullptr); v.densityMemory = VK_NULL_HANDLE; }
+    if (v.froxelRangeView) { vkDestroyImageView(device_, v.froxelRangeView, nullptr); v.froxelRangeView = VK_NULL_HANDLE; }
+    if (v.froxelRangeImage) { vkDestroyImage(device_, v.froxelRangeImage, nullptr); v.froxelRangeImage = VK_NULL_HANDLE; }
+    allocator_.free(v.froxelRangeMemory);
 
     if (v.anamorphicBloomView) { vkDestroyImageView(device_, v.anamorphicBloomView, nullptr); v.anamorphicBloomView = VK_NULL_HANDLE; }
     if (v.anamorphicBloomImage) { vkDestroyImage(device_, v.anamorphicBloomImage, nullptr); v.anamorphicBloomImage = VK_NULL_HANDLE; }
-    if (v.anamorphicBloomMemory) { vkFreeMemory(device_, v.anamorphicBloomMemory, nullptr); v.anamorphicBloomMemory = VK_NULL_HANDLE; }
+    allocator_.free(v.anamorphicBloomMemory);
 
     if (v.anamorphicTempView) { vkDestroyImageView(device_, v.anamorphicTempView, nullptr); v.anamorphicTempView = VK_NULL_HANDLE; }
     if (v.anamorphicTempImage) { vkDestroyImage(device_, v.anamorphicTempImage, nullptr); v.anamorphicTempImage = VK_NULL_HANDLE; }
-    if (v.anamorphicTempMemory) { vkFreeMemory(device_, v.anamorphicTempMemory, nullptr); v.anamorphicTempMemory = VK_NULL_HANDLE; }
+    allocator_.free(v.anamorphicTempMemory);
 
     volumetricsReady_ = false;
     v.imagesInitialized = false;
     v.historyInitialized = false;
+}
+
+// Same objects as destroyVolumetricResources, handed to the retire queue so
+// the frames still in flight can finish with them
+void Renderer::retireVolumetricResources() {
+    auto& v = volumetrics_;
+
+    retirePipeline(v.clusterPipeline);
+    retirePipeline(v.densityPipeline);
+    retirePipeline(v.lightPipeline);
+    retirePipeline(v.rangePipeline);
+    retirePipeline(v.raymarchPipeline);
+    retirePipeline(v.integratePipeline);
+    retirePipeline(v.scatterLookupPipeline);
+    retirePipeline(v.viewClusterPipeline);
+    retirePipeline(v.viewInjectPipeline);
+    retirePipeline(v.temporalPipeline);
+    retirePipeline(v.anamorphicBloomPipeline);
+    retirePipelineLayout(v.pipelineLayout);
+    retirePipelineLayout(v.anamorphicBloomPipelineLayout);
+
+    retireDescriptorPool(v.descriptorPool);
+    retireDescriptorPool(v.anamorphicBloomDescriptorPool);
+    for (auto& layout : v.descriptorSetLayouts) {
+        retireDescriptorSetLayout(layout);
+    }
+    retireDescriptorSetLayout(v.anamorphicBloomDescriptorLayout);
+
+    auto retire = [&](BufferWithMemory& buffer) {
+        buffer.mapped = nullptr;
+        retireBuffer(buffer.buffer, buffer.memory);
+    };
+    for (uint32_t frame = 0; frame < kMaxFramesInFlight; ++frame) {
+        retire(v.constantsBuffers[frame]);
+        retire(v.lightRecordsBuffers[frame]);
+        retire(v.densityVolumesBuffers[frame]);
+        retire(v.froxelBrickBuffers[frame]);
+        retire(v.froxelBrickMaskBuffers[frame]);
+        retire(v.clusterStatsReadbacks[frame]);
+    }
+    retire(v.clusterOffsetsBuffer);
+    retire(v.clusterIndicesBuffer);
+    retire(v.densityAccumBuffer);
 
-    if (postProcessingDescriptorSet_ != VK_NULL_HANDLE) {
-        updatePostProcessingDescriptors();
+    retireImage(v.transmittanceImage, v.transmittanceView, v.transmittanceMemory);
+    for (uint32_t i = 0; i < kMaxFramesInFlight; ++i) {
+        retireImage(v.historyImages[i], v.historyViews[i], v.historyMemories[i]);
     }
+    retireImage(v.integratedImage, v.integratedView, v.integratedMemory);
+    retireSampler(v.integratedSampler);
+    retireImage(v.viewFroxelImage, v.viewFroxelView, v.viewFroxelMemory);
+    retireImage(v.scatteringImage, v.scatteringView, v.scatteringMemory);
+    retireImage(v.lightImage, v.lightView, v.lightMemory);
+    retireImage(v.froxelRangeImage, v.froxelRangeView, v.froxelRangeMemory);
+    retireImage(v.anamorphicBloomImage, v.anamorphicBloomView, v.anamorphicBloomMemory);
+    retireImage(v.anamorphicTempImage, v.anamorphicTempView, v.anamorphicTempMemory);
+
+    volumetricsReady_ = false;
+    v.imagesInitialized = false;
+    v.historyInitialized = false;
+}
+
+// Called after a config hot reload. Settings that size the volumetric images
+// only take effect on creation, so when the reloaded ones ask for other sizes
+// everything is rebuilt in place. The old objects are retired rather than
+// destroyed and each frame's post-processing set is repointed once drawFrame
+// has waited for its slot, so no device idle is needed.
+void Renderer::reallocateVolumetricResources() {
+    if (!volumetricsEnabled_ || !device_) {
+        return;
+    }
+    auto& v = volumetrics_;
+    const VolumetricExtents extents = volumetricExtents(g_volumetricConfig, swapchainExtent_);
+    if (sameExtent(extents.froxelGrid, v.froxelGrid) && sameExtent(extents.viewFroxelGrid, v.viewFroxelGrid) &&
+        sameExtent(extents.integratedGrid, v.integratedGrid) &&
+        extents.raymarchExtent.width == v.raymarchExtent.width && extents.raymarchExtent.height == v.raymarchExtent.height) {
+        return;
+    }
+
+    printf("Volumetric grid %ux%ux%u -> %ux%ux%u, reallocating\n",
+           v.froxelGrid.width, v.froxelGrid.height, v.froxelGrid.depth,
+           extents.froxelGrid.width, extents.froxelGrid.height, extents.froxelGrid.depth);
+    retireVolumetricResources();
+    if (!createVolumetricResources()) {
+        // Whatever was created goes too, volumetrics stay off until a reload changes the sizes again
+        printf("Warning: Failed to reallocate volumetric resources\n");
+        retireVolumetricResources();
+    }
+    postProcessingDescriptorsStale_.fill(true);
 }
 
 bool Renderer::createVolumetricDescriptorSets() {
@@ -383,8 +712,13 @@ bool Renderer::createVolumetricDescriptorSets() {
         return false;
     }
 
-    std::array<VkDescriptorSetLayoutBinding, 6> imageBindings{};
-    for (uint32_t i = 0; i < 5; ++i) {
+    // Binding 0 samples the froxel volume that binding 1 writes
+    std::array<VkDescriptorSetLayoutBinding, 11> imageBindings{};
+    imageBindings[0].binding = 0;
+    imageBindings[0].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    imageBindings[0].descriptorCount = 1;
+    imageBindings[0].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    for (uint32_t i = 1; i < 5; ++i) {
         imageBindings[i].binding = i;
         imageBindings[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
         imageBindings[i].descriptorCount = 1;
@@ -394,6 +728,30 @@ bool Renderer::createVolumetricDescriptorSets() {
     imageBindings[5].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
     imageBindings[5].descriptorCount = 1;
     imageBindings[5].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    // Pre-integrated volume: written at 6, sampled at 7
+    imageBindings[6].binding = 6;
+    imageBindings[6].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+    imageBindings[6].descriptorCount = 1;
+    imageBindings[6].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    imageBindings[7].binding = 7;
+    imageBindings[7].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    imageBindings[7].descriptorCount = 1;
+    imageBindings[7].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    // Per-brick min/max of binding 1
+    imageBindings[8].binding = 8;
+    imageBindings[8].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+    imageBindings[8].descriptorCount = 1;
+    imageBindings[8].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    // Temporal history: written at 4, the previous frame's sampled at 9
+    imageBindings[9].binding = 9;
+    imageBindings[9].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    imageBindings[9].descriptorCount = 1;
+    imageBindings[9].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    // View-space froxel volume
+    imageBindings[10].binding = 10;
+    imageBindings[10].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+    imageBindings[10].descriptorCount = 1;
+    imageBindings[10].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
 
     VkDescriptorSetLayoutCreateInfo imageLayoutInfo{ VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO };
     imageLayoutInfo.bindingCount = static_cast<uint32_t>(imageBindings.size());
@@ -402,7 +760,7 @@ bool Renderer::createVolumetricDescriptorSets() {
         return false;
     }
 
-    VkDescriptorSetLayoutBinding bufferBindings[4]{};
+    VkDescriptorSetLayoutBinding bufferBindings[7]{};
     bufferBindings[0].binding = 0;
     bufferBindings[0].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
     bufferBindings[0].descriptorCount = 1;
@@ -423,51 +781,54 @@ bool Renderer::createVolumetricDescriptorSets() {
     bufferBindings[3].descriptorCount = 1;
     bufferBindings[3].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
 
+    bufferBindings[4].binding = 4;
+    bufferBindings[4].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    bufferBindings[4].descriptorCount = 1;
+    bufferBindings[4].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+
+    bufferBindings[5].binding = 5;
+    bufferBindings[5].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    bufferBindings[5].descriptorCount = 1;
+    bufferBindings[5].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+
+    bufferBindings[6].binding = 6;
+    bufferBindings[6].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    bufferBindings[6].descriptorCount = 1;
+    bufferBindings[6].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+
     VkDescriptorSetLayoutCreateInfo bufferLayoutInfo{ VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO };
-    bufferLayoutInfo.bindingCount = 4;
+    bufferLayoutInfo.bindingCount = 7;
     bufferLayoutInfo.pBindings = bufferBindings;
     if (vkCreateDescriptorSetLayout(device_, &bufferLayoutInfo, nullptr, &v.descriptorSetLayouts[2]) != VK_SUCCESS) {
         return false;
     }
 
+    // One full set triple per frame in flight
     VkDescriptorPoolSize poolSizes[4]{};
-    poolSizes[0].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER; poolSizes[0].descriptorCount = 1;
-    poolSizes[1].type = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE; poolSizes[1].descriptorCount = 5;
-    poolSizes[2].type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER; poolSizes[2].descriptorCount = 4;
-    poolSizes[3].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER; poolSizes[3].descriptorCount = 1;
+    poolSizes[0].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER; poolSizes[0].descriptorCount = 1 * kMaxFramesInFlight;
+    poolSizes[1].type = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE; poolSizes[1].descriptorCount = 7 * kMaxFramesInFlight;
+    poolSizes[2].type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER; poolSizes[2].descriptorCount = 7 * kMaxFramesInFlight;
+    poolSizes[3].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER; poolSizes[3].descriptorCount = 4 * kMaxFramesInFlight;
 
     VkDescriptorPoolCreateInfo poolInfo{ VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO };
     poolInfo.poolSizeCount = 4;
     poolInfo.pPoolSizes = poolSizes;
-    poolInfo.maxSets = 3;
+    poolInfo.maxSets = 3 * kMaxFramesInFlight;
     if (vkCreateDescriptorPool(device_, &poolInfo, nullptr, &v.descriptorPool) != VK_SUCCESS) {
         return false;
     }
 
     VkDescriptorSetLayout layouts[3] = { v.descriptorSetLayouts[0], v.descriptorSetLayouts[1], v.descriptorSetLayouts[2] };
-    VkDescriptorSetAllocateInfo allocInfo{ VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO };
-    allocInfo.descriptorPool = v.descriptorPool;
-    allocInfo.descriptorSetCount = 3;
-    allocInfo.pSetLayouts = layouts;
-    if (vkAllocateDescriptorSets(device_, &allocInfo, v.descriptorSets) != VK_SUCCESS) {
-        return false;
+    for (uint32_t frame = 0; frame < kMaxFramesInFlight; ++frame) {
+        VkDescriptorSetAllocateInfo allocInfo{ VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO };
+        allocInfo.descriptorPool = v.descriptorPool;
+        allocInfo.descriptorSetCount = 3;
+        allocInfo.pSetLayouts = layouts;
+        if (vkAllocateDescriptorSets(device_, &allocInfo, v.descriptorSets[frame]) != VK_SUCCESS) {
+            return false;
+        }
     }
 
-    VkDescriptorBufferInfo constantsInfo{};
-    constantsInfo.buffer = v.constantsBuffer.buffer;
-    constantsInfo.offset = 0;
-    constantsInfo.range = sizeof(VolumetricConstantsGPU);
-
-    VkWriteDescriptorSet uniformWrite{ VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET };
-    uniformWrite.dstSet = v.descriptorSets[0];
-    uniformWrite.dstBinding = 0;
-    uniformWrite.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-    uniformWrite.descriptorCount = 1;
-    uniformWrite.pBufferInfo = &constantsInfo;
-
-    VkDescriptorImageInfo densityInfo{};
-    densityInfo.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
-    densityInfo.imageView = v.densityView;
     VkDescriptorImageInfo lightInfo{};
     lightInfo.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
     lightInfo.imageView = v.lightView;
@@ -477,9 +838,6 @@ bool Renderer::createVolumetricDescriptorSets() {
     VkDescriptorImageInfo transmittanceInfo{};
     transmittanceInfo.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
     transmittanceInfo.imageView = v.transmittanceView;
-    VkDescriptorImageInfo historyInfo{};
-    historyInfo.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
-    historyInfo.imageView = v.historyView ? v.historyView : v.scatteringView;
 
     if (textureSampler_ == VK_NULL_HANDLE) {
         if (!createTextureSampler()) {
@@ -487,86 +845,203 @@ bool Renderer::createVolumetricDescriptorSets() {
         }
     }
 
+    // Linear + repeat: the hardware filter follows the volume's toroidal wrap
+    VkDescriptorImageInfo froxelVolumeInfo{};
+    froxelVolumeInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    froxelVolumeInfo.imageView = v.lightView;
+    froxelVolumeInfo.sampler = textureSampler_;
+
+    // Outside pre-integrated mode the bindings just need something valid
+    VkDescriptorImageInfo integratedStorageInfo{};
+    integratedStorageInfo.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+    integratedStorageInfo.imageView = v.integratedView ? v.integratedView : v.lightView;
+    VkDescriptorImageInfo integratedSampledInfo{};
+    integratedSampledInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    integratedSampledInfo.imageView = v.integratedView ? v.integratedView : v.lightView;
+    integratedSampledInfo.sampler = v.integratedSampler ? v.integratedSampler : textureSampler_;
+
+    VkDescriptorImageInfo viewFroxelInfo{};
+    viewFroxelInfo.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+    viewFroxelInfo.imageView = v.viewFroxelView ? v.viewFroxelView : v.lightView;
+
+    VkDescriptorImageInfo froxelRangeInfo{};
+    froxelRangeInfo.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+    froxelRangeInfo.imageView = v.froxelRangeView;
+
     VkDescriptorImageInfo depthInfo{};
     depthInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
     depthInfo.imageView = depthImageView_ ? depthImageView_ : hdrColorView_;
     depthInfo.sampler = textureSampler_;
 
-    VkWriteDescriptorSet imageWrites[5]{};
-    for (uint32_t i = 0; i < 5; ++i) {
-        imageWrites[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-        imageWrites[i].dstSet = v.descriptorSets[1];
-        imageWrites[i].dstBinding = i;
-        imageWrites[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
-        imageWrites[i].descriptorCount = 1;
-    }
-    imageWrites[0].pImageInfo = &densityInfo;
-    imageWrites[1].pImageInfo = &lightInfo;
-    imageWrites[2].pImageInfo = &scatteringInfo;
-    imageWrites[3].pImageInfo = &transmittanceInfo;
-    imageWrites[4].pImageInfo = &historyInfo;
-
-    VkWriteDescriptorSet depthWrite{ VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET };
-    depthWrite.dstSet = v.descriptorSets[1];
-    depthWrite.dstBinding = 5;
-    depthWrite.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-    depthWrite.descriptorCount = 1;
-    depthWrite.pImageInfo = &depthInfo;
-
-    VkDescriptorBufferInfo lightBufferInfo{};
-    lightBufferInfo.buffer = v.lightRecordsBuffer.buffer;
-    lightBufferInfo.offset = 0;
-    lightBufferInfo.range = VK_WHOLE_SIZE;
-    VkDescriptorBufferInfo clusterOffsetInfo{};
-    clusterOffsetInfo.buffer = v.clusterOffsetsBuffer.buffer;
-    clusterOffsetInfo.offset = 0;
-    clusterOffsetInfo.range = VK_WHOLE_SIZE;
-    VkDescriptorBufferInfo clusterIndexInfo{};
-    clusterIndexInfo.buffer = v.clusterIndicesBuffer.buffer;
-    clusterIndexInfo.offset = 0;
-    clusterIndexInfo.range = VK_WHOLE_SIZE;
-    VkDescriptorBufferInfo densityBufferInfo{};
-    densityBufferInfo.buffer = v.densityVolumesBuffer.buffer;
-    densityBufferInfo.offset = 0;
-    densityBufferInfo.range = VK_WHOLE_SIZE;
-
-    VkWriteDescriptorSet bufferWrites[4]{};
-    bufferWrites[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-    bufferWrites[0].dstSet = v.descriptorSets[2];
-    bufferWrites[0].dstBinding = 0;
-    bufferWrites[0].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
-    bufferWrites[0].descriptorCount = 1;
-    bufferWrites[0].pBufferInfo = &lightBufferInfo;
-
-    bufferWrites[1].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-    bufferWrites[1].dstSet = v.descriptorSets[2];
-    bufferWrites[1].dstBinding = 1;
-    bufferWrites[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
-    bufferWrites[1].descriptorCount = 1;
-    bufferWrites[1].pBufferInfo = &clusterOffsetInfo;
-
-    bufferWrites[2].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-    bufferWrites[2].dstSet = v.descriptorSets[2];
-    bufferWrites[2].dstBinding = 2;
-    bufferWrites[2].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
-    bufferWrites[2].descriptorCount = 1;
-    bufferWrites[2].pBufferInfo = &clusterIndexInfo;
-
-    bufferWrites[3].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-    bufferWrites[3].dstSet = v.descriptorSets[2];
-    bufferWrites[3].dstBinding = 3;
-    bufferWrites[3].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
-    bufferWrites[3].descriptorCount = 1;
-    bufferWrites[3].pBufferInfo = &densityBufferInfo;
-
-    VkWriteDescriptorSet writes[10];
-    uint32_t writeCount = 0;
-    writes[writeCount++] = uniformWrite;
-    for (uint32_t i = 0; i < 5; ++i) writes[writeCount++] = imageWrites[i];
-    writes[writeCount++] = depthWrite;
-    for (uint32_t i = 0; i < 4; ++i) writes[writeCount++] = bufferWrites[i];
-
-    vkUpdateDescriptorSets(device_, writeCount, writes, 0, nullptr);
+    for (uint32_t frame = 0; frame < kMaxFramesInFlight; ++frame) {
+        VkDescriptorBufferInfo constantsInfo{};
+        constantsInfo.buffer = v.constantsBuffers[frame].buffer;
+        constantsInfo.offset = 0;
+        constantsInfo.range = sizeof(VolumetricConstantsGPU);
+
+        VkWriteDescriptorSet uniformWrite{ VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET };
+        uniformWrite.dstSet = v.descriptorSets[frame][0];
+        uniformWrite.dstBinding = 0;
+        uniformWrite.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+        uniformWrite.descriptorCount = 1;
+        uniformWrite.pBufferInfo = &constantsInfo;
+
+        VkDescriptorImageInfo historyInfo{};
+        historyInfo.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+        historyInfo.imageView = v.historyViews[frame];
+
+        VkWriteDescriptorSet imageWrites[5]{};
+        for (uint32_t i = 0; i < 5; ++i) {
+            imageWrites[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+            imageWrites[i].dstSet = v.descriptorSets[frame][1];
+            imageWrites[i].dstBinding = i;
+            imageWrites[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+            imageWrites[i].descriptorCount = 1;
+        }
+        imageWrites[0].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        imageWrites[0].pImageInfo = &froxelVolumeInfo;
+        imageWrites[1].pImageInfo = &lightInfo;
+        imageWrites[2].pImageInfo = &scatteringInfo;
+        imageWrites[3].pImageInfo = &transmittanceInfo;
+        imageWrites[4].pImageInfo = &historyInfo;
+
+        // Last frame's history, bilinear filtered. GENERAL is valid for sampling.
+        VkDescriptorImageInfo prevHistoryInfo{};
+        prevHistoryInfo.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+        prevHistoryInfo.imageView = v.historyViews[(frame + kMaxFramesInFlight - 1) % kMaxFramesInFlight];
+        prevHistoryInfo.sampler = textureSampler_;
+        VkWriteDescriptorSet prevHistoryWrite{ VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET };
+        prevHistoryWrite.dstSet = v.descriptorSets[frame][1];
+        prevHistoryWrite.dstBinding = 9;
+        prevHistoryWrite.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        prevHistoryWrite.descriptorCount = 1;
+        prevHistoryWrite.pImageInfo = &prevHistoryInfo;
+
+        VkWriteDescriptorSet depthWrite{ VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET };
+        depthWrite.dstSet = v.descriptorSets[frame][1];
+        depthWrite.dstBinding = 5;
+        depthWrite.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        depthWrite.descriptorCount = 1;
+        depthWrite.pImageInfo = &depthInfo;
+
+        VkWriteDescriptorSet integratedWrites[2]{};
+        for (uint32_t i = 0; i < 2; ++i) {
+            integratedWrites[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+            integratedWrites[i].dstSet = v.descriptorSets[frame][1];
+            integratedWrites[i].dstBinding = 6 + i;
+            integratedWrites[i].descriptorCount = 1;
+        }
+        integratedWrites[0].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+        integratedWrites[0].pImageInfo = &integratedStorageInfo;
+        integratedWrites[1].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        integratedWrites[1].pImageInfo = &integratedSampledInfo;
+
+        VkWriteDescriptorSet froxelRangeWrite{ VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET };
+        froxelRangeWrite.dstSet = v.descriptorSets[frame][1];
+        froxelRangeWrite.dstBinding = 8;
+        froxelRangeWrite.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+        froxelRangeWrite.descriptorCount = 1;
+        froxelRangeWrite.pImageInfo = &froxelRangeInfo;
+
+        VkWriteDescriptorSet viewFroxelWrite{ VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET };
+        viewFroxelWrite.dstSet = v.descriptorSets[frame][1];
+        viewFroxelWrite.dstBinding = 10;
+        viewFroxelWrite.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+        viewFroxelWrite.descriptorCount = 1;
+        viewFroxelWrite.pImageInfo = &viewFroxelInfo;
+
+        VkDescriptorBufferInfo lightBufferInfo{};
+        lightBufferInfo.buffer = v.lightRecordsBuffers[frame].buffer;
+        lightBufferInfo.offset = 0;
+        lightBufferInfo.range = VK_WHOLE_SIZE;
+        VkDescriptorBufferInfo clusterOffsetInfo{};
+        clusterOffsetInfo.buffer = v.clusterOffsetsBuffer.buffer;
+        clusterOffsetInfo.offset = 0;
+        clusterOffsetInfo.range = VK_WHOLE_SIZE;
+        VkDescriptorBufferInfo clusterIndexInfo{};
+        clusterIndexInfo.buffer = v.clusterIndicesBuffer.buffer;
+        clusterIndexInfo.offset = 0;
+        clusterIndexInfo.range = VK_WHOLE_SIZE;
+        VkDescriptorBufferInfo densityBufferInfo{};
+        densityBufferInfo.buffer = v.densityVolumesBuffers[frame].buffer;
+        densityBufferInfo.offset = 0;
+        densityBufferInfo.range = VK_WHOLE_SIZE;
+        VkDescriptorBufferInfo densityAccumInfo{};
+        densityAccumInfo.buffer = v.densityAccumBuffer.buffer;
+        densityAccumInfo.offset = 0;
+        densityAccumInfo.range = VK_WHOLE_SIZE;
+        VkDescriptorBufferInfo brickListInfo{};
+        brickListInfo.buffer = v.froxelBrickBuffers[frame].buffer;
+        brickListInfo.offset = 0;
+        brickListInfo.range = VK_WHOLE_SIZE;
+        VkDescriptorBufferInfo brickMaskInfo{};
+        brickMaskInfo.buffer = v.froxelBrickMaskBuffers[frame].buffer;
+        brickMaskInfo.offset = 0;
+        brickMaskInfo.range = VK_WHOLE_SIZE;
+
+        VkWriteDescriptorSet bufferWrites[7]{};
+        bufferWrites[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        bufferWrites[0].dstSet = v.descriptorSets[frame][2];
+        bufferWrites[0].dstBinding = 0;
+        bufferWrites[0].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        bufferWrites[0].descriptorCount = 1;
+        bufferWrites[0].pBufferInfo = &lightBufferInfo;
+
+        bufferWrites[1].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        bufferWrites[1].dstSet = v.descriptorSets[frame][2];
+        bufferWrites[1].dstBinding = 1;
+        bufferWrites[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        bufferWrites[1].descriptorCount = 1;
+        bufferWrites[1].pBufferInfo = &clusterOffsetInfo;
+
+        bufferWrites[2].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        bufferWrites[2].dstSet = v.descriptorSets[frame][2];
+        bufferWrites[2].dstBinding = 2;
+        bufferWrites[2].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        bufferWrites[2].descriptorCount = 1;
+        bufferWrites[2].pBufferInfo = &clusterIndexInfo;
+
+        bufferWrites[3].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        bufferWrites[3].dstSet = v.descriptorSets[frame][2];
+        bufferWrites[3].dstBinding = 3;
+        bufferWrites[3].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        bufferWrites[3].descriptorCount = 1;
+        bufferWrites[3].pBufferInfo = &densityBufferInfo;
+
+        bufferWrites[4].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        bufferWrites[4].dstSet = v.descriptorSets[frame][2];
+        bufferWrites[4].dstBinding = 4;
+        bufferWrites[4].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        bufferWrites[4].descriptorCount = 1;
+        bufferWrites[4].pBufferInfo = &densityAccumInfo;
+
+        bufferWrites[5].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        bufferWrites[5].dstSet = v.descriptorSets[frame][2];
+        bufferWrites[5].dstBinding = 5;
+        bufferWrites[5].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        bufferWrites[5].descriptorCount = 1;
+        bufferWrites[5].pBufferInfo = &brickListInfo;
+
+        bufferWrites[6].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        bufferWrites[6].dstSet = v.descriptorSets[frame][2];
+        bufferWrites[6].dstBinding = 6;
+        bufferWrites[6].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        bufferWrites[6].descriptorCount = 1;
+        bufferWrites[6].pBufferInfo = &brickMaskInfo;
+
+        VkWriteDescriptorSet writes[18];
+        uint32_t writeCount = 0;
+        writes[writeCount++] = uniformWrite;
+        for (uint32_t i = 0; i < 5; ++i) writes[writeCount++] = imageWrites[i];
+        writes[writeCount++] = depthWrite;
+        for (uint32_t i = 0; i < 2; ++i) writes[writeCount++] = integratedWrites[i];
+        writes[writeCount++] = froxelRangeWrite;
+        writes[writeCount++] = prevHistoryWrite;
+        writes[writeCount++] = viewFroxelWrite;
+        for (uint32_t i = 0; i < 7; ++i) writes[writeCount++] = bufferWrites[i];
+
+        vkUpdateDescriptorSets(device_, writeCount, writes, 0, nullptr);
+    }
 
     return true;
 }
@@ -581,7 +1056,12 @@ bool Renderer::createVolumetricPipelines() {
     if (v.clusterPipeline) { vkDestroyPipeline(device_, v.clusterPipeline, nullptr); v.clusterPipeline = VK_NULL_HANDLE; }
     if (v.densityPipeline) { vkDestroyPipeline(device_, v.densityPipeline, nullptr); v.densityPipeline = VK_NULL_HANDLE; }
     if (v.lightPipeline) { vkDestroyPipeline(device_, v.lightPipeline, nullptr); v.lightPipeline = VK_NULL_HANDLE; }
+    if (v.rangePipeline) { vkDestroyPipeline(device_, v.rangePipeline, nullptr); v.rangePipeline = VK_NULL_HANDLE; }
     if (v.raymarchPipeline) { vkDestroyPipeline(device_, v.raymarchPipeline, nullptr); v.raymarchPipeline = VK_NULL_HANDLE; }
+    if (v.integratePipeline) { vkDestroyPipeline(device_, v.integratePipeline, nullptr); v.integratePipeline = VK_NULL_HANDLE; }
+    if (v.scatterLookupPipeline) { vkDestroyPipeline(device_, v.scatterLookupPipeline, nullptr); v.scatterLookupPipeline = VK_NULL_HANDLE; }
+    if (v.viewClusterPipeline) { vkDestroyPipeline(device_, v.viewClusterPipeline, nullptr); v.viewClusterPipeline = VK_NULL_HANDLE; }
+    if (v.viewInjectPipeline) { vkDestroyPipeline(device_, v.viewInjectPipeline, nullptr); v.viewInjectPipeline = VK_NULL_HANDLE; }
 
     VkDescriptorSetLayout layouts[3] = {
         v.descriptorSetLayouts[0],
@@ -635,7 +1115,12 @@ bool Renderer::createVolumetricPipelines() {
     if (!createPipeline("vol_cluster_build.comp.spv", v.clusterPipeline)) return false;
     if (!createPipeline("vol_density_inject.comp.spv", v.densityPipeline)) return false;
     if (!createPipeline("vol_light_inject.comp.spv", v.lightPipeline)) return false;
+    if (!createPipeline("vol_froxel_range.comp.spv", v.rangePipeline)) return false;
     if (!createPipeline("vol_raymarch.comp.spv", v.raymarchPipeline)) return false;
+    if (!createPipeline("vol_integrate.comp.spv", v.integratePipeline)) return false;
+    if (!createPipeline("vol_scatter_lookup.comp.spv", v.scatterLookupPipeline)) return false;
+    if (!createPipeline("vol_view_cluster_build.comp.spv", v.viewClusterPipeline)) return false;
+    if (!createPipeline("vol_view_inject.comp.spv", v.viewInjectPipeline)) return false;
     if (!createPipeline("vol_temporal.comp.spv", v.temporalPipeline)) return false;
 
     // Create anamorphic bloom pipeline
@@ -786,6 +1271,10 @@ bool Renderer::createVolumetricPipelines() {
 
 void Renderer::recordVolumetricPasses(VkCommandBuffer cmd) {
     if (!volumetricsEnabled_ || !volumetricsReady_) {
+        // History must come from the frame right before, see historyImages
+        volumetrics_.historyInitialized = false;
+        volumetrics_.clusterStatsCopied[currentFrame_] = false;
+        volumetricClusterDropped_ = 0;
         return;
     }
 
@@ -819,7 +1308,7 @@ void Renderer::recordVolumetricPasses(VkCommandBuffer cmd) {
     const bool firstUse = !v.imagesInitialized;
 
     std::vector<VkImageMemoryBarrier> beginBarriers;
-    beginBarriers.reserve(5);
+    beginBarriers.reserve(3 + kMaxFramesInFlight);
 
     auto pushBarrier = [&](VkImage image, VkImageLayout oldLayout) {
         VkImageMemoryBarrier barrier{ VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER };
@@ -837,11 +1326,11 @@ void Renderer::recordVolumetricPasses(VkCommandBuffer cmd) {
     };
 
     if (firstUse) {
-        pushBarrier(v.densityImage, VK_IMAGE_LAYOUT_UNDEFINED);
-        pushBarrier(v.lightImage, VK_IMAGE_LAYOUT_UNDEFINED);
         pushBarrier(v.scatteringImage, VK_IMAGE_LAYOUT_UNDEFINED);
         pushBarrier(v.transmittanceImage, VK_IMAGE_LAYOUT_UNDEFINED);
-        pushBarrier(v.historyImage, VK_IMAGE_LAYOUT_UNDEFINED);
+        for (VkImage history : v.historyImages) pushBarrier(history, VK_IMAGE_LAYOUT_UNDEFINED);
+        // Stays in GENERAL, only ever accessed as a storage image
+        pushBarrier(v.froxelRangeImage, VK_IMAGE_LAYOUT_UNDEFINED);
     } else {
         pushBarrier(v.scatteringImage, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
         pushBarrier(v.transmittanceImage, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
@@ -861,7 +1350,7 @@ void Renderer::recordVolumetricPasses(VkCommandBuffer cmd) {
         v.imagesInitialized = true;
     }
 
-    VkDescriptorSet sets[] = { v.descriptorSets[0], v.descriptorSets[1], v.descriptorSets[2] };
+    const VkDescriptorSet* sets = v.descriptorSets[currentFrame_];
 
     VolumetricPushConstants constants{};
     constants.dims = glm::ivec4(
@@ -869,58 +1358,340 @@ void Renderer::recordVolumetricPasses(VkCommandBuffer cmd) {
         static_cast<int32_t>(v.froxelGrid.height),
         static_cast<int32_t>(v.froxelGrid.depth),
         v.historyInitialized ? 1 : 0);
-    constants.scalars0 = glm::vec4(time_, 1.0f, 
+    constants.scalars0 = glm::vec4(time_, g_volumetricConfig.stepSizeMultiplier, 
                                    g_volumetricConfig.baseFogDensity * volumetricFogDensityScale_, 
                                    g_volumetricConfig.fogAlbedo);
     constants.scalars1 = glm::vec4(g_volumetricConfig.temporalBlendAlpha,
                                    v.historyInitialized ? 1.0f : 0.0f,
                                    static_cast<float>(volumetricLightCount_),
                                    static_cast<float>(volumetricDensityCount_));
-    constants.scalars2 = glm::vec4(g_volumetricConfig.phaseG, 0.8f, 1.2f, 0.0f);
-    constants.scalars3 = glm::vec4(g_volumetricConfig.lightAttenuationFalloff, 0.0f, 0.0f, 0.0f);
+    // With valid history each frame marches a jittered fraction of the steps
+    // and the temporal pass accumulates the rest
+    const bool temporalActive = v.temporalPipeline && v.historyInitialized && g_volumetricConfig.temporalBlendAlpha > 0.0f;
+    const int marchSteps = temporalActive
+        ? g_volumetricConfig.raymarchSteps / std::max(g_volumetricConfig.temporalStepDivisor, 1)
+        : g_volumetricConfig.raymarchSteps;
+    const bool viewFroxels = v.viewFroxelImage != VK_NULL_HANDLE;
+    constants.scalars2 = glm::vec4(g_volumetricConfig.phaseG,
+                                   temporalActive ? g_volumetricConfig.jitterAmount : 0.0f,
+                                   viewFroxels ? 1.0f : 0.0f,
+                                   static_cast<float>(std::max(marchSteps, 1)));
+    // Integration slices: the view-space volume's own, or the pre-integrated lookup's
+    const float sliceNear = viewFroxels ? std::max(g_volumetricConfig.froxelNear, 0.01f) : kIntegrationNearSlice;
+    const float sliceFar = viewFroxels ? g_volumetricConfig.froxelFar : g_volumetricConfig.integrationDistance;
+    constants.scalars3 = glm::vec4(g_volumetricConfig.lightAttenuationFalloff, sliceNear,
+                                   std::max(sliceFar, 2.0f * sliceNear),
+                                   g_volumetricConfig.raymarchSkipTolerance);
+
+    // This slot's last copy has landed, its fence was waited on before recording.
+    // Without a cluster build in that frame nothing was dropped.
+    const uint32_t* clusterStats = static_cast<const uint32_t*>(v.clusterStatsReadbacks[currentFrame_].mapped);
+    volumetricClusterDropped_ = (clusterStats && v.clusterStatsCopied[currentFrame_]) ? clusterStats[1] : 0;
+    v.clusterStatsCopied[currentFrame_] = false;
+
+    // Copies the cluster counters back once the build that just ran is done
+    auto copyClusterStats = [&]() {
+        VkMemoryBarrier buildBarrier{ VK_STRUCTURE_TYPE_MEMORY_BARRIER };
+        buildBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+        buildBarrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+        vkCmdPipelineBarrier(cmd,
+                             VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                             VK_PIPELINE_STAGE_TRANSFER_BIT,
+                             0,
+                             1, &buildBarrier,
+                             0, nullptr,
+                             0, nullptr);
+
+        VkBufferCopy statsCopy{};
+        statsCopy.size = sizeof(uint32_t) * 2;
+        vkCmdCopyBuffer(cmd, v.clusterOffsetsBuffer.buffer, v.clusterStatsReadbacks[currentFrame_].buffer, 1, &statsCopy);
+        v.clusterStatsCopied[currentFrame_] = true;
+
+        VkMemoryBarrier hostBarrier{ VK_STRUCTURE_TYPE_MEMORY_BARRIER };
+        hostBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        hostBarrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+        vkCmdPipelineBarrier(cmd,
+                             VK_PIPELINE_STAGE_TRANSFER_BIT,
+                             VK_PIPELINE_STAGE_HOST_BIT,
+                             0,
+                             1, &hostBarrier,
+                             0, nullptr,
+                             0, nullptr);
+    };
 
-    auto dispatch3D = [&](VkPipeline pipeline) {
-        if (!pipeline) return;
+    auto bindPass = [&](VkPipeline pipeline) {
         vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline);
         vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, v.pipelineLayout, 0, 3, sets, 0, nullptr);
         vkCmdPushConstants(cmd, v.pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(constants), &constants);
+    };
 
-        const uint32_t groupSizeX = 4;
-        const uint32_t groupSizeY = 4;
-        const uint32_t groupSizeZ = 4;
-        uint32_t gx = (v.froxelGrid.width + groupSizeX - 1) / groupSizeX;
-        uint32_t gy = (v.froxelGrid.height + groupSizeY - 1) / groupSizeY;
-        uint32_t gz = (v.froxelGrid.depth + groupSizeZ - 1) / groupSizeZ;
-        vkCmdDispatch(cmd, gx, gy, gz);
+    // Only stale bricks near the view are injected; the rest keep their stale
+    // flag until the camera turns towards them. The view-space layout has no
+    // world bricks to inject.
+    const uint32_t brickCount = viewFroxels ? 0 : selectFroxelBricks();
+    constants.brickBase = glm::ivec4(v.froxelBrickBase, static_cast<int32_t>(brickCount));
+    constants.brickDims = glm::ivec4(v.brickSlots, 0);
+
+    if (brickCount > 0 || firstUse) {
+        // Clear the cluster allocation counter, and the density accumulator on
+        // first use. Last frame's passes may still be reading them.
+        VkMemoryBarrier clearBarrier{ VK_STRUCTURE_TYPE_MEMORY_BARRIER };
+        clearBarrier.srcAccessMask = VK_ACCESS_SHADER_READ_BIT;
+        clearBarrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+
+        // The froxel volume is sampled between injections; its contents carry
+        // over from frame to frame except on first use
+        VkImageMemoryBarrier lightToWrite{ VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER };
+        lightToWrite.oldLayout = firstUse ? VK_IMAGE_LAYOUT_UNDEFINED : VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        lightToWrite.newLayout = VK_IMAGE_LAYOUT_GENERAL;
+        lightToWrite.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        lightToWrite.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        lightToWrite.image = v.lightImage;
+        lightToWrite.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        lightToWrite.subresourceRange.levelCount = 1;
+        lightToWrite.subresourceRange.layerCount = 1;
+        lightToWrite.srcAccessMask = 0;
+        lightToWrite.dstAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
 
-        VkMemoryBarrier barrier{ VK_STRUCTURE_TYPE_MEMORY_BARRIER };
-        barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
-        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
         vkCmdPipelineBarrier(cmd,
                              VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                             VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                             0,
+                             1, &clearBarrier,
+                             0, nullptr,
+                             1, &lightToWrite);
+        vkCmdFillBuffer(cmd, v.clusterOffsetsBuffer.buffer, 0, sizeof(uint32_t) * 2, 0);
+        if (firstUse) {
+            vkCmdFillBuffer(cmd, v.densityAccumBuffer.buffer, 0, VK_WHOLE_SIZE, 0);
+        }
+
+        VkMemoryBarrier fillBarrier{ VK_STRUCTURE_TYPE_MEMORY_BARRIER };
+        fillBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        fillBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+        vkCmdPipelineBarrier(cmd,
+                             VK_PIPELINE_STAGE_TRANSFER_BIT,
                              VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
                              0,
-                             1, &barrier,
+                             1, &fillBarrier,
                              0, nullptr,
                              0, nullptr);
-    };
 
-    dispatch3D(v.clusterPipeline);
-    dispatch3D(v.densityPipeline);
-    dispatch3D(v.lightPipeline);
+        // Bin lights per brick: one workgroup per listed brick
+        if (v.clusterPipeline) {
+            bindPass(v.clusterPipeline);
+            vkCmdDispatch(cmd, brickCount, 1, 1);
+            copyClusterStats();
+        }
+
+        // Scatter density records: one workgroup per record, touching only
+        // the froxels of listed bricks it covers
+        if (v.densityPipeline && volumetricDensityCount_ > 0 && brickCount > 0) {
+            bindPass(v.densityPipeline);
+            vkCmdDispatch(cmd, volumetricDensityCount_, 1, 1);
+        }
+
+        VkMemoryBarrier binBarrier{ VK_STRUCTURE_TYPE_MEMORY_BARRIER };
+        binBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+        binBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+        vkCmdPipelineBarrier(cmd,
+                             VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                             VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                             0,
+                             1, &binBarrier,
+                             0, nullptr,
+                             0, nullptr);
+
+        // One 4x4x4 workgroup per listed brick. It also resolves the density
+        // accumulator into light.a and zeroes it again for the next frame.
+        if (v.lightPipeline) {
+            bindPass(v.lightPipeline);
+            vkCmdDispatch(cmd, brickCount, 1, 1);
+        }
+
+        // Refresh the min/max of the bricks just injected
+        if (v.rangePipeline) {
+            VkMemoryBarrier lightBarrier{ VK_STRUCTURE_TYPE_MEMORY_BARRIER };
+            lightBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+            lightBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+            vkCmdPipelineBarrier(cmd,
+                                 VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                                 VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                                 0,
+                                 1, &lightBarrier,
+                                 0, nullptr,
+                                 0, nullptr);
+
+            bindPass(v.rangePipeline);
+            vkCmdDispatch(cmd, brickCount, 1, 1);
+        }
+
+        VkMemoryBarrier injectBarrier{ VK_STRUCTURE_TYPE_MEMORY_BARRIER };
+        injectBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+        injectBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+
+        VkImageMemoryBarrier lightToRead{ VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER };
+        lightToRead.oldLayout = VK_IMAGE_LAYOUT_GENERAL;
+        lightToRead.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        lightToRead.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        lightToRead.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        lightToRead.image = v.lightImage;
+        lightToRead.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        lightToRead.subresourceRange.levelCount = 1;
+        lightToRead.subresourceRange.layerCount = 1;
+        lightToRead.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+        lightToRead.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+
+        vkCmdPipelineBarrier(cmd,
+                             VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                             VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                             0,
+                             1, &injectBarrier,
+                             0, nullptr,
+                             1, &lightToRead);
+    }
+
+    if (viewFroxels && v.viewClusterPipeline && v.viewInjectPipeline) {
+        // The view-space volume moves with the camera, so all of it is
+        // rebuilt every frame: bin lights and density records per brick of
+        // view froxels, then fill each froxel from its brick's list
+        const glm::ivec3 viewBricks = viewFroxelBricks(v.viewFroxelGrid);
+        const uint32_t viewBrickCount = static_cast<uint32_t>(viewBricks.x * viewBricks.y * viewBricks.z);
+
+        VkMemoryBarrier clearBarrier{ VK_STRUCTURE_TYPE_MEMORY_BARRIER };
+        clearBarrier.srcAccessMask = VK_ACCESS_SHADER_READ_BIT;
+        clearBarrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+
+        VkImageMemoryBarrier viewFroxelToWrite{ VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER };
+        viewFroxelToWrite.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        viewFroxelToWrite.newLayout = VK_IMAGE_LAYOUT_GENERAL;
+        viewFroxelToWrite.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        viewFroxelToWrite.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        viewFroxelToWrite.image = v.viewFroxelImage;
+        viewFroxelToWrite.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        viewFroxelToWrite.subresourceRange.levelCount = 1;
+        viewFroxelToWrite.subresourceRange.layerCount = 1;
+        viewFroxelToWrite.srcAccessMask = 0;
+        viewFroxelToWrite.dstAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+
+        vkCmdPipelineBarrier(cmd,
+                             VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                             VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                             0,
+                             1, &clearBarrier,
+                             0, nullptr,
+                             1, &viewFroxelToWrite);
+        vkCmdFillBuffer(cmd, v.clusterOffsetsBuffer.buffer, 0, sizeof(uint32_t) * 2, 0);
+
+        VkMemoryBarrier fillBarrier{ VK_STRUCTURE_TYPE_MEMORY_BARRIER };
+        fillBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        fillBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+        vkCmdPipelineBarrier(cmd,
+                             VK_PIPELINE_STAGE_TRANSFER_BIT,
+                             VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                             0,
+                             1, &fillBarrier,
+                             0, nullptr,
+                             0, nullptr);
+
+        bindPass(v.viewClusterPipeline);
+        vkCmdDispatch(cmd, viewBrickCount, 1, 1);
+        copyClusterStats();
+
+        VkMemoryBarrier binBarrier{ VK_STRUCTURE_TYPE_MEMORY_BARRIER };
+        binBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+        binBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+        vkCmdPipelineBarrier(cmd,
+                             VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                             VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                             0,
+                             1, &binBarrier,
+                             0, nullptr,
+                             0, nullptr);
+
+        // One 4x4x4 workgroup per brick
+        bindPass(v.viewInjectPipeline);
+        vkCmdDispatch(cmd, static_cast<uint32_t>(viewBricks.x), static_cast<uint32_t>(viewBricks.y), static_cast<uint32_t>(viewBricks.z));
+
+        // Read by the integrate pass below, still in GENERAL
+        VkMemoryBarrier injectBarrier{ VK_STRUCTURE_TYPE_MEMORY_BARRIER };
+        injectBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+        injectBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+        vkCmdPipelineBarrier(cmd,
+                             VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                             VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                             0,
+                             1, &injectBarrier,
+                             0, nullptr,
+                             0, nullptr);
+    }
 
     const uint32_t localSize = 8;
     uint32_t gx = (v.raymarchExtent.width + localSize - 1) / localSize;
     uint32_t gy = (v.raymarchExtent.height + localSize - 1) / localSize;
 
-    if (v.raymarchPipeline) {
+    if (v.integratedImage && v.integratePipeline && v.scatterLookupPipeline) {
+        // Pre-integrated: accumulate once per view-space froxel, then one
+        // lookup per pixel. The volume is fully rewritten every frame.
+        VkImageMemoryBarrier integratedBarrier{ VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER };
+        integratedBarrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        integratedBarrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
+        integratedBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        integratedBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        integratedBarrier.image = v.integratedImage;
+        integratedBarrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        integratedBarrier.subresourceRange.levelCount = 1;
+        integratedBarrier.subresourceRange.layerCount = 1;
+        integratedBarrier.srcAccessMask = 0;
+        integratedBarrier.dstAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+        vkCmdPipelineBarrier(cmd,
+                             VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                             VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                             0,
+                             0, nullptr,
+                             0, nullptr,
+                             1, &integratedBarrier);
+
+        const uint32_t columnGroupSize = 8;
+        bindPass(v.integratePipeline);
+        vkCmdDispatch(cmd,
+                      (v.integratedGrid.width + columnGroupSize - 1) / columnGroupSize,
+                      (v.integratedGrid.height + columnGroupSize - 1) / columnGroupSize,
+                      1);
+
+        integratedBarrier.oldLayout = VK_IMAGE_LAYOUT_GENERAL;
+        integratedBarrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        integratedBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+        integratedBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+        vkCmdPipelineBarrier(cmd,
+                             VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                             VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                             0,
+                             0, nullptr,
+                             0, nullptr,
+                             1, &integratedBarrier);
+
+        bindPass(v.scatterLookupPipeline);
+        vkCmdDispatch(cmd, gx, gy, 1);
+    } else if (v.raymarchPipeline) {
         vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, v.raymarchPipeline);
         vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, v.pipelineLayout, 0, 3, sets, 0, nullptr);
         vkCmdPushConstants(cmd, v.pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(constants), &constants);
         vkCmdDispatch(cmd, gx, gy, 1);
     }
 
-    if (v.temporalPipeline) {
+    if (v.temporalPipeline && g_volumetricConfig.temporalBlendAlpha > 0.0f) {
+        // Scattering from the raymarch, and last frame's history
+        VkMemoryBarrier scatterBarrier{ VK_STRUCTURE_TYPE_MEMORY_BARRIER };
+        scatterBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+        scatterBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+        vkCmdPipelineBarrier(cmd,
+                             VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                             VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                             0,
+                             1, &scatterBarrier,
+                             0, nullptr,
+                             0, nullptr);
+
         VolumetricPushConstants temporalConstants = constants;
         temporalConstants.dims = glm::ivec4(
             static_cast<int32_t>(v.raymarchExtent.width),
@@ -937,7 +1708,45 @@ void Renderer::recordVolumetricPasses(VkCommandBuffer cmd) {
         vkCmdPushConstants(cmd, v.pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(temporalConstants), &temporalConstants);
         vkCmdDispatch(cmd, gx, gy, 1);
 
+        // The pass reads scatteringImage around each pixel, so it can only
+        // write the blended result to history. Copy it back for compositing.
+        VkMemoryBarrier historyBarrier{ VK_STRUCTURE_TYPE_MEMORY_BARRIER };
+        historyBarrier.srcAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+        historyBarrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+        vkCmdPipelineBarrier(cmd,
+                             VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                             VK_PIPELINE_STAGE_TRANSFER_BIT,
+                             0,
+                             1, &historyBarrier,
+                             0, nullptr,
+                             0, nullptr);
+
+        VkImageCopy historyCopy{};
+        historyCopy.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        historyCopy.srcSubresource.layerCount = 1;
+        historyCopy.dstSubresource = historyCopy.srcSubresource;
+        historyCopy.extent = { v.raymarchExtent.width, v.raymarchExtent.height, 1 };
+        vkCmdCopyImage(cmd,
+                       v.historyImages[currentFrame_], VK_IMAGE_LAYOUT_GENERAL,
+                       v.scatteringImage, VK_IMAGE_LAYOUT_GENERAL,
+                       1, &historyCopy);
+
+        VkMemoryBarrier copyBarrier{ VK_STRUCTURE_TYPE_MEMORY_BARRIER };
+        copyBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        copyBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+        vkCmdPipelineBarrier(cmd,
+                             VK_PIPELINE_STAGE_TRANSFER_BIT,
+                             VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                             0,
+                             1, &copyBarrier,
+                             0, nullptr,
+                             0, nullptr);
+
         v.historyInitialized = true;
+    } else if (v.temporalPipeline) {
+        // Blend of 0 would return this frame's scattering unchanged: leave it in
+        // place. No history gets written, so start over once blending is back on.
+        v.historyInitialized = false;
     } else {
         v.historyInitialized = true;
     }
@@ -987,7 +1796,7 @@ void Renderer::recordVolumetricPasses(VkCommandBuffer cmd) {
         vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, v.anamorphicBloomPipeline);
 
         // Pass 0: Horizontal blur (scattering -> temp)
-        VkDescriptorSet bloomSets0[2] = { v.descriptorSets[0], v.anamorphicBloomDescriptorSets[0] };
+        VkDescriptorSet bloomSets0[2] = { v.descriptorSets[currentFrame_][0], v.anamorphicBloomDescriptorSets[0] };
         vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, v.anamorphicBloomPipelineLayout, 0, 2, bloomSets0, 0, nullptr);
         vkCmdPushConstants(cmd, v.anamorphicBloomPipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(bloomConstants), &bloomConstants);
         vkCmdDispatch(cmd, gx, gy, 1);
@@ -1006,7 +1815,7 @@ void Renderer::recordVolumetricPasses(VkCommandBuffer cmd) {
 
         // Pass 1: Vertical blur (temp -> bloom)
         bloomConstants.dims.z = 1; // Pass 1: vertical
-        VkDescriptorSet bloomSets1[2] = { v.descriptorSets[0], v.anamorphicBloomDescriptorSets[1] };
+        VkDescriptorSet bloomSets1[2] = { v.descriptorSets[currentFrame_][0], v.anamorphicBloomDescriptorSets[1] };
         vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, v.anamorphicBloomPipelineLayout, 0, 2, bloomSets1, 0, nullptr);
         vkCmdPushConstants(cmd, v.anamorphicBloomPipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(bloomConstants), &bloomConstants);
         vkCmdDispatch(cmd, gx, gy, 1);
@@ -1090,7 +1899,8 @@ void Renderer::updateVolumetricConstants(const glm::mat4& view, const glm::mat4&
     }
 
     auto& v = volumetrics_;
-    if (!v.constantsBuffer.mapped) {
+    void* mapped = v.constantsBuffers[currentFrame_].mapped;
+    if (!mapped) {
         return;
     }
 
@@ -1106,6 +1916,37 @@ void Renderer::updateVolumetricConstants(const glm::mat4& view, const glm::mat4&
     float jitterX = halton(frameCounter_, 2u) - 0.5f;
     float jitterY = halton(frameCounter_, 3u) - 0.5f;
 
+    // Grid snapped to whole cells around the camera, bottom at ground level
+    const glm::ivec3 grid(v.froxelGrid.width, v.froxelGrid.height, v.froxelGrid.depth);
+    const glm::ivec3 origin(static_cast<int>(std::floor(cameraPos_.x / kFroxelCellSizeXZ)) - grid.x / 2,
+                            0,
+                            static_cast<int>(std::floor(cameraPos_.z / kFroxelCellSizeXZ)) - grid.z / 2);
+    if (!v.froxelOriginValid || v.injectedBaseSigma != fogDensity_) {
+        v.froxelFullRefresh = true;
+    } else if (origin != v.froxelOrigin) {
+        glm::ivec3 delta = origin - v.froxelOrigin;
+        if (std::abs(delta.x) >= grid.x || std::abs(delta.y) >= grid.y || std::abs(delta.z) >= grid.z) {
+            v.froxelFullRefresh = true;
+        } else {
+            // Texels of cells that scrolled out now hold the newly exposed slabs
+            v.froxelOrigin = origin;
+            for (int axis = 0; axis < 3; ++axis) {
+                if (delta[axis] == 0) continue;
+                glm::ivec3 slabMin(0);
+                glm::ivec3 slabMax = grid - 1;
+                if (delta[axis] > 0) {
+                    slabMin[axis] = grid[axis] - delta[axis];
+                } else {
+                    slabMax[axis] = -delta[axis] - 1;
+                }
+                markFroxelCellsDirty(origin + slabMin, origin + slabMax);
+            }
+        }
+    }
+    v.froxelOrigin = origin;
+    v.froxelOriginValid = true;
+    v.injectedBaseSigma = fogDensity_;
+
     VolumetricConstantsGPU gpu{};
     gpu.view = view;
     gpu.proj = proj;
@@ -1143,8 +1984,88 @@ void Renderer::updateVolumetricConstants(const glm::mat4& view, const glm::mat4&
         gpu.skyLightDir = glm::vec4(0.0f);
         gpu.skyLightColor = glm::vec4(0.0f);
     }
+    gpu.froxelOrigin = glm::ivec4(origin, 0);
+    gpu.froxelWrap = glm::ivec4(positiveMod(origin.x, grid.x), positiveMod(origin.y, grid.y), positiveMod(origin.z, grid.z), 0);
+
+    std::memcpy(mapped, &gpu, sizeof(gpu));
+}
+
+void Renderer::markFroxelCellsDirty(const glm::ivec3& cellMin, const glm::ivec3& cellMax) {
+    auto& v = volumetrics_;
+    if (v.froxelFullRefresh) {
+        return;
+    }
+
+    const glm::ivec3 grid(v.froxelGrid.width, v.froxelGrid.height, v.froxelGrid.depth);
+    glm::ivec3 lo = glm::max(cellMin, v.froxelOrigin);
+    glm::ivec3 hi = glm::min(cellMax, v.froxelOrigin + grid - 1);
+    if (hi.x < lo.x || hi.y < lo.y || hi.z < lo.z) {
+        return;
+    }
+
+    // Bricks stay stale until they are injected, however long they spend out of view
+    const glm::ivec3 brickMin = brickOfCell(lo);
+    const glm::ivec3 brickMax = brickOfCell(hi);
+    for (int z = brickMin.z; z <= brickMax.z; ++z) {
+        for (int y = brickMin.y; y <= brickMax.y; ++y) {
+            for (int x = brickMin.x; x <= brickMax.x; ++x) {
+                v.staleBricks[brickSlotIndex(glm::ivec3(x, y, z), v.brickSlots)] = 1;
+            }
+        }
+    }
+}
+
+uint32_t Renderer::selectFroxelBricks() {
+    auto& v = volumetrics_;
+    if (v.froxelFullRefresh) {
+        std::fill(v.staleBricks.begin(), v.staleBricks.end(), uint8_t{1});
+        v.froxelFullRefresh = false;
+    }
+
+    auto* bricks = static_cast<glm::ivec4*>(v.froxelBrickBuffers[currentFrame_].mapped);
+    auto* mask = static_cast<uint32_t*>(v.froxelBrickMaskBuffers[currentFrame_].mapped);
+    v.froxelBrickCount = 0;
+    if (!bricks || !mask) {
+        return 0;
+    }
 
-    std::memcpy(v.constantsBuffer.mapped, &gpu, sizeof(gpu));
+    const glm::ivec3 grid(v.froxelGrid.width, v.froxelGrid.height, v.froxelGrid.depth);
+    const glm::ivec3 firstBrick = brickOfCell(v.froxelOrigin);
+    const glm::ivec3 lastBrick = brickOfCell(v.froxelOrigin + grid - 1);
+    v.froxelBrickBase = firstBrick;
+
+    const size_t maskWords = (v.staleBricks.size() + 31) / 32;
+    std::memset(mask, 0, maskWords * sizeof(uint32_t));
+
+    // Bricks just outside the frustum are injected too, so trilinear taps at
+    // the edges and small camera turns find valid froxels
+    const glm::vec3 brickSize = glm::vec3(kFroxelCellSizeXZ, kFroxelCellSizeY, kFroxelCellSizeXZ) * static_cast<float>(kFroxelBrickSize);
+    const glm::vec3 margin(kFroxelCellSizeXZ + g_volumetricConfig.froxelCullMargin);
+    for (int z = firstBrick.z; z <= lastBrick.z; ++z) {
+        for (int y = firstBrick.y; y <= lastBrick.y; ++y) {
+            for (int x = firstBrick.x; x <= lastBrick.x; ++x) {
+                const glm::ivec3 brick(x, y, z);
+                uint8_t& stale = v.staleBricks[brickSlotIndex(brick, v.brickSlots)];
+                if (!stale) {
+                    continue;
+                }
+
+                AABB bounds;
+                bounds.min = glm::vec3(brick) * brickSize - margin;
+                bounds.max = glm::vec3(brick + 1) * brickSize + margin;
+                if (!viewFrustum_.intersectsAABB(bounds)) {
+                    continue;
+                }
+                stale = 0;
+
+                const glm::ivec3 local = brick - firstBrick;
+                const uint32_t bit = static_cast<uint32_t>(local.x + v.brickSlots.x * (local.y + v.brickSlots.y * local.z));
+                mask[bit >> 5] |= 1u << (bit & 31u);
+                bricks[v.froxelBrickCount++] = glm::ivec4(brick, 0);
+            }
+        }
+    }
+    return v.froxelBrickCount;
 }
 
 void Renderer::updateVolumetricLights() {
@@ -1154,7 +2075,8 @@ void Renderer::updateVolumetricLights() {
     }
 
     auto& v = volumetrics_;
-    if (!v.lightRecordsBuffer.mapped) {
+    void* mapped = v.lightRecordsBuffers[currentFrame_].mapped;
+    if (!mapped) {
         volumetricLightCount_ = 0;
         return;
     }
@@ -1165,10 +2087,94 @@ void Renderer::updateVolumetricLights() {
         return;
     }
 
-    const auto& neonLights = gen->getNeonLights();
+    // The frustum margin already keeps lights somewhat outside the view, so
+    // small camera moves do not change the selection. Reuse the last one
+    // until the camera, the loaded chunks or the light scales change.
+    const glm::vec3 cameraFront = glm::normalize(cameraFront_);
+    const glm::vec2 lightScales(volumetricLightIntensityScale_, volumetricLightRadiusScale_);
+    const glm::vec3 moved = cameraPos_ - v.lightSelectionCameraPos;
+    const float reselectDistance = g_volumetricConfig.lightReselectDistance;
+    const bool reuseSelection = v.lightSelectionValid &&
+                                v.lightSelectionChunkGeneration == gen->getChunkGeneration() &&
+                                v.lightSelectionScales == lightScales &&
+                                glm::dot(moved, moved) <= reselectDistance * reselectDistance &&
+                                glm::dot(cameraFront, v.lightSelectionCameraFront) >= std::cos(glm::radians(g_volumetricConfig.lightReselectAngle));
+    if (!reuseSelection) {
+        selectVolumetricLights(*gen);
+        v.lightSelectionValid = true;
+        v.lightSelectionCameraPos = cameraPos_;
+        v.lightSelectionCameraFront = cameraFront;
+        v.lightSelectionChunkGeneration = gen->getChunkGeneration();
+        v.lightSelectionScales = lightScales;
+        ++v.lightRecordsVersion;
+    }
+
+    volumetricLightCount_ = static_cast<uint32_t>(volumetricLights_.size());
+
+    static bool printed = false;
+    static int frameCount = 0;
+    frameCount++;
+    
+    if (!printed && volumetricLightCount_ > 0) {
+        printf("Volumetric lights: %u (neons: %zu, volumes: %zu)\n", 
+               volumetricLightCount_, 
+               gen->getNeonLightCount(),
+               gen->getLightVolumeCount());
+        
+        // Print first few light records to verify box lights
+        int boxCount = 0;
+        int beamCount = 0;
+        for (size_t i = 0; i < std::min(size_t(10), volumetricLights_.size()); ++i) {
+            const auto& light = volumetricLights_[i];
+            bool isBox = (light.sizeShape & kLightShapeBoxBit) != 0;
+            if (isBox) {
+                printf("  Light #%zu: BOX at (%.1f, %.1f, %.1f) size=%.1f intensity=%.1f\n",
+                       i, light.position.x, light.position.y, light.position.z,
+                       glm::unpackHalf1x16(static_cast<uint16_t>(light.sizeShape)),
+                       glm::unpackHalf1x16(static_cast<uint16_t>(light.colorIntensity[1] >> 16)));
+                boxCount++;
+            } else {
+                beamCount++;
+            }
+        }
+        printf("  Total: %d boxes, %d beams in first 10\n", boxCount, beamCount);
+        printed = true;
+    }
+    
+    // Print froxel grid bounds every 60 frames
+    if (frameCount % 60 == 1) {
+        glm::vec3 cellSize(kFroxelCellSizeXZ, kFroxelCellSizeY, kFroxelCellSizeXZ);
+        glm::vec3 gridExtent = glm::vec3(v.froxelGrid.width, v.froxelGrid.height, v.froxelGrid.depth) * cellSize;
+        glm::vec3 gridMin = glm::vec3(v.froxelOrigin) * cellSize;
+        glm::vec3 gridMax = gridMin + gridExtent;
+        
+        printf("Froxel grid: camera=(%.1f,%.1f,%.1f) bounds=(%.1f,%.1f,%.1f) to (%.1f,%.1f,%.1f)\n",
+               cameraPos_.x, cameraPos_.y, cameraPos_.z,
+               gridMin.x, gridMin.y, gridMin.z,
+               gridMax.x, gridMax.y, gridMax.z);
+    }
+
+    if (v.uploadedLightsVersion[currentFrame_] != v.lightRecordsVersion) {
+        uploadChangedRecords(mapped, v.uploadedLights[currentFrame_], volumetricLights_);
+        v.uploadedLightsVersion[currentFrame_] = v.lightRecordsVersion;
+    }
+}
+
+
+void Renderer::selectVolumetricLights(const CityGenerator& gen) {
+    auto& v = volumetrics_;
     volumetricLights_.clear();
     volumetricLights_.reserve(kMaxVolumetricLights);
 
+    auto pushLight = [&](const glm::vec3& position, const glm::vec3& color, float intensity, float size, bool isBox) {
+        VolumetricLightRecord record;
+        record.position = position;
+        record.sizeShape = glm::packHalf1x16(size) | (isBox ? kLightShapeBoxBit : 0u);
+        record.colorIntensity[0] = packHalf2(color.r, color.g);
+        record.colorIntensity[1] = packHalf2(color.b, intensity);
+        volumetricLights_.push_back(record);
+    };
+
     // Smart light registration: only add lights that are:
     // 1. Within reasonable distance (distance culling)
     // 2. In or near the view frustum (with margin for off-screen influence)
@@ -1196,121 +2202,116 @@ void Renderer::updateVolumetricLights() {
     };
     
     std::vector<LightCandidate> candidates;
-    candidates.reserve(std::min(neonLights.size(), size_t(2048)));
+    candidates.reserve(std::min(gen.getNeonLightCount(), size_t(2048)));
     
-    // Gather candidate lights
-    for (const auto& light : neonLights) {
-        glm::vec3 toLight = light.position - cameraPos_;
-        float distSq = glm::dot(toLight, toLight);
+    // Gather candidate lights from the chunks within maxDistance only
+    forEachChunkNear(gen, cameraPos_, maxDistance, [&](const CityChunk& chunk) {
+        for (const auto& light : chunk.neonLights) {
+            glm::vec3 toLight = light.position - cameraPos_;
+            float distSq = glm::dot(toLight, toLight);
         
-        // Distance cull - skip if too far
-        if (distSq > maxDistSq) {
-            continue;
-        }
+            // Distance cull - skip if too far
+            if (distSq > maxDistSq) {
+                continue;
+            }
         
-        float radius = light.radius * g_volumetricConfig.neonRadiusMultiplier * volumetricLightRadiusScale_;
-        float influenceRadius = radius * 20.0f; // Volumetric effect extends far
+            float radius = light.radius * g_volumetricConfig.neonRadiusMultiplier * volumetricLightRadiusScale_;
+            float influenceRadius = radius * 20.0f; // Volumetric effect extends far
         
-        // Check if light influence intersects frustum (with margin)
-        bool inFrustum = viewFrustum_.intersectsSphere(light.position, influenceRadius + frustumMargin);
+            // Check if light influence intersects frustum (with margin)
+            bool inFrustum = viewFrustum_.intersectsSphere(light.position, influenceRadius + frustumMargin);
         
-        // Only consider lights that are in frustum OR very close to camera
-        if (!inFrustum && distSq > (nearKeepDistance * nearKeepDistance)) {
-            continue;
-        }
+            // Only consider lights that are in frustum OR very close to camera
+            if (!inFrustum && distSq > (nearKeepDistance * nearKeepDistance)) {
+                continue;
+            }
         
-        LightCandidate candidate;
-        candidate.position = light.position;
-        candidate.color = light.color;
-        candidate.intensity = light.intensity * g_volumetricConfig.neonIntensityMultiplier * volumetricLightIntensityScale_;
-        candidate.radius = radius;
-        candidate.distanceSq = distSq;
-        candidate.inFrustum = inFrustum;
+            LightCandidate candidate;
+            candidate.position = light.position;
+            candidate.color = light.color;
+            candidate.intensity = light.intensity * g_volumetricConfig.neonIntensityMultiplier * volumetricLightIntensityScale_;
+            candidate.radius = radius;
+            candidate.distanceSq = distSq;
+            candidate.inFrustum = inFrustum;
         
-        candidates.push_back(candidate);
-    }
+            candidates.push_back(candidate);
+        }
+    });
     
-    // Sort candidates: in-frustum first, then by distance
-    std::sort(candidates.begin(), candidates.end(), 
-              [](const LightCandidate& a, const LightCandidate& b) {
-                  if (a.inFrustum != b.inFrustum) return a.inFrustum; // Prioritize in-frustum
-                  return a.distanceSq < b.distanceSq; // Then by distance
-              });
+    // Only the budget needs ordering: in-frustum first, then by distance
+    const size_t neonBudget = std::min(candidates.size(), static_cast<size_t>(kMaxVolumetricLights));
+    std::partial_sort(candidates.begin(), candidates.begin() + neonBudget, candidates.end(),
+                      [](const LightCandidate& a, const LightCandidate& b) {
+                          if (a.inFrustum != b.inFrustum) return a.inFrustum; // Prioritize in-frustum
+                          return a.distanceSq < b.distanceSq; // Then by distance
+                      });
     
     // Add sorted candidates up to budget
-    for (const auto& candidate : candidates) {
-        volumetricLights_.push_back({ 
-            glm::vec4(candidate.color, candidate.intensity), 
-            glm::vec4(candidate.position, -candidate.radius) 
-        });
-        
-        if (volumetricLights_.size() >= kMaxVolumetricLights) {
-            break;
-        }
+    for (size_t i = 0; i < neonBudget; ++i) {
+        const auto& candidate = candidates[i];
+        pushLight(candidate.position, candidate.color, candidate.intensity, candidate.radius, true);
     }
 
     // Add light volumes with same prioritization strategy
     if (volumetricLights_.size() < kMaxVolumetricLights) {
-        const auto& lightVolumes = gen->getLightVolumes();
-        
         struct VolumeCandidate {
             const LightVolume* volumePtr;
             float distanceSq;
             bool inFrustum;
-            
-            // Make this move/copy assignable for std::sort
-            VolumeCandidate() = default;
-            VolumeCandidate(const VolumeCandidate&) = default;
-            VolumeCandidate& operator=(const VolumeCandidate&) = default;
         };
         
         std::vector<VolumeCandidate> volumeCandidates;
-        volumeCandidates.reserve(std::min(lightVolumes.size(), size_t(512)));
+        volumeCandidates.reserve(std::min(gen.getLightVolumeCount(), size_t(512)));
         
-        for (const auto& volume : lightVolumes) {
-            glm::vec3 toVolume = volume.basePosition - cameraPos_;
-            float distSq = glm::dot(toVolume, toVolume);
+        forEachChunkNear(gen, cameraPos_, maxDistance, [&](const CityChunk& chunk) {
+            for (const auto& volume : chunk.lightVolumes) {
+                glm::vec3 toVolume = volume.basePosition - cameraPos_;
+                float distSq = glm::dot(toVolume, toVolume);
             
-            // Distance cull
-            if (distSq > maxDistSq) {
-                continue;
-            }
+                // Distance cull
+                if (distSq > maxDistSq) {
+                    continue;
+                }
             
-            float volumeRadius = volume.baseRadius * volumetricLightRadiusScale_;
-            float volumeHeight = volume.height;
-            glm::vec3 volumeCenter = volume.basePosition + glm::vec3(0, volumeHeight * 0.5f, 0);
-            float influenceRadius = std::max(volumeRadius, volumeHeight * 0.5f) * 5.0f;
+                float volumeRadius = volume.baseRadius * volumetricLightRadiusScale_;
+                float volumeHeight = volume.height;
+                glm::vec3 volumeCenter = volume.basePosition + glm::vec3(0, volumeHeight * 0.5f, 0);
+                float influenceRadius = std::max(volumeRadius, volumeHeight * 0.5f) * 5.0f;
             
-            // Frustum cull with margin
-            bool inFrustum = viewFrustum_.intersectsSphere(volumeCenter, influenceRadius + frustumMargin);
+                // Frustum cull with margin
+                bool inFrustum = viewFrustum_.intersectsSphere(volumeCenter, influenceRadius + frustumMargin);
             
-            // Keep if in frustum or very close
-            if (!inFrustum && distSq > (nearKeepDistance * nearKeepDistance)) {
-                continue;
-            }
+                // Keep if in frustum or very close
+                if (!inFrustum && distSq > (nearKeepDistance * nearKeepDistance)) {
+                    continue;
+                }
             
-            VolumeCandidate candidate;
-            candidate.volumePtr = &volume;
-            candidate.distanceSq = distSq;
-            candidate.inFrustum = inFrustum;
+                VolumeCandidate candidate;
+                candidate.volumePtr = &volume;
+                candidate.distanceSq = distSq;
+                candidate.inFrustum = inFrustum;
             
-            volumeCandidates.push_back(candidate);
-        }
+                volumeCandidates.push_back(candidate);
+            }
+        });
         
-        // Sort: in-frustum first, then by distance
-        std::sort(volumeCandidates.begin(), volumeCandidates.end(),
-                  [](const VolumeCandidate& a, const VolumeCandidate& b) {
-                      if (a.inFrustum != b.inFrustum) return a.inFrustum;
-                      return a.distanceSq < b.distanceSq;
-                  });
+        // Every volume takes at least one record, so no more than the
+        // remaining budget can be used: order just those
+        const size_t volumeBudget = std::min(volumeCandidates.size(), static_cast<size_t>(kMaxVolumetricLights) - volumetricLights_.size());
+        std::partial_sort(volumeCandidates.begin(), volumeCandidates.begin() + volumeBudget, volumeCandidates.end(),
+                          [](const VolumeCandidate& a, const VolumeCandidate& b) {
+                              if (a.inFrustum != b.inFrustum) return a.inFrustum;
+                              return a.distanceSq < b.distanceSq;
+                          });
         
         // Add volume lights up to budget
-        for (const auto& candidate : volumeCandidates) {
+        for (size_t c = 0; c < volumeBudget; ++c) {
+            const auto& candidate = volumeCandidates[c];
             if (volumetricLights_.size() >= kMaxVolumetricLights) {
                 break;
             }
             
-            const auto& volume = *candidate.volumePtr;
+const auto& volume = *candidate.volumePtr;
             
             if (volume.isCone) {
                 // Cone/cylinder - sample vertically
@@ -1320,18 +2321,17 @@ void Renderer::updateVolumetricLights() {
                     glm::vec3 pos = volume.basePosition + glm::vec3(0.0f, volume.height * t, 0.0f);
                     float radius = volume.baseRadius * (1.0f + t * 1.2f) * volumetricLightRadiusScale_;
                     float intensity = volume.intensity * (1.0f - t * 0.15f) * volumetricLightIntensityScale_;
-                    volumetricLights_.push_back({ glm::vec4(volume.color, intensity), glm::vec4(pos, radius) });
+                    pushLight(pos, volume.color, intensity, radius, false);
                     if (volumetricLights_.size() >= kMaxVolumetricLights) {
                         break;
                     }
                 }
             } else {
-                // Cube - single centered light with negative radius to indicate box shape
+                // Cube - single centered box light
                 glm::vec3 pos = volume.basePosition + glm::vec3(0.0f, volume.height * 0.5f, 0.0f);
                 float boxSize = volume.baseRadius * volumetricLightRadiusScale_;
                 float intensity = volume.intensity * volumetricLightIntensityScale_;
-                // Negative radius signals box shape in shader
-                volumetricLights_.push_back({ glm::vec4(volume.color, intensity), glm::vec4(pos, -boxSize) });
+                pushLight(pos, volume.color, intensity, boxSize, true);
             }
             if (volumetricLights_.size() >= kMaxVolumetricLights) {
                 break;
@@ -1339,62 +2339,23 @@ void Renderer::updateVolumetricLights() {
         }
     }
 
-    volumetricLightCount_ = static_cast<uint32_t>(volumetricLights_.size());
-    std::size_t bytesToCopy = volumetricLightCount_ * sizeof(VolumetricLightRecord);
-
-    static bool printed = false;
-    static int frameCount = 0;
-    frameCount++;
-    
-    if (!printed && volumetricLightCount_ > 0) {
-        printf("Volumetric lights: %u (neons: %zu, volumes: %zu)\n", 
-               volumetricLightCount_, 
-               gen->getNeonLights().size(),
-               gen->getLightVolumes().size());
-        
-        // Print first few light records to verify box lights
-        int boxCount = 0;
-        int beamCount = 0;
-        for (size_t i = 0; i < std::min(size_t(10), volumetricLights_.size()); ++i) {
-            const auto& light = volumetricLights_[i];
-            bool isBox = light.positionRadius.w < 0;
-            if (isBox) {
-                printf("  Light #%zu: BOX at (%.1f, %.1f, %.1f) size=%.1f intensity=%.1f\n",
-                       i, light.positionRadius.x, light.positionRadius.y, light.positionRadius.z,
-                       -light.positionRadius.w, light.colorIntensity.w);
-                boxCount++;
-            } else {
-                beamCount++;
-            }
+    // Lights that came or went since the last injection dirty the cells they reach
+    const glm::vec3 cellSize(kFroxelCellSizeXZ, kFroxelCellSizeY, kFroxelCellSizeXZ);
+    forEachChangedRecord(v.injectedLights, volumetricLights_, [&](const VolumetricLightRecord& light) {
+        const glm::vec3& position = light.position;
+        float size = glm::unpackHalf1x16(static_cast<uint16_t>(light.sizeShape));
+        glm::vec3 boundsMin;
+        glm::vec3 boundsMax;
+        if (light.sizeShape & kLightShapeBoxBit) {
+            boundsMin = position - glm::vec3(size * 0.5f);
+            boundsMax = position + glm::vec3(size * 0.5f);
+        } else {
+            float reach = size * kLightBeamMaxSpread;
+            boundsMin = position - glm::vec3(reach, 0.0f, reach);
+            boundsMax = position + glm::vec3(reach, kLightBeamMaxHeight, reach);
         }
-        printf("  Total: %d boxes, %d beams in first 10\n", boxCount, beamCount);
-        printed = true;
-    }
-    
-    // Print froxel grid bounds every 60 frames
-    if (frameCount % 60 == 1) {
-        const float cellSizeXZ = 4.0f;
-        const float cellSizeY = 4.0f;
-        glm::vec3 cellSize(cellSizeXZ, cellSizeY, cellSizeXZ);
-        glm::vec3 gridExtent = glm::vec3(v.froxelGrid.width, v.froxelGrid.height, v.froxelGrid.depth) * cellSize;
-        glm::vec3 gridCenter = glm::floor(cameraPos_ / cellSize) * cellSize;
-        gridCenter.y = gridExtent.y * 0.5f;
-        glm::vec3 gridMin = gridCenter - gridExtent * 0.5f;
-        glm::vec3 gridMax = gridMin + gridExtent;
-        
-        printf("Froxel grid: camera=(%.1f,%.1f,%.1f) bounds=(%.1f,%.1f,%.1f) to (%.1f,%.1f,%.1f)\n",
-               cameraPos_.x, cameraPos_.y, cameraPos_.z,
-               gridMin.x, gridMin.y, gridMin.z,
-               gridMax.x, gridMax.y, gridMax.z);
-    }
-
-    if (bytesToCopy > 0) {
-        std::memcpy(v.lightRecordsBuffer.mapped, volumetricLights_.data(), bytesToCopy);
-    }
-    if (volumetricLightCount_ < kMaxVolumetricLights) {
-        std::size_t remaining = (kMaxVolumetricLights - volumetricLightCount_) * sizeof(VolumetricLightRecord);
-        std::memset(static_cast<char*>(v.lightRecordsBuffer.mapped) + bytesToCopy, 0, remaining);
-    }
+        markFroxelCellsDirty(glm::ivec3(glm::floor(boundsMin / cellSize)), glm::ivec3(glm::floor(boundsMax / cellSize)));
+    });
 }
 
 void Renderer::updateVolumetricDensities() {
@@ -1404,7 +2365,8 @@ void Renderer::updateVolumetricDensities() {
     }
 
     auto& v = volumetrics_;
-    if (!v.densityVolumesBuffer.mapped) {
+    void* mapped = v.densityVolumesBuffers[currentFrame_].mapped;
+    if (!mapped) {
         volumetricDensityCount_ = 0;
         return;
     }
@@ -1415,54 +2377,128 @@ void Renderer::updateVolumetricDensities() {
         return;
     }
 
+    // Records cover the world grid, or in the view-space layout the cells
+    // within froxelFar of the camera. That box is snapped to whole bricks and
+    // padded by one, so it only moves every few meters.
+    glm::ivec3 selectionMin = v.froxelOrigin;
+    glm::ivec3 selectionMax = v.froxelOrigin + glm::ivec3(v.froxelGrid.width, v.froxelGrid.height, v.froxelGrid.depth) - 1;
+    if (v.viewFroxelImage) {
+        const glm::vec3 cellSize(kFroxelCellSizeXZ, kFroxelCellSizeY, kFroxelCellSizeXZ);
+        const glm::ivec3 reach = glm::ivec3(glm::ceil(glm::vec3(g_volumetricConfig.froxelFar) / cellSize)) + kFroxelBrickSize;
+        const glm::ivec3 cameraBrick = brickOfCell(glm::ivec3(glm::floor(cameraPos_ / cellSize)));
+        selectionMin = cameraBrick * kFroxelBrickSize - reach;
+        selectionMax = cameraBrick * kFroxelBrickSize + reach;
+    }
+
+    // Records only change with that box or the loaded chunks
+    if (!v.densitySelectionValid || v.densitySelectionOrigin != selectionMin ||
+        v.densitySelectionChunkGeneration != gen->getChunkGeneration()) {
+        selectVolumetricDensities(*gen, selectionMin, selectionMax);
+        v.densitySelectionValid = true;
+        v.densitySelectionOrigin = selectionMin;
+        v.densitySelectionChunkGeneration = gen->getChunkGeneration();
+        ++v.densityRecordsVersion;
+    }
+
+    volumetricDensityCount_ = static_cast<uint32_t>(volumetricDensities_.size());
+    if (v.uploadedDensitiesVersion[currentFrame_] == v.densityRecordsVersion) {
+        return;
+    }
+
+    // The albedo palette heads the buffer as half4 entries. Entries are
+    // only ever appended, so just the new ones need writing.
+    uint32_t* palette = static_cast<uint32_t*>(mapped);
+    for (size_t i = v.uploadedAlbedoPaletteSize[currentFrame_]; i < volumetricAlbedoPalette_.size(); ++i) {
+        const glm::vec3& albedo = volumetricAlbedoPalette_[i];
+        palette[i * 2] = packHalf2(albedo.r, albedo.g);
+        palette[i * 2 + 1] = packHalf2(albedo.b, 0.0f);
+    }
+    v.uploadedAlbedoPaletteSize[currentFrame_] = volumetricAlbedoPalette_.size();
+    const glm::ivec4 cellBase(v.densityCellBase, 0);
+    std::memcpy(static_cast<char*>(mapped) + kDensityPaletteBytes, &cellBase, sizeof(cellBase));
+
+    uploadChangedRecords(static_cast<char*>(mapped) + kDensityHeaderBytes, v.uploadedDensities[currentFrame_], volumetricDensities_);
+    v.uploadedDensitiesVersion[currentFrame_] = v.densityRecordsVersion;
+}
+
+void Renderer::selectVolumetricDensities(const CityGenerator& gen, const glm::ivec3& gridMin, const glm::ivec3& gridMax) {
+    auto& v = volumetrics_;
     volumetricDensities_.clear();
     volumetricDensities_.reserve(kMaxDensityVolumes);
 
-    const auto& buildings = gen->getBuildings();
-    const auto& lightVolumes = gen->getLightVolumes();
-    const float halfWidth = (v.froxelGrid.width * kFroxelCellSizeXZ) * 0.5f;
-    const float halfDepth = (v.froxelGrid.depth * kFroxelCellSizeXZ) * 0.5f;
-    const float halfHeight = (v.froxelGrid.height * kFroxelCellSizeY) * 0.5f;
+    const glm::vec3 cellSize(kFroxelCellSizeXZ, kFroxelCellSizeY, kFroxelCellSizeXZ);
 
-    auto worldToFroxel = [](float world, float camera, float halfExtent, float cellSize, int dim) {
-        float local = world - camera + halfExtent;
-        float coord = local / cellSize;
-        return glm::clamp(coord, 0.0f, static_cast<float>(dim - 1));
+    // Bounds are stored relative to a coarsely snapped base so they fit int16
+    // anywhere in the world. The base rarely moves, but when it does every
+    // record changes: rebuild the whole volume rather than diff them.
+    const glm::ivec3 cellBase = glm::ivec3(glm::floor(glm::vec3(gridMin) / static_cast<float>(kDensityCellBaseSnap))) * kDensityCellBaseSnap;
+    if (cellBase != v.densityCellBase) {
+        v.densityCellBase = cellBase;
+        v.froxelFullRefresh = true;
+    }
+
+    // Records hold the cells they cover, so they stay the same while the grid scrolls
+    auto toCells = [&](const glm::vec3& minWorld, const glm::vec3& maxWorld, glm::vec3& minCell, glm::vec3& maxCell) {
+        minCell = glm::floor(minWorld / cellSize);
+        maxCell = glm::floor(maxWorld / cellSize);
+        return maxCell.x >= gridMin.x && minCell.x <= gridMax.x &&
+               maxCell.y >= gridMin.y && minCell.y <= gridMax.y &&
+               maxCell.z >= gridMin.z && minCell.z <= gridMax.z;
     };
 
-    for (const auto& building : buildings) {
-        glm::vec3 minWorld = glm::vec3(
-            building.position.x - building.size.x * 0.5f,
-            building.position.y,
-            building.position.z - building.size.z * 0.5f);
-        glm::vec3 maxWorld = minWorld + building.size;
-
-        float minX = worldToFroxel(minWorld.x, cameraPos_.x, halfWidth, kFroxelCellSizeXZ, v.froxelGrid.width);
-        float maxX = worldToFroxel(maxWorld.x, cameraPos_.x, halfWidth, kFroxelCellSizeXZ, v.froxelGrid.width);
-        float minY = worldToFroxel(minWorld.y, cameraPos_.y, halfHeight, kFroxelCellSizeY, v.froxelGrid.height);
-        float maxY = worldToFroxel(maxWorld.y, cameraPos_.y, halfHeight, kFroxelCellSizeY, v.froxelGrid.height);
-        float minZ = worldToFroxel(minWorld.z, cameraPos_.z, halfDepth, kFroxelCellSizeXZ, v.froxelGrid.depth);
-        float maxZ = worldToFroxel(maxWorld.z, cameraPos_.z, halfDepth, kFroxelCellSizeXZ, v.froxelGrid.depth);
-
-        if (minX >= v.froxelGrid.width || maxX <= 0.0f ||
-            minY >= v.froxelGrid.height || maxY <= 0.0f ||
-            minZ >= v.froxelGrid.depth || maxZ <= 0.0f) {
-            continue;
+    // Palette entries are never reordered, so unchanged records keep their bytes.
+    // Once the palette is full, new albedos take the closest entry.
+    auto albedoIndex = [&](const glm::vec3& albedo) {
+        uint16_t closest = 0;
+        float closestDistSq = -1.0f;
+        for (size_t i = 0; i < volumetricAlbedoPalette_.size(); ++i) {
+            const glm::vec3 diff = volumetricAlbedoPalette_[i] - albedo;
+            const float distSq = glm::dot(diff, diff);
+            if (closestDistSq < 0.0f || distSq < closestDistSq) {
+                closest = static_cast<uint16_t>(i);
+                closestDistSq = distSq;
+            }
         }
+        if (closestDistSq != 0.0f && volumetricAlbedoPalette_.size() < kDensityAlbedoPaletteSize) {
+            volumetricAlbedoPalette_.push_back(albedo);
+            return static_cast<uint16_t>(volumetricAlbedoPalette_.size() - 1);
+        }
+        return closest;
+    };
 
+    auto pushDensity = [&](const glm::vec3& minCell, const glm::vec3& maxCell, float sigma, const glm::vec3& albedo) {
         VolumetricDensityRecord record;
-        record.minBoundsSigma = glm::vec4(std::floor(minX), std::floor(minY), std::floor(minZ), 0.05f);
-        record.maxBounds = glm::vec4(std::ceil(maxX), std::ceil(maxY), std::ceil(maxZ), 0.0f);
-        record.albedo = glm::vec4(0.9f, 0.9f, 0.9f, 0.0f);
-
+        for (int axis = 0; axis < 3; ++axis) {
+            record.minCell[axis] = packCellCoord(minCell[axis], cellBase[axis]);
+            record.maxCell[axis] = packCellCoord(maxCell[axis], cellBase[axis]);
+        }
+        record.sigma = glm::packHalf1x16(sigma);
+        record.albedoIndex = albedoIndex(albedo);
         volumetricDensities_.push_back(record);
-        if (volumetricDensities_.size() >= kMaxDensityVolumes) {
-            break;
+    };
+
+    // Only chunks under the grid can contribute
+    const glm::vec2 rectMin = glm::vec2(gridMin.x, gridMin.z) * kFroxelCellSizeXZ;
+    const glm::vec2 rectMax = glm::vec2(gridMax.x + 1, gridMax.z + 1) * kFroxelCellSizeXZ;
+
+    forEachChunkInRect(gen, rectMin, rectMax, [&](const CityChunk& chunk) {
+        for (const AABB& bounds : chunk.buildingBounds) {
+            if (volumetricDensities_.size() >= kMaxDensityVolumes) {
+                return;
+            }
+
+            glm::vec3 minCell;
+            glm::vec3 maxCell;
+            if (!toCells(bounds.min, bounds.max, minCell, maxCell)) {
+                continue;
+            }
+
+            pushDensity(minCell, maxCell, 0.05f, glm::vec3(0.9f));
         }
-    }
+    });
 
-    if (volumetricDensities_.size() < kMaxDensityVolumes) {
-        for (const auto& volume : lightVolumes) {
+    forEachChunkInRect(gen, rectMin, rectMax, [&](const CityChunk& chunk) {
+        for (const auto& volume : chunk.lightVolumes) {
             const int layers = volume.isCone ? 8 : 6;
             float stepHeight = volume.height / static_cast<float>(layers);
             for (int i = 0; i < layers && volumetricDensities_.size() < kMaxDensityVolumes; ++i) {
@@ -1472,42 +2508,25 @@ void Renderer::updateVolumetricDensities() {
                 glm::vec3 layerMinWorld = volume.basePosition + glm::vec3(-layerRadius, stepHeight * i, -layerRadius);
                 glm::vec3 layerMaxWorld = layerMinWorld + glm::vec3(layerRadius * 2.0f, stepHeight + 2.0f, layerRadius * 2.0f);
 
-                float minX = worldToFroxel(layerMinWorld.x, cameraPos_.x, halfWidth, kFroxelCellSizeXZ, v.froxelGrid.width);
-                float maxX = worldToFroxel(layerMaxWorld.x, cameraPos_.x, halfWidth, kFroxelCellSizeXZ, v.froxelGrid.width);
-                float minY = worldToFroxel(layerMinWorld.y, cameraPos_.y, halfHeight, kFroxelCellSizeY, v.froxelGrid.height);
-                float maxY = worldToFroxel(layerMaxWorld.y, cameraPos_.y, halfHeight, kFroxelCellSizeY, v.froxelGrid.height);
-                float minZ = worldToFroxel(layerMinWorld.z, cameraPos_.z, halfDepth, kFroxelCellSizeXZ, v.froxelGrid.depth);
-                float maxZ = worldToFroxel(layerMaxWorld.z, cameraPos_.z, halfDepth, kFroxelCellSizeXZ, v.froxelGrid.depth);
-
-                if (minX >= v.froxelGrid.width || maxX <= 0.0f ||
-                    minY >= v.froxelGrid.height || maxY <= 0.0f ||
-                    minZ >= v.froxelGrid.depth || maxZ <= 0.0f) {
+                glm::vec3 minCell;
+                glm::vec3 maxCell;
+                if (!toCells(layerMinWorld, layerMaxWorld, minCell, maxCell)) {
                     continue;
                 }
 
-                VolumetricDensityRecord record;
                 float sigmaBoost = 0.15f * (1.0f - t * 0.3f);
-                record.minBoundsSigma = glm::vec4(std::floor(minX), std::floor(minY), std::floor(minZ), sigmaBoost);
-                record.maxBounds = glm::vec4(std::ceil(maxX), std::ceil(maxY), std::ceil(maxZ), 0.0f);
-                record.albedo = glm::vec4(volume.color * 1.2f, 0.0f);
-                volumetricDensities_.push_back(record);
+                pushDensity(minCell, maxCell, sigmaBoost, volume.color * 1.2f);
             }
             if (volumetricDensities_.size() >= kMaxDensityVolumes) {
-                break;
+                return;
             }
         }
-    }
-
-    volumetricDensityCount_ = static_cast<uint32_t>(volumetricDensities_.size());
-    std::size_t bytesToCopy = volumetricDensityCount_ * sizeof(VolumetricDensityRecord);
+    });
 
-    if (bytesToCopy > 0) {
-        std::memcpy(v.densityVolumesBuffer.mapped, volumetricDensities_.data(), bytesToCopy);
-    }
-    if (volumetricDensityCount_ < kMaxDensityVolumes) {
-        std::size_t remaining = (kMaxDensityVolumes - volumetricDensityCount_) * sizeof(VolumetricDensityRecord);
-        std::memset(static_cast<char*>(v.densityVolumesBuffer.mapped) + bytesToCopy, 0, remaining);
-    }
+    forEachChangedRecord(v.injectedDensities, volumetricDensities_, [&](const VolumetricDensityRecord& record) {
+        markFroxelCellsDirty(glm::ivec3(record.minCell[0], record.minCell[1], record.minCell[2]) + cellBase,
+                             glm::ivec3(record.maxCell[0], record.maxCell[1], record.maxCell[2]) + cellBase);
+    });
 }
 
 }
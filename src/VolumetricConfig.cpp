@@ -126,6 +126,10 @@ bool VolumetricConfig::loadFromFile(const char* path) {
     parseInt(json, "depth", froxelGridZ);
     parseFloat(json, "near", froxelNear);
     parseFloat(json, "far", froxelFar);
+    parseBool(json, "view_space", viewSpaceFroxels);
+    parseInt(json, "view_width", viewFroxelGridX);
+    parseInt(json, "view_height", viewFroxelGridY);
+    parseInt(json, "view_slices", viewFroxelSlices);
     
     parseFloat(json, "base_density", baseFogDensity);
     parseVec3(json, "color", fogColorR, fogColorG, fogColorB);
@@ -152,6 +156,9 @@ bool VolumetricConfig::loadFromFile(const char* path) {
     parseFloat(json, "max_distance", maxLightDistance);
     parseFloat(json, "frustum_margin", frustumMargin);
     parseFloat(json, "near_camera_always_keep", nearCameraAlwaysKeep);
+    parseFloat(json, "froxel_margin", froxelCullMargin);
+    parseFloat(json, "reselect_distance", lightReselectDistance);
+    parseFloat(json, "reselect_angle", lightReselectAngle);
     
     parseInt(json, "attempts", groundLightAttempts);
     parseInt(json, "max_count", groundLightMaxCount);
@@ -165,9 +172,17 @@ bool VolumetricConfig::loadFromFile(const char* path) {
     
     parseInt(json, "steps", raymarchSteps);
     parseFloat(json, "step_size_multiplier", stepSizeMultiplier);
+    parseFloat(json, "skip_tolerance", raymarchSkipTolerance);
+    parseInt(json, "resolution_divisor", scatteringResolutionDivisor);
     parseFloat(json, "jitter_amount", jitterAmount);
+    parseBool(json, "preintegrated", preintegratedScattering);
+    parseInt(json, "integration_width", integrationGridX);
+    parseInt(json, "integration_height", integrationGridY);
+    parseInt(json, "integration_slices", integrationSlices);
+    parseFloat(json, "integration_distance", integrationDistance);
     
     parseFloat(json, "blend_alpha", temporalBlendAlpha);
+    parseInt(json, "step_divisor", temporalStepDivisor);
     
     parseFloat(json, "scattering_multiplier", scatteringMultiplier);
     parseFloat(json, "transmittance_floor", transmittanceFloor);
@@ -13,7 +13,8 @@ struct VolumetricConfig {
     // FROXEL GRID DIMENSIONS
     // ========================================================================
     // 3D grid resolution for volumetric calculations
-    // Higher = more detail but slower performance
+    // Higher = more detail but slower performance. Rounded up to whole
+    // 4^3 bricks; a hot reload that changes it reallocates the volume.
     int froxelGridX = 160;
     int froxelGridY = 96;
     int froxelGridZ = 160;
@@ -21,6 +22,17 @@ struct VolumetricConfig {
     // Near/far plane for froxel volume (in meters)
     float froxelNear = 0.5f;
     float froxelFar = 250.0f;
+
+    // View-space layout: replaces the world-aligned grid above with froxels
+    // that follow the view frustum, depth sliced linearly up to froxelNear
+    // and exponentially from there to froxelFar. Cells are small near the
+    // camera and large far away, and nothing is spent behind it. Always
+    // resolved through the pre-integrated lookup. Sizes the volumetric
+    // resources, which a hot reload reallocates.
+    bool viewSpaceFroxels = false;
+    int viewFroxelGridX = 160;
+    int viewFroxelGridY = 90;
+    int viewFroxelSlices = 64;
     
     // ========================================================================
     // FOG PARAMETERS
@@ -72,6 +84,9 @@ struct VolumetricConfig {
     float maxLightDistance = 320.0f;        // Maximum distance to consider lights (half froxel extent)
     float frustumMargin = 50.0f;            // Extra margin outside frustum to keep lights (meters)
     float nearCameraAlwaysKeep = 100.0f;    // Distance within which lights are always kept
+    float froxelCullMargin = 8.0f;          // Froxel bricks this far outside the frustum are still injected (meters)
+    float lightReselectDistance = 2.0f;     // Camera travel before volumetric lights are selected again (meters)
+    float lightReselectAngle = 2.0f;        // Camera rotation before volumetric lights are selected again (degrees)
     
     // ========================================================================
     // RAY MARCHING
@@ -82,9 +97,30 @@ struct VolumetricConfig {
     
     // Step size multiplier (1.0 = tight sampling, >1.0 = skip space)
     float stepSizeMultiplier = 1.0f;
-    
-    // Jitter amount for temporal anti-aliasing (0-1)
+
+    // Bricks whose sigma and light vary less than this (relative) are
+    // crossed in a single step instead of stepSizeMultiplier-sized ones
+    float raymarchSkipTolerance = 0.02f;
+    
+    // Scattering is marched at 1/N of the swapchain resolution (1-4)
+    // and upsampled with the depth buffer as guide, so building edges stay
+    // sharp. Sizes the volumetric resources, which a hot reload reallocates.
+    int scatteringResolutionDivisor = 2;
+
+    // Jitter of the first step along each ray, as a fraction of a step (0-1).
+    // Only applied while temporal history is accumulating.
     float jitterAmount = 1.0f;
+
+    // Pre-integrated mode: instead of marching every pixel, accumulate
+    // scattering front-to-back once per froxel of a view-space volume and
+    // look it up at each pixel's depth. Cost no longer depends on resolution
+    // or step count. Sizes the volumetric resources, which a hot reload
+    // reallocates.
+    bool preintegratedScattering = false;
+    int integrationGridX = 160;             // View-space froxels across the screen
+    int integrationGridY = 90;
+    int integrationSlices = 128;            // Exponentially distributed depth slices
+    float integrationDistance = 320.0f;     // Far end of the last slice (meters)
     
     // ========================================================================
     // TEMPORAL REPROJECTION
@@ -92,7 +128,11 @@ struct VolumetricConfig {
     // Blend factor for temporal history (0-1)
     // 0 = no history (all current frame), 1 = all history (no current)
     // Sweet spot usually 0.85-0.95
-    float temporalBlendAlpha = 0.0f;        // Currently disabled
+    float temporalBlendAlpha = 0.9f;
+
+    // While history is valid each frame marches raymarchSteps / this many
+    // jittered steps; 0 blend alpha marches the full count every frame
+    int temporalStepDivisor = 4;
     
     // ========================================================================
     // POST-PROCESSING / COMPOSITING
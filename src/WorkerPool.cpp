@@ -0,0 +1,70 @@
+#include "WorkerPool.hpp"
+
+namespace pcengine {
+
+WorkerPool::WorkerPool(unsigned threadCount) {
+    if (threadCount == 0) {
+        unsigned hw = std::thread::hardware_concurrency();
+        // Leave one core for the render thread
+        threadCount = hw > 1 ? hw - 1 : 1;
+    }
+
+    threads_.reserve(threadCount);
+    for (unsigned i = 0; i < threadCount; ++i) {
+        threads_.emplace_back([this]() { workerLoop(); });
+    }
+}
+
+WorkerPool::~WorkerPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    jobAvailable_.notify_all();
+    for (auto& thread : threads_) {
+        if (thread.joinable()) {
+            thread.join();
+        }
+    }
+}
+
+void WorkerPool::submit(std::function<void()> job) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        jobs_.push_back(std::move(job));
+    }
+    jobAvailable_.notify_one();
+}
+
+void WorkerPool::waitIdle() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    idle_.wait(lock, [this]() { return jobs_.empty() && busyCount_ == 0; });
+}
+
+void WorkerPool::workerLoop() {
+    for (;;) {
+        std::function<void()> job;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            jobAvailable_.wait(lock, [this]() { return stopping_ || !jobs_.empty(); });
+            if (stopping_ && jobs_.empty()) {
+                return;
+            }
+            job = std::move(jobs_.front());
+            jobs_.pop_front();
+            ++busyCount_;
+        }
+
+        job();
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            --busyCount_;
+            if (jobs_.empty() && busyCount_ == 0) {
+                idle_.notify_all();
+            }
+        }
+    }
+}
+
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace pcengine {
+
+// Fixed-size pool of worker threads for CPU-side jobs (chunk generation etc.).
+// Jobs are taken in FIFO order. The pool owns no job results - callers write
+// into their own storage and synchronise through waitIdle().
+class WorkerPool {
+public:
+    // threadCount == 0 picks hardware_concurrency() - 1 (at least one worker)
+    explicit WorkerPool(unsigned threadCount = 0);
+    ~WorkerPool();
+
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    void submit(std::function<void()> job);
+
+    // Block until every submitted job has finished
+    void waitIdle();
+
+    unsigned getThreadCount() const { return static_cast<unsigned>(threads_.size()); }
+
+private:
+    void workerLoop();
+
+    std::vector<std::thread> threads_;
+    std::deque<std::function<void()>> jobs_;
+    std::mutex mutex_;
+    std::condition_variable jobAvailable_;
+    std::condition_variable idle_;
+    size_t busyCount_ = 0;
+    bool stopping_ = false;
+};
+
+}